@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef BEMAN_INDIRECT_BENCH_HELPERS_HPP
+#define BEMAN_INDIRECT_BENCH_HELPERS_HPP
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+// Number of handles built or torn down per timed batch, and the length of the
+// handle vectors scanned by the dereference benchmarks.
+inline constexpr std::size_t batch_size = 1024;
+inline constexpr std::size_t scan_size  = 4096;
+
+// Trivially copyable value of exactly N bytes, so handle costs can be compared
+// across a range of pointee sizes.
+template <std::size_t N>
+struct Payload {
+    static_assert(N >= sizeof(std::uint64_t) && N % sizeof(std::uint64_t) == 0, "N must be a non-zero multiple of 8");
+
+    std::array<std::uint64_t, N / sizeof(std::uint64_t)> words{};
+
+    Payload() = default;
+    explicit Payload(std::uint64_t seed) {
+        for (auto& w : words)
+            w = seed++;
+    }
+
+    std::uint64_t first() const noexcept { return words[0]; }
+
+    friend bool operator==(const Payload& lhs, const Payload& rhs) noexcept { return lhs.words == rhs.words; }
+    friend bool operator!=(const Payload& lhs, const Payload& rhs) noexcept { return !(lhs == rhs); }
+};
+
+// --- Benchmarks ---
+// Each benchmark is a template over a storage kind: a struct exposing a `handle`
+// type plus static make/copy/assign/get (and equal/hash where the handle
+// supports them). See the *.bench.cpp files for the kinds themselves.
+
+template <class Kind>
+void BM_Construct(benchmark::State& state) {
+    std::vector<typename Kind::handle> v;
+    v.reserve(batch_size);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < batch_size; ++i)
+            v.push_back(Kind::make(i));
+        benchmark::ClobberMemory();
+        state.PauseTiming();
+        v.clear();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * batch_size);
+}
+
+template <class Kind>
+void BM_Destroy(benchmark::State& state) {
+    std::vector<typename Kind::handle> v;
+    v.reserve(batch_size);
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (std::size_t i = 0; i < batch_size; ++i)
+            v.push_back(Kind::make(i));
+        state.ResumeTiming();
+        v.clear();
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * batch_size);
+}
+
+template <class Kind>
+void BM_Copy(benchmark::State& state) {
+    const auto                         src = Kind::make(1);
+    std::vector<typename Kind::handle> v;
+    v.reserve(batch_size);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < batch_size; ++i)
+            v.push_back(Kind::copy(src));
+        benchmark::ClobberMemory();
+        state.PauseTiming();
+        v.clear();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * batch_size);
+}
+
+// One move-construction plus one move-assignment per iteration.
+template <class Kind>
+void BM_Move(benchmark::State& state) {
+    auto a = Kind::make(1);
+    for (auto _ : state) {
+        auto b(std::move(a));
+        benchmark::DoNotOptimize(b);
+        a = std::move(b);
+        benchmark::DoNotOptimize(a);
+    }
+}
+
+template <class Kind>
+void BM_CopyAssign(benchmark::State& state) {
+    const auto src = Kind::make(1);
+    auto       dst = Kind::make(2);
+    for (auto _ : state) {
+        Kind::assign(dst, src);
+        benchmark::DoNotOptimize(dst);
+    }
+}
+
+template <class Kind>
+void BM_Swap(benchmark::State& state) {
+    auto a = Kind::make(1);
+    auto b = Kind::make(2);
+    for (auto _ : state) {
+        using std::swap;
+        swap(a, b);
+        benchmark::DoNotOptimize(a);
+        benchmark::DoNotOptimize(b);
+    }
+}
+
+// Reads one field through each handle in a vector, the access pattern of a
+// container scan. Measures the cost of the extra load for boxed kinds.
+template <class Kind>
+void BM_Dereference(benchmark::State& state) {
+    std::vector<typename Kind::handle> v;
+    v.reserve(scan_size);
+    for (std::size_t i = 0; i < scan_size; ++i)
+        v.push_back(Kind::make(i));
+    for (auto _ : state) {
+        std::uint64_t sum = 0;
+        for (const auto& h : v)
+            sum += Kind::get(h).first();
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * scan_size);
+}
+
+// Compares equal values, so every word of the payload is visited.
+template <class Kind>
+void BM_Equal(benchmark::State& state) {
+    const auto a = Kind::make(1);
+    const auto b = Kind::make(1);
+    for (auto _ : state) {
+        bool eq = Kind::equal(a, b);
+        benchmark::DoNotOptimize(eq);
+    }
+}
+
+template <class Kind>
+void BM_Hash(benchmark::State& state) {
+    const auto h = Kind::make(1);
+    for (auto _ : state) {
+        std::size_t r = Kind::hash(h);
+        benchmark::DoNotOptimize(r);
+    }
+}
+
+} // namespace bench
+
+// Hashes every word, so the cost of hashing scales with N like a real key would.
+template <std::size_t N>
+struct std::hash<bench::Payload<N>> {
+    std::size_t operator()(const bench::Payload<N>& p) const noexcept {
+        std::size_t h = 0;
+        for (auto w : p.words)
+            h = h * 31 + static_cast<std::size_t>(w);
+        return h;
+    }
+};
+
+// Registers `bm` for `kind` over the full range of payload sizes.
+#define BEMAN_INDIRECT_BENCH_SIZES(bm, kind)           \
+    BENCHMARK_TEMPLATE(bm, kind<bench::Payload<8>>);   \
+    BENCHMARK_TEMPLATE(bm, kind<bench::Payload<64>>);  \
+    BENCHMARK_TEMPLATE(bm, kind<bench::Payload<256>>); \
+    BENCHMARK_TEMPLATE(bm, kind<bench::Payload<1024>>)
+
+#endif // BEMAN_INDIRECT_BENCH_HELPERS_HPP
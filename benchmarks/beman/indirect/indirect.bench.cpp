@@ -0,0 +1,135 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <beman/indirect/indirect.hpp>
+#include <beman/indirect/pool_allocator.hpp>
+#include <beman/indirect/relocate.hpp>
+
+#include "bench_helpers.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace {
+
+using beman::indirect::indirect;
+using bench::BM_Construct;
+using bench::BM_Destroy;
+using bench::BM_Copy;
+using bench::BM_Move;
+using bench::BM_CopyAssign;
+using bench::BM_Swap;
+using bench::BM_Dereference;
+using bench::BM_Equal;
+using bench::BM_Hash;
+using bench::scan_size;
+
+// --- Storage kinds ---
+// Each kind adapts one way of holding a T, so the benchmarks in bench_helpers.hpp
+// are written once and instantiated for indirect<T> (with the default and the pool
+// allocator), unique_ptr<T> and plain T.
+
+template <class T>
+struct by_value {
+    using handle = T;
+
+    static handle      make(std::uint64_t seed) { return T(seed); }
+    static handle      copy(const handle& h) { return h; }
+    static void        assign(handle& dst, const handle& src) { dst = src; }
+    static const T&    get(const handle& h) { return h; }
+    static bool        equal(const handle& lhs, const handle& rhs) { return lhs == rhs; }
+    static std::size_t hash(const handle& h) { return std::hash<T>{}(h); }
+};
+
+template <class T>
+struct by_unique_ptr {
+    using handle = std::unique_ptr<T>;
+
+    static handle      make(std::uint64_t seed) { return std::make_unique<T>(seed); }
+    static handle      copy(const handle& h) { return std::make_unique<T>(*h); }
+    static void        assign(handle& dst, const handle& src) { *dst = *src; }
+    static const T&    get(const handle& h) { return *h; }
+    static bool        equal(const handle& lhs, const handle& rhs) { return *lhs == *rhs; }
+    static std::size_t hash(const handle& h) { return std::hash<T>{}(*h); }
+};
+
+template <class T>
+struct by_indirect {
+    using handle = indirect<T>;
+
+    static handle      make(std::uint64_t seed) { return handle(std::in_place, seed); }
+    static handle      copy(const handle& h) { return h; }
+    static void        assign(handle& dst, const handle& src) { dst = src; }
+    static const T&    get(const handle& h) { return *h; }
+    static bool        equal(const handle& lhs, const handle& rhs) { return lhs == rhs; }
+    static std::size_t hash(const handle& h) { return std::hash<handle>{}(h); }
+};
+
+template <class T>
+struct by_pooled_indirect {
+    using handle = indirect<T, beman::indirect::indirect_pool_allocator<T>>;
+
+    static handle      make(std::uint64_t seed) { return handle(std::in_place, seed); }
+    static handle      copy(const handle& h) { return h; }
+    static void        assign(handle& dst, const handle& src) { dst = src; }
+    static const T&    get(const handle& h) { return *h; }
+    static bool        equal(const handle& lhs, const handle& rhs) { return lhs == rhs; }
+    static std::size_t hash(const handle& h) { return std::hash<handle>{}(h); }
+};
+
+// --- Relocation ---
+// Moves scan_size handles into fresh storage, as a vector does when it grows:
+// the element-wise move-and-destroy loop against the single memcpy that
+// uninitialized_relocate performs for trivially relocatable handles.
+
+template <class T, bool Relocate>
+void BM_Grow(benchmark::State& state) {
+    using handle = indirect<T>;
+    static_assert(beman::indirect::is_trivially_relocatable_v<handle>);
+
+    std::allocator<handle> alloc;
+    handle*                src = alloc.allocate(scan_size);
+    handle*                dst = alloc.allocate(scan_size);
+    for (std::size_t i = 0; i < scan_size; ++i)
+        ::new (static_cast<void*>(src + i)) handle(std::in_place, i);
+    for (auto _ : state) {
+        if constexpr (Relocate) {
+            beman::indirect::uninitialized_relocate(src, src + scan_size, dst);
+        } else {
+            std::uninitialized_move(src, src + scan_size, dst);
+            std::destroy(src, src + scan_size);
+        }
+        benchmark::ClobberMemory();
+        std::swap(src, dst);
+    }
+    std::destroy(src, src + scan_size);
+    alloc.deallocate(src, scan_size);
+    alloc.deallocate(dst, scan_size);
+    state.SetItemsProcessed(state.iterations() * scan_size);
+}
+
+BENCHMARK_TEMPLATE(BM_Grow, bench::Payload<64>, false);
+BENCHMARK_TEMPLATE(BM_Grow, bench::Payload<64>, true);
+
+#define BEMAN_INDIRECT_BENCH_KINDS(bm)                  \
+    BEMAN_INDIRECT_BENCH_SIZES(bm, by_indirect);        \
+    BEMAN_INDIRECT_BENCH_SIZES(bm, by_pooled_indirect); \
+    BEMAN_INDIRECT_BENCH_SIZES(bm, by_unique_ptr);      \
+    BEMAN_INDIRECT_BENCH_SIZES(bm, by_value)
+
+BEMAN_INDIRECT_BENCH_KINDS(BM_Construct);
+BEMAN_INDIRECT_BENCH_KINDS(BM_Destroy);
+BEMAN_INDIRECT_BENCH_KINDS(BM_Copy);
+BEMAN_INDIRECT_BENCH_KINDS(BM_Move);
+BEMAN_INDIRECT_BENCH_KINDS(BM_CopyAssign);
+BEMAN_INDIRECT_BENCH_KINDS(BM_Swap);
+BEMAN_INDIRECT_BENCH_KINDS(BM_Dereference);
+BEMAN_INDIRECT_BENCH_KINDS(BM_Equal);
+BEMAN_INDIRECT_BENCH_KINDS(BM_Hash);
+
+} // namespace
@@ -0,0 +1,254 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <beman/indirect/for_each_grouped.hpp>
+#include <beman/indirect/polymorphic.hpp>
+#include <beman/indirect/polymorphic_collection.hpp>
+#include <beman/indirect/polymorphic_pool_resource.hpp>
+#include <beman/indirect/sealed_polymorphic.hpp>
+
+#include "bench_helpers.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using beman::indirect::polymorphic;
+using bench::BM_Construct;
+using bench::BM_Destroy;
+using bench::BM_Copy;
+using bench::BM_Move;
+using bench::BM_CopyAssign;
+using bench::BM_Swap;
+using bench::BM_Dereference;
+
+// Hierarchy with a hand-written clone(), the usual way of deep-copying through
+// a unique_ptr<Base>.
+struct Base {
+    virtual ~Base()                             = default;
+    virtual std::uint64_t         first() const = 0;
+    virtual std::unique_ptr<Base> clone() const = 0;
+    Base()                                      = default;
+    Base(const Base&)                           = default;
+    Base(Base&&)                                = default;
+    Base& operator=(const Base&)                = default;
+    Base& operator=(Base&&)                     = default;
+};
+
+template <class P>
+struct Derived final : Base {
+    P payload;
+    explicit Derived(std::uint64_t seed) : payload(seed) {}
+    std::uint64_t         first() const override { return payload.first(); }
+    std::unique_ptr<Base> clone() const override { return std::make_unique<Derived>(*this); }
+};
+
+// --- Storage kinds ---
+// polymorphic<Base> is compared against unique_ptr<Base> with virtual clone(),
+// and against storing the final Derived<P> by value (no type erasure at all).
+// polymorphic provides neither operator== nor std::hash, so only the
+// lifetime, assignment and dereference benchmarks are registered here.
+
+template <class P>
+struct by_derived_value {
+    using handle = Derived<P>;
+
+    static handle      make(std::uint64_t seed) { return handle(seed); }
+    static handle      copy(const handle& h) { return h; }
+    static void        assign(handle& dst, const handle& src) { dst = src; }
+    static const Base& get(const handle& h) { return h; }
+};
+
+template <class P>
+struct by_base_unique_ptr {
+    using handle = std::unique_ptr<Base>;
+
+    static handle      make(std::uint64_t seed) { return std::make_unique<Derived<P>>(seed); }
+    static handle      copy(const handle& h) { return h->clone(); }
+    static void        assign(handle& dst, const handle& src) { dst = src->clone(); }
+    static const Base& get(const handle& h) { return *h; }
+};
+
+template <class P>
+struct by_polymorphic {
+    using handle = polymorphic<Base>;
+
+    static handle      make(std::uint64_t seed) { return handle(std::in_place_type<Derived<P>>, seed); }
+    static handle      copy(const handle& h) { return h; }
+    static void        assign(handle& dst, const handle& src) { dst = src; }
+    static const Base& get(const handle& h) { return *h; }
+};
+
+// pmr::polymorphic<Base> over a polymorphic_pool_resource. Copies are
+// allocator-extended so that they stay in the pool: pmr allocators do not
+// propagate on copy construction.
+beman::indirect::polymorphic_pool_resource pool_resource;
+
+template <class P>
+struct by_pooled_polymorphic {
+    using handle = beman::indirect::pmr::polymorphic<Base>;
+
+    static handle make(std::uint64_t seed) {
+        return handle(std::allocator_arg, &pool_resource, std::in_place_type<Derived<P>>, seed);
+    }
+    static handle      copy(const handle& h) { return handle(std::allocator_arg, h.get_allocator(), h); }
+    static void        assign(handle& dst, const handle& src) { dst = src; }
+    static const Base& get(const handle& h) { return *h; }
+};
+
+// Second alternative of by_sealed_polymorphic's closed set.
+struct Other final : Base {
+    std::uint64_t         first() const override { return 0; }
+    std::unique_ptr<Base> clone() const override { return std::make_unique<Other>(*this); }
+};
+
+// sealed_polymorphic over a closed set that includes Derived<P>; the object
+// lives inside the handle.
+template <class P>
+struct by_sealed_polymorphic {
+    using handle = beman::indirect::sealed_polymorphic<Base, Other, Derived<P>>;
+
+    static handle      make(std::uint64_t seed) { return handle(std::in_place_type<Derived<P>>, seed); }
+    static handle      copy(const handle& h) { return h; }
+    static void        assign(handle& dst, const handle& src) { dst = src; }
+    static const Base& get(const handle& h) { return *h; }
+};
+
+#define BEMAN_INDIRECT_BENCH_KINDS(bm)                     \
+    BEMAN_INDIRECT_BENCH_SIZES(bm, by_polymorphic);        \
+    BEMAN_INDIRECT_BENCH_SIZES(bm, by_pooled_polymorphic); \
+    BEMAN_INDIRECT_BENCH_SIZES(bm, by_sealed_polymorphic); \
+    BEMAN_INDIRECT_BENCH_SIZES(bm, by_base_unique_ptr);    \
+    BEMAN_INDIRECT_BENCH_SIZES(bm, by_derived_value)
+
+BEMAN_INDIRECT_BENCH_KINDS(BM_Construct);
+BEMAN_INDIRECT_BENCH_KINDS(BM_Destroy);
+BEMAN_INDIRECT_BENCH_KINDS(BM_Copy);
+BEMAN_INDIRECT_BENCH_KINDS(BM_Move);
+BEMAN_INDIRECT_BENCH_KINDS(BM_CopyAssign);
+BEMAN_INDIRECT_BENCH_KINDS(BM_Swap);
+BEMAN_INDIRECT_BENCH_KINDS(BM_Dereference);
+
+// --- Downcast ---
+// A dispatch loop over mixed dynamic types that picks out one of them:
+// dynamic_cast through operator-> against get_if, which compares type tags.
+
+using Small = Derived<bench::Payload<8>>;
+using Large = Derived<bench::Payload<64>>;
+
+// Whether the i-th object of a mixed sequence is a Small: an irregular
+// pattern, so that branch predictors cannot learn the sequence of types.
+bool is_small(std::size_t i) {
+    return ((i * 2654435761u) >> 7) % 2 == 0;
+}
+
+std::vector<polymorphic<Base>> mixed_handles() {
+    std::vector<polymorphic<Base>> v;
+    v.reserve(bench::scan_size);
+    for (std::size_t i = 0; i < bench::scan_size; ++i) {
+        if (is_small(i))
+            v.emplace_back(std::in_place_type<Small>, i);
+        else
+            v.emplace_back(std::in_place_type<Large>, i);
+    }
+    return v;
+}
+
+void BM_DowncastDynamicCast(benchmark::State& state) {
+    const auto v = mixed_handles();
+    for (auto _ : state) {
+        std::uint64_t sum = 0;
+        for (const auto& h : v) {
+            if (const auto* d = dynamic_cast<const Large*>(h.operator->()))
+                sum += d->payload.first();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * bench::scan_size);
+}
+
+void BM_DowncastGetIf(benchmark::State& state) {
+    const auto v = mixed_handles();
+    for (auto _ : state) {
+        std::uint64_t sum = 0;
+        for (const auto& h : v) {
+            if (const auto* d = h.get_if<Large>())
+                sum += d->payload.first();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * bench::scan_size);
+}
+
+BENCHMARK(BM_DowncastDynamicCast);
+BENCHMARK(BM_DowncastGetIf);
+
+// --- Iteration over mixed types ---
+// The handles from mixed_handles() against the same objects grouped by type
+// in a polymorphic_collection, reached as Base& and as their concrete types.
+
+beman::indirect::polymorphic_collection<Base> mixed_collection() {
+    beman::indirect::polymorphic_collection<Base> c;
+    for (std::size_t i = 0; i < bench::scan_size; ++i) {
+        if (is_small(i))
+            c.emplace<Small>(i);
+        else
+            c.emplace<Large>(i);
+    }
+    return c;
+}
+
+void BM_IterateVector(benchmark::State& state) {
+    const auto v = mixed_handles();
+    for (auto _ : state) {
+        std::uint64_t sum = 0;
+        for (const auto& h : v)
+            sum += h->first();
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * bench::scan_size);
+}
+
+void BM_IterateCollection(benchmark::State& state) {
+    const auto c = mixed_collection();
+    for (auto _ : state) {
+        std::uint64_t sum = 0;
+        c.for_each([&](const Base& b) { sum += b.first(); });
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * bench::scan_size);
+}
+
+void BM_IterateCollectionByType(benchmark::State& state) {
+    const auto c = mixed_collection();
+    for (auto _ : state) {
+        std::uint64_t sum = 0;
+        c.for_each<Small>([&](const Small& d) { sum += d.first(); });
+        c.for_each<Large>([&](const Large& d) { sum += d.first(); });
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * bench::scan_size);
+}
+
+// The same handles as BM_IterateVector, bucketed by type on every pass.
+void BM_IterateVectorGrouped(benchmark::State& state) {
+    const auto v = mixed_handles();
+    for (auto _ : state) {
+        std::uint64_t sum = 0;
+        beman::indirect::for_each_grouped<Small, Large>(v, [&](const auto& d) { sum += d.first(); });
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * bench::scan_size);
+}
+
+BENCHMARK(BM_IterateVector);
+BENCHMARK(BM_IterateVectorGrouped);
+BENCHMARK(BM_IterateCollection);
+BENCHMARK(BM_IterateCollectionByType);
+
+} // namespace
@@ -47,23 +47,6 @@ int main() { S s; }
     set(${result_var} ${HAVE_CONSTEXPR_DTOR} PARENT_SCOPE)
 endfunction()
 
-function(beman_indirect_check_constexpr_virtual result_var)
-    check_cxx_source_compiles(
-        "
-struct B {
-    constexpr virtual int f() const = 0;
-    virtual ~B() = default;
-};
-struct D : B {
-    constexpr int f() const override { return 42; }
-};
-int main() {}
-"
-        HAVE_CONSTEXPR_VIRTUAL
-    )
-    set(${result_var} ${HAVE_CONSTEXPR_VIRTUAL} PARENT_SCOPE)
-endfunction()
-
 # End-to-end check: can polymorphic types actually be used in constexpr
 # contexts? GCC 11/12 accept the syntax but fail constexpr evaluation
 # of std::destroy_at on types with virtual destructors.
@@ -108,3 +91,18 @@ int main() {}
     )
     set(${result_var} ${HAVE_NO_UNIQUE_ADDRESS} PARENT_SCOPE)
 endfunction()
+
+# USDT probes need systemtap's <sys/sdt.h> (systemtap-sdt-dev or
+# systemtap-sdt-devel); it is header-only.
+function(beman_indirect_check_sdt result_var)
+    check_cxx_source_compiles(
+        "
+#include <sys/sdt.h>
+int main() {
+    DTRACE_PROBE2(beman_indirect, check, 1, 2);
+}
+"
+        HAVE_SYS_SDT_H
+    )
+    set(${result_var} ${HAVE_SYS_SDT_H} PARENT_SCOPE)
+endfunction()
@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef BEMAN_INDIRECT_ARENA_HPP
+#define BEMAN_INDIRECT_ARENA_HPP
+
+#include <cstddef>
+#include <limits>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+
+namespace beman::indirect {
+
+// Arena mode.
+//
+// An arena allocator never gives memory back one object at a time: its
+// deallocate is a no-op and the whole arena is released at once. Allocators
+// declare this by specializing is_arena_allocator; arena_allocator below is
+// the library's own.
+//
+// An arena-discardable type owns nothing outside the arena it lives in, so
+// its destructor may be skipped. Trivially destructible types qualify; other
+// types, typically the nodes of a tree whose children are held by
+// indirect<Node, arena_allocator<Node>>, opt in by specializing
+// is_arena_discardable.
+//
+// indirect and polymorphic with an arena allocator and a discardable T do
+// nothing at all on destruction, so a tree built in an arena can be torn down
+// in O(1) by releasing the arena. Its handles must then not be used again,
+// other than being destroyed.
+template <class Allocator>
+struct is_arena_allocator : std::false_type {};
+
+template <class Allocator>
+inline constexpr bool is_arena_allocator_v = is_arena_allocator<Allocator>::value;
+
+template <class T>
+struct is_arena_discardable : std::is_trivially_destructible<T> {};
+
+template <class T>
+inline constexpr bool is_arena_discardable_v = is_arena_discardable<T>::value;
+
+// Allocator over a std::pmr::monotonic_buffer_resource.
+//
+// allocate carves memory from the resource and deallocate does nothing; the
+// memory comes back when the resource is released or destroyed. destroy
+// skips the destructor of arena-discardable types.
+template <class T>
+class arena_allocator {
+  public:
+    using value_type = T;
+
+    // Implicit, like std::pmr::polymorphic_allocator's constructor from a resource.
+    arena_allocator(std::pmr::monotonic_buffer_resource* r) noexcept : r_(r) {}
+
+    template <class U>
+    arena_allocator(const arena_allocator<U>& other) noexcept : r_(other.resource()) {}
+
+    T* allocate(std::size_t n) {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+            throw std::bad_array_new_length();
+        return static_cast<T*>(r_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, std::size_t) noexcept {}
+
+    template <class U>
+    void destroy(U* p) noexcept {
+        if constexpr (!is_arena_discardable_v<U>)
+            p->~U();
+    }
+
+    std::pmr::monotonic_buffer_resource* resource() const noexcept { return r_; }
+
+    template <class U>
+    friend bool operator==(const arena_allocator& lhs, const arena_allocator<U>& rhs) noexcept {
+        return lhs.resource() == rhs.resource();
+    }
+
+    template <class U>
+    friend bool operator!=(const arena_allocator& lhs, const arena_allocator<U>& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+
+  private:
+    std::pmr::monotonic_buffer_resource* r_;
+};
+
+template <class T>
+struct is_arena_allocator<arena_allocator<T>> : std::true_type {};
+
+} // namespace beman::indirect
+
+#endif // BEMAN_INDIRECT_ARENA_HPP
@@ -0,0 +1,512 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef BEMAN_INDIRECT_COMPACT_INDIRECT_HPP
+#define BEMAN_INDIRECT_COMPACT_INDIRECT_HPP
+
+#include <beman/indirect/detail/compact_block.hpp>
+#include <beman/indirect/detail/config.hpp>
+#include <beman/indirect/detail/synth_three_way.hpp>
+#include <beman/indirect/relocate.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace beman::indirect::pmr {
+
+template <class T>
+class compact_indirect;
+
+} // namespace beman::indirect::pmr
+
+namespace beman::indirect::detail {
+
+template <class>
+inline constexpr bool is_compact_indirect_v = false;
+
+template <class T>
+inline constexpr bool is_compact_indirect_v<pmr::compact_indirect<T>> = true;
+
+template <class T>
+struct compact_indirect_block : compact_block_base {
+    union {
+        T value;
+    };
+
+    explicit compact_indirect_block(std::pmr::memory_resource* r) noexcept : compact_block_base(r) {}
+    ~compact_indirect_block() {}
+};
+
+} // namespace beman::indirect::detail
+
+namespace beman::indirect::pmr {
+
+// compact_indirect: pmr::indirect<T> in one pointer.
+//
+// pmr::indirect<T> holds its polymorphic_allocator next to the pointer to its
+// value, which makes the handle two words. compact_indirect instead puts the
+// memory resource pointer in front of the value, in the same allocation, and
+// get_allocator() reads it back from there; a moved-from handle keeps its
+// resource in the handle itself. The handle is the size of a pointer, at the
+// cost of one more word per allocation and of constant evaluation support.
+//
+// Otherwise compact_indirect behaves as pmr::indirect<T>: values are
+// constructed uses-allocator with the handle's resource, copies use the
+// default resource, and the resource never propagates on assignment. A handle
+// move-constructed with an equal resource takes over the block, which keeps
+// recording the resource it was allocated from.
+template <class T>
+class compact_indirect {
+    static_assert(std::is_object_v<T>, "T must be an object type");
+    static_assert(!std::is_array_v<T>, "T must not be an array type");
+    static_assert(!std::is_const_v<T> && !std::is_volatile_v<T>, "T must not be cv-qualified");
+
+    using block_type = detail::compact_indirect_block<T>;
+
+  public:
+    using value_type     = T;
+    using allocator_type = std::pmr::polymorphic_allocator<T>;
+    using pointer        = T*;
+    using const_pointer  = const T*;
+
+    // constructors
+
+    explicit compact_indirect() : compact_indirect(std::allocator_arg, allocator_type()) {}
+
+    explicit compact_indirect(std::allocator_arg_t, const allocator_type& a) : word_(a.resource()) {
+        static_assert(std::is_default_constructible_v<T>);
+        word_.set_block(make(a.resource()));
+    }
+
+    compact_indirect(const compact_indirect& other)
+        : compact_indirect(std::allocator_arg,
+                           std::allocator_traits<allocator_type>::select_on_container_copy_construction(
+                               other.get_allocator()),
+                           other) {}
+
+    compact_indirect(std::allocator_arg_t, const allocator_type& a, const compact_indirect& other)
+        : word_(a.resource()) {
+        static_assert(std::is_copy_constructible_v<T>);
+        if (!other.valueless_after_move())
+            word_.set_block(make(a.resource(), *other));
+    }
+
+    compact_indirect(compact_indirect&& other) noexcept : word_(other.word_) {
+        other.word_.set_valueless(word_.resource());
+    }
+
+    compact_indirect(std::allocator_arg_t, const allocator_type& a, compact_indirect&& other) : word_(a.resource()) {
+        if (other.valueless_after_move()) {
+            // *this is valueless
+        } else if (*a.resource() == *other.word_.resource()) {
+            word_.steal(other.word_);
+        } else {
+            word_.set_block(make(a.resource(), std::move(*other)));
+            other.reset();
+        }
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U = T>
+        requires(!std::is_same_v<detail::remove_cvref_t<U>, compact_indirect> &&
+                 !std::is_same_v<detail::remove_cvref_t<U>, std::in_place_t> && std::is_constructible_v<T, U>)
+#else
+    template <class U               = T,
+              std::enable_if_t<!std::is_same_v<detail::remove_cvref_t<U>, compact_indirect> &&
+                                   !std::is_same_v<detail::remove_cvref_t<U>, std::in_place_t> &&
+                                   std::is_constructible_v<T, U>,
+                               int> = 0>
+#endif
+    explicit compact_indirect(U&& u) : compact_indirect(std::allocator_arg, allocator_type(), std::forward<U>(u)) {
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U = T>
+        requires(!std::is_same_v<detail::remove_cvref_t<U>, compact_indirect> &&
+                 !std::is_same_v<detail::remove_cvref_t<U>, std::in_place_t> && std::is_constructible_v<T, U>)
+#else
+    template <class U               = T,
+              std::enable_if_t<!std::is_same_v<detail::remove_cvref_t<U>, compact_indirect> &&
+                                   !std::is_same_v<detail::remove_cvref_t<U>, std::in_place_t> &&
+                                   std::is_constructible_v<T, U>,
+                               int> = 0>
+#endif
+    explicit compact_indirect(std::allocator_arg_t, const allocator_type& a, U&& u) : word_(a.resource()) {
+        word_.set_block(make(a.resource(), std::forward<U>(u)));
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class... Us>
+        requires std::is_constructible_v<T, Us...>
+#else
+    template <class... Us, std::enable_if_t<std::is_constructible_v<T, Us...>, int> = 0>
+#endif
+    explicit compact_indirect(std::in_place_t, Us&&... us)
+        : compact_indirect(std::allocator_arg, allocator_type(), std::in_place, std::forward<Us>(us)...) {
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class... Us>
+        requires std::is_constructible_v<T, Us...>
+#else
+    template <class... Us, std::enable_if_t<std::is_constructible_v<T, Us...>, int> = 0>
+#endif
+    explicit compact_indirect(std::allocator_arg_t, const allocator_type& a, std::in_place_t, Us&&... us)
+        : word_(a.resource()) {
+        word_.set_block(make(a.resource(), std::forward<Us>(us)...));
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class I, class... Us>
+        requires std::is_constructible_v<T, std::initializer_list<I>&, Us...>
+#else
+    template <class I,
+              class... Us,
+              std::enable_if_t<std::is_constructible_v<T, std::initializer_list<I>&, Us...>, int> = 0>
+#endif
+    explicit compact_indirect(std::in_place_t, std::initializer_list<I> ilist, Us&&... us)
+        : compact_indirect(std::allocator_arg, allocator_type(), std::in_place, ilist, std::forward<Us>(us)...) {
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class I, class... Us>
+        requires std::is_constructible_v<T, std::initializer_list<I>&, Us...>
+#else
+    template <class I,
+              class... Us,
+              std::enable_if_t<std::is_constructible_v<T, std::initializer_list<I>&, Us...>, int> = 0>
+#endif
+    explicit compact_indirect(
+        std::allocator_arg_t, const allocator_type& a, std::in_place_t, std::initializer_list<I> ilist, Us&&... us)
+        : word_(a.resource()) {
+        word_.set_block(make(a.resource(), ilist, std::forward<Us>(us)...));
+    }
+
+    // destructor
+
+    ~compact_indirect() {
+        static_assert(detail::is_complete_v<T>);
+        if (!valueless_after_move())
+            destroy(block());
+    }
+
+    // assignment
+
+    compact_indirect& operator=(const compact_indirect& other) {
+        static_assert(std::is_copy_assignable_v<T>);
+        static_assert(std::is_copy_constructible_v<T>);
+        if (std::addressof(other) == this)
+            return *this;
+
+        if (other.valueless_after_move()) {
+            reset();
+        } else if (!valueless_after_move()) {
+            **this = *other;
+        } else {
+            word_.set_block(make(word_.resource(), *other));
+        }
+        return *this;
+    }
+
+    compact_indirect& operator=(compact_indirect&& other) {
+        static_assert(std::is_move_constructible_v<T>, "T must be move constructible when resources may differ");
+        if (std::addressof(other) == this)
+            return *this;
+
+        std::pmr::memory_resource* r = word_.resource();
+        if (other.valueless_after_move()) {
+            reset();
+        } else if (*r == *other.word_.resource()) {
+            reset();
+            word_.steal(other.word_);
+        } else {
+            // Resources differ and don't propagate: must move-construct
+            block_type* b = make(r, std::move(*other));
+            reset();
+            word_.set_block(b);
+            other.reset();
+        }
+        return *this;
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U = T>
+        requires(!std::is_same_v<detail::remove_cvref_t<U>, compact_indirect> && std::is_constructible_v<T, U> &&
+                 std::is_assignable_v<T&, U>)
+#else
+    template <class U = T,
+              std::enable_if_t<!std::is_same_v<detail::remove_cvref_t<U>, compact_indirect> &&
+                                   std::is_constructible_v<T, U> && std::is_assignable_v<T&, U>,
+                               int> = 0>
+#endif
+    compact_indirect& operator=(U&& u) {
+        if (valueless_after_move()) {
+            word_.set_block(make(word_.resource(), std::forward<U>(u)));
+        } else {
+            **this = std::forward<U>(u);
+        }
+        return *this;
+    }
+
+    // observers
+
+    const T& operator*() const& noexcept {
+        assert(!valueless_after_move());
+        return block()->value;
+    }
+
+    T& operator*() & noexcept {
+        assert(!valueless_after_move());
+        return block()->value;
+    }
+
+    const T&& operator*() const&& noexcept {
+        assert(!valueless_after_move());
+        return std::move(block()->value);
+    }
+
+    T&& operator*() && noexcept {
+        assert(!valueless_after_move());
+        return std::move(block()->value);
+    }
+
+    const_pointer operator->() const noexcept {
+        assert(!valueless_after_move());
+        return std::addressof(block()->value);
+    }
+
+    pointer operator->() noexcept {
+        assert(!valueless_after_move());
+        return std::addressof(block()->value);
+    }
+
+    bool valueless_after_move() const noexcept { return word_.valueless(); }
+
+    allocator_type get_allocator() const noexcept { return allocator_type(word_.resource()); }
+
+    // swap
+
+    void swap(compact_indirect& other) noexcept {
+        // Precondition: resources must be equal, as they don't propagate on swap.
+        assert(*word_.resource() == *other.word_.resource());
+        word_.swap(other.word_);
+    }
+
+    friend void swap(compact_indirect& lhs, compact_indirect& rhs) noexcept { lhs.swap(rhs); }
+
+    // relational operators
+
+    template <class U>
+    friend bool operator==(const compact_indirect&    lhs,
+                           const compact_indirect<U>& rhs) noexcept(noexcept(*lhs == *rhs)) {
+        if (lhs.valueless_after_move() || rhs.valueless_after_move())
+            return lhs.valueless_after_move() == rhs.valueless_after_move();
+        return *lhs == *rhs;
+    }
+
+#if BEMAN_INDIRECT_USE_THREE_WAY_COMPARISON
+    template <class U>
+    friend auto operator<=>(const compact_indirect& lhs, const compact_indirect<U>& rhs)
+        -> detail::synth_three_way_result<T, U> {
+        if (lhs.valueless_after_move() || rhs.valueless_after_move())
+            return !lhs.valueless_after_move() <=> !rhs.valueless_after_move();
+        return detail::synth_three_way(*lhs, *rhs);
+    }
+#else
+    template <class U>
+    friend bool operator!=(const compact_indirect&    lhs,
+                           const compact_indirect<U>& rhs) noexcept(noexcept(lhs == rhs)) {
+        return !(lhs == rhs);
+    }
+
+    template <class U>
+    friend bool operator<(const compact_indirect& lhs, const compact_indirect<U>& rhs) {
+        if (lhs.valueless_after_move() || rhs.valueless_after_move())
+            return !lhs.valueless_after_move() < !rhs.valueless_after_move();
+        return *lhs < *rhs;
+    }
+
+    template <class U>
+    friend bool operator>(const compact_indirect& lhs, const compact_indirect<U>& rhs) {
+        return rhs < lhs;
+    }
+
+    template <class U>
+    friend bool operator<=(const compact_indirect& lhs, const compact_indirect<U>& rhs) {
+        return !(rhs < lhs);
+    }
+
+    template <class U>
+    friend bool operator>=(const compact_indirect& lhs, const compact_indirect<U>& rhs) {
+        return !(lhs < rhs);
+    }
+#endif // BEMAN_INDIRECT_USE_THREE_WAY_COMPARISON
+
+    // comparison with T
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U>
+        requires(!detail::is_compact_indirect_v<U>)
+    friend bool operator==(const compact_indirect& lhs, const U& rhs) noexcept(noexcept(*lhs == rhs)) {
+        if (lhs.valueless_after_move())
+            return false;
+        return *lhs == rhs;
+    }
+#else
+    template <class U, std::enable_if_t<!detail::is_compact_indirect_v<U>, int> = 0>
+    friend bool operator==(const compact_indirect& lhs, const U& rhs) noexcept(noexcept(*lhs == rhs)) {
+        if (lhs.valueless_after_move())
+            return false;
+        return *lhs == rhs;
+    }
+
+    template <class U, std::enable_if_t<!detail::is_compact_indirect_v<U>, int> = 0>
+    friend bool operator==(const U& lhs, const compact_indirect& rhs) noexcept(noexcept(rhs == lhs)) {
+        return rhs == lhs;
+    }
+
+    template <class U, std::enable_if_t<!detail::is_compact_indirect_v<U>, int> = 0>
+    friend bool operator!=(const compact_indirect& lhs, const U& rhs) noexcept(noexcept(lhs == rhs)) {
+        return !(lhs == rhs);
+    }
+
+    template <class U, std::enable_if_t<!detail::is_compact_indirect_v<U>, int> = 0>
+    friend bool operator!=(const U& lhs, const compact_indirect& rhs) noexcept(noexcept(rhs == lhs)) {
+        return !(rhs == lhs);
+    }
+
+    template <class U, std::enable_if_t<!detail::is_compact_indirect_v<U>, int> = 0>
+    friend bool operator<(const compact_indirect& lhs, const U& rhs) {
+        if (lhs.valueless_after_move())
+            return true;
+        return *lhs < rhs;
+    }
+
+    template <class U, std::enable_if_t<!detail::is_compact_indirect_v<U>, int> = 0>
+    friend bool operator<(const U& lhs, const compact_indirect& rhs) {
+        return rhs > lhs;
+    }
+
+    template <class U, std::enable_if_t<!detail::is_compact_indirect_v<U>, int> = 0>
+    friend bool operator>(const compact_indirect& lhs, const U& rhs) {
+        if (lhs.valueless_after_move())
+            return false;
+        return *lhs > rhs;
+    }
+
+    template <class U, std::enable_if_t<!detail::is_compact_indirect_v<U>, int> = 0>
+    friend bool operator>(const U& lhs, const compact_indirect& rhs) {
+        return rhs < lhs;
+    }
+
+    template <class U, std::enable_if_t<!detail::is_compact_indirect_v<U>, int> = 0>
+    friend bool operator<=(const compact_indirect& lhs, const U& rhs) {
+        return !(lhs > rhs);
+    }
+
+    template <class U, std::enable_if_t<!detail::is_compact_indirect_v<U>, int> = 0>
+    friend bool operator<=(const U& lhs, const compact_indirect& rhs) {
+        return !(lhs > rhs);
+    }
+
+    template <class U, std::enable_if_t<!detail::is_compact_indirect_v<U>, int> = 0>
+    friend bool operator>=(const compact_indirect& lhs, const U& rhs) {
+        return !(lhs < rhs);
+    }
+
+    template <class U, std::enable_if_t<!detail::is_compact_indirect_v<U>, int> = 0>
+    friend bool operator>=(const U& lhs, const compact_indirect& rhs) {
+        return !(lhs < rhs);
+    }
+#endif // BEMAN_INDIRECT_USE_CONCEPTS
+
+#if BEMAN_INDIRECT_USE_THREE_WAY_COMPARISON
+    #if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U>
+        requires(!detail::is_compact_indirect_v<U>)
+    #else
+    template <class U, std::enable_if_t<!detail::is_compact_indirect_v<U>, int> = 0>
+    #endif // BEMAN_INDIRECT_USE_CONCEPTS
+    friend auto operator<=>(const compact_indirect& lhs, const U& rhs) {
+        if (lhs.valueless_after_move())
+            return detail::synth_three_way_result<T, U>(std::strong_ordering::less);
+        return detail::synth_three_way(*lhs, rhs);
+    }
+#endif // BEMAN_INDIRECT_USE_THREE_WAY_COMPARISON
+
+  private:
+    template <class... Args>
+    static block_type* make(std::pmr::memory_resource* r, Args&&... args) {
+        void*       raw = r->allocate(sizeof(block_type), alignof(block_type));
+        block_type* b   = ::new (raw) block_type(r);
+        try {
+            allocator_type(r).construct(std::addressof(b->value), std::forward<Args>(args)...);
+        } catch (...) {
+            r->deallocate(raw, sizeof(block_type), alignof(block_type));
+            throw;
+        }
+        return b;
+    }
+
+    static void destroy(block_type* b) noexcept {
+        std::pmr::memory_resource* r = b->resource;
+        b->value.~T();
+        b->~block_type();
+        r->deallocate(b, sizeof(block_type), alignof(block_type));
+    }
+
+    block_type* block() const noexcept { return static_cast<block_type*>(word_.block()); }
+
+    void reset() noexcept {
+        if (!valueless_after_move()) {
+            std::pmr::memory_resource* r = word_.resource();
+            destroy(block());
+            word_.set_valueless(r);
+        }
+    }
+
+    detail::compact_word word_;
+};
+
+} // namespace beman::indirect::pmr
+
+namespace beman::indirect {
+
+// The handle is a single integer; its block never refers back to it.
+template <class T>
+struct is_trivially_relocatable<pmr::compact_indirect<T>> : std::true_type {};
+
+} // namespace beman::indirect
+
+// Hash support
+#if BEMAN_INDIRECT_USE_CONCEPTS
+template <class T>
+    requires std::is_default_constructible_v<std::hash<T>>
+struct std::hash<beman::indirect::pmr::compact_indirect<T>> {
+    std::size_t operator()(const beman::indirect::pmr::compact_indirect<T>& i) const
+        noexcept(noexcept(std::hash<T>{}(*i))) {
+        if (i.valueless_after_move())
+            return static_cast<std::size_t>(-1);
+        return std::hash<T>{}(*i);
+    }
+};
+#else
+template <class T>
+struct std::hash<beman::indirect::pmr::compact_indirect<T>> {
+    template <class U = T, std::enable_if_t<std::is_default_constructible_v<std::hash<U>>, int> = 0>
+    std::size_t operator()(const beman::indirect::pmr::compact_indirect<T>& i) const
+        noexcept(noexcept(std::hash<T>{}(*i))) {
+        if (i.valueless_after_move())
+            return static_cast<std::size_t>(-1);
+        return std::hash<T>{}(*i);
+    }
+};
+#endif
+
+#endif // BEMAN_INDIRECT_COMPACT_INDIRECT_HPP
@@ -0,0 +1,341 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef BEMAN_INDIRECT_COMPACT_POLYMORPHIC_HPP
+#define BEMAN_INDIRECT_COMPACT_POLYMORPHIC_HPP
+
+#include <beman/indirect/detail/compact_block.hpp>
+#include <beman/indirect/detail/config.hpp>
+#include <beman/indirect/polymorphic.hpp>
+#include <beman/indirect/relocate.hpp>
+
+#include <cassert>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace beman::indirect::detail {
+
+template <class T>
+struct compact_poly_header;
+
+// Dispatch table for the dynamic type of a compact_polymorphic's object, the
+// counterpart of control_block_ops.
+template <class T>
+struct compact_poly_ops {
+    compact_poly_header<T>* (*clone)(const compact_poly_header<T>& src, std::pmr::memory_resource* r);
+    compact_poly_header<T>* (*move_clone)(compact_poly_header<T>& src, std::pmr::memory_resource* r);
+    void (*destroy)(compact_poly_header<T>* block) noexcept;
+};
+
+// What a compact_polymorphic reaches through its one word: the resource, the
+// dispatch table and the object as a T, which may not be at a fixed offset.
+template <class T>
+struct compact_poly_header : compact_block_base {
+    const compact_poly_ops<T>* ops;
+    T*                         object = nullptr;
+
+    compact_poly_header(std::pmr::memory_resource* r, const compact_poly_ops<T>* o) noexcept
+        : compact_block_base(r), ops(o) {}
+};
+
+template <class T, class U>
+struct compact_poly_block : compact_poly_header<T> {
+    union {
+        U value;
+    };
+
+    explicit compact_poly_block(std::pmr::memory_resource* r) noexcept;
+    ~compact_poly_block() {}
+};
+
+template <class T, class U>
+struct compact_poly_model {
+    using block_type = compact_poly_block<T, U>;
+
+    template <class... Args>
+    static compact_poly_header<T>* make(std::pmr::memory_resource* r, Args&&... args) {
+        void*       raw = r->allocate(sizeof(block_type), alignof(block_type));
+        block_type* b   = ::new (raw) block_type(r);
+        try {
+            std::pmr::polymorphic_allocator<U>(r).construct(std::addressof(b->value), std::forward<Args>(args)...);
+        } catch (...) {
+            r->deallocate(raw, sizeof(block_type), alignof(block_type));
+            throw;
+        }
+        b->object = std::addressof(b->value);
+        return b;
+    }
+
+    static compact_poly_header<T>* clone(const compact_poly_header<T>& src, std::pmr::memory_resource* r) {
+        return make(r, static_cast<const block_type&>(src).value);
+    }
+
+    static compact_poly_header<T>* move_clone(compact_poly_header<T>& src, std::pmr::memory_resource* r) {
+        return make(r, std::move(static_cast<block_type&>(src).value));
+    }
+
+    static void destroy(compact_poly_header<T>* block) noexcept {
+        block_type*                b = static_cast<block_type*>(block);
+        std::pmr::memory_resource* r = b->resource;
+        b->value.~U();
+        b->~block_type();
+        r->deallocate(b, sizeof(block_type), alignof(block_type));
+    }
+
+    static constexpr compact_poly_ops<T> ops = {&clone, &move_clone, &destroy};
+};
+
+template <class T, class U>
+compact_poly_block<T, U>::compact_poly_block(std::pmr::memory_resource* r) noexcept
+    : compact_poly_header<T>(r, &compact_poly_model<T, U>::ops) {}
+
+} // namespace beman::indirect::detail
+
+namespace beman::indirect::pmr {
+
+// compact_polymorphic: pmr::polymorphic<T> in one pointer.
+//
+// pmr::polymorphic<T> holds its polymorphic_allocator, a pointer to its control
+// block and a pointer to its object. compact_polymorphic keeps only a pointer
+// to its block, whose header records the memory resource, the dispatch table
+// and the object's address; get_allocator() reads the resource back from
+// there, and a moved-from handle keeps its resource in the handle itself.
+// The handle is the size of a pointer, at the cost of a second dependent load
+// on every access, two more words per allocation and constant evaluation
+// support.
+//
+// Otherwise compact_polymorphic behaves as pmr::polymorphic<T>: objects are
+// constructed uses-allocator with the handle's resource, copies use the
+// default resource, and the resource never propagates on assignment.
+template <class T>
+class compact_polymorphic {
+    static_assert(std::is_object_v<T>, "T must be an object type");
+    static_assert(!std::is_array_v<T>, "T must not be an array type");
+    static_assert(!std::is_const_v<T> && !std::is_volatile_v<T>, "T must not be cv-qualified");
+
+    using header_type = detail::compact_poly_header<T>;
+
+  public:
+    using value_type     = T;
+    using allocator_type = std::pmr::polymorphic_allocator<T>;
+    using pointer        = T*;
+    using const_pointer  = const T*;
+
+    // constructors
+
+    explicit compact_polymorphic() : compact_polymorphic(std::allocator_arg, allocator_type()) {}
+
+    explicit compact_polymorphic(std::allocator_arg_t, const allocator_type& a) : word_(a.resource()) {
+        static_assert(std::is_default_constructible_v<T>);
+        static_assert(std::is_copy_constructible_v<T>);
+        word_.set_block(detail::compact_poly_model<T, T>::make(a.resource()));
+    }
+
+    compact_polymorphic(const compact_polymorphic& other)
+        : compact_polymorphic(std::allocator_arg,
+                              std::allocator_traits<allocator_type>::select_on_container_copy_construction(
+                                  other.get_allocator()),
+                              other) {}
+
+    compact_polymorphic(std::allocator_arg_t, const allocator_type& a, const compact_polymorphic& other)
+        : word_(a.resource()) {
+        if (!other.valueless_after_move())
+            word_.set_block(other.header()->ops->clone(*other.header(), a.resource()));
+    }
+
+    compact_polymorphic(compact_polymorphic&& other) noexcept : word_(other.word_) {
+        other.word_.set_valueless(word_.resource());
+    }
+
+    compact_polymorphic(std::allocator_arg_t, const allocator_type& a, compact_polymorphic&& other)
+        : word_(a.resource()) {
+        if (other.valueless_after_move()) {
+            // *this is valueless
+        } else if (*a.resource() == *other.word_.resource()) {
+            word_.steal(other.word_);
+        } else {
+            word_.set_block(other.header()->ops->move_clone(*other.header(), a.resource()));
+            other.reset();
+        }
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U = T>
+        requires(!std::is_same_v<detail::remove_cvref_t<U>, compact_polymorphic> &&
+                 detail::derived_from_v<detail::remove_cvref_t<U>, T> &&
+                 std::is_constructible_v<detail::remove_cvref_t<U>, U> &&
+                 std::is_copy_constructible_v<detail::remove_cvref_t<U>> &&
+                 !detail::is_in_place_type_v<detail::remove_cvref_t<U>>)
+#else
+    template <class U               = T,
+              std::enable_if_t<!std::is_same_v<detail::remove_cvref_t<U>, compact_polymorphic> &&
+                                   detail::derived_from_v<detail::remove_cvref_t<U>, T> &&
+                                   std::is_constructible_v<detail::remove_cvref_t<U>, U> &&
+                                   std::is_copy_constructible_v<detail::remove_cvref_t<U>> &&
+                                   !detail::is_in_place_type_v<detail::remove_cvref_t<U>>,
+                               int> = 0>
+#endif
+    explicit compact_polymorphic(U&& u)
+        : compact_polymorphic(std::allocator_arg, allocator_type(), std::forward<U>(u)) {
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U = T>
+        requires(!std::is_same_v<detail::remove_cvref_t<U>, compact_polymorphic> &&
+                 detail::derived_from_v<detail::remove_cvref_t<U>, T> &&
+                 std::is_constructible_v<detail::remove_cvref_t<U>, U> &&
+                 std::is_copy_constructible_v<detail::remove_cvref_t<U>> &&
+                 !detail::is_in_place_type_v<detail::remove_cvref_t<U>>)
+#else
+    template <class U               = T,
+              std::enable_if_t<!std::is_same_v<detail::remove_cvref_t<U>, compact_polymorphic> &&
+                                   detail::derived_from_v<detail::remove_cvref_t<U>, T> &&
+                                   std::is_constructible_v<detail::remove_cvref_t<U>, U> &&
+                                   std::is_copy_constructible_v<detail::remove_cvref_t<U>> &&
+                                   !detail::is_in_place_type_v<detail::remove_cvref_t<U>>,
+                               int> = 0>
+#endif
+    explicit compact_polymorphic(std::allocator_arg_t, const allocator_type& a, U&& u) : word_(a.resource()) {
+        word_.set_block(
+            detail::compact_poly_model<T, detail::remove_cvref_t<U>>::make(a.resource(), std::forward<U>(u)));
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U, class... Ts>
+        requires(std::is_same_v<detail::remove_cvref_t<U>, U> && detail::derived_from_v<U, T> &&
+                 std::is_constructible_v<U, Ts...> && std::is_copy_constructible_v<U>)
+#else
+    template <class U,
+              class... Ts,
+              std::enable_if_t<std::is_same_v<detail::remove_cvref_t<U>, U> && detail::derived_from_v<U, T> &&
+                                   std::is_constructible_v<U, Ts...> && std::is_copy_constructible_v<U>,
+                               int> = 0>
+#endif
+    explicit compact_polymorphic(std::in_place_type_t<U>, Ts&&... ts)
+        : compact_polymorphic(std::allocator_arg, allocator_type(), std::in_place_type<U>, std::forward<Ts>(ts)...) {
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U, class... Ts>
+        requires(std::is_same_v<detail::remove_cvref_t<U>, U> && detail::derived_from_v<U, T> &&
+                 std::is_constructible_v<U, Ts...> && std::is_copy_constructible_v<U>)
+#else
+    template <class U,
+              class... Ts,
+              std::enable_if_t<std::is_same_v<detail::remove_cvref_t<U>, U> && detail::derived_from_v<U, T> &&
+                                   std::is_constructible_v<U, Ts...> && std::is_copy_constructible_v<U>,
+                               int> = 0>
+#endif
+    explicit compact_polymorphic(std::allocator_arg_t, const allocator_type& a, std::in_place_type_t<U>, Ts&&... ts)
+        : word_(a.resource()) {
+        word_.set_block(detail::compact_poly_model<T, U>::make(a.resource(), std::forward<Ts>(ts)...));
+    }
+
+    // destructor
+
+    ~compact_polymorphic() {
+        static_assert(detail::is_complete_v<T>);
+        if (!valueless_after_move())
+            header()->ops->destroy(header());
+    }
+
+    // assignment
+
+    compact_polymorphic& operator=(const compact_polymorphic& other) {
+        if (std::addressof(other) == this)
+            return *this;
+
+        if (other.valueless_after_move()) {
+            reset();
+        } else {
+            // Clone first for strong exception guarantee
+            header_type* b = other.header()->ops->clone(*other.header(), word_.resource());
+            reset();
+            word_.set_block(b);
+        }
+        return *this;
+    }
+
+    compact_polymorphic& operator=(compact_polymorphic&& other) {
+        if (std::addressof(other) == this)
+            return *this;
+
+        std::pmr::memory_resource* r = word_.resource();
+        if (other.valueless_after_move()) {
+            reset();
+        } else if (*r == *other.word_.resource()) {
+            reset();
+            word_.steal(other.word_);
+        } else {
+            // Resources differ and don't propagate: must move-clone
+            header_type* b = other.header()->ops->move_clone(*other.header(), r);
+            reset();
+            word_.set_block(b);
+            other.reset();
+        }
+        return *this;
+    }
+
+    // observers
+
+    const T& operator*() const noexcept {
+        assert(!valueless_after_move());
+        return *header()->object;
+    }
+
+    T& operator*() noexcept {
+        assert(!valueless_after_move());
+        return *header()->object;
+    }
+
+    const_pointer operator->() const noexcept {
+        assert(!valueless_after_move());
+        return header()->object;
+    }
+
+    pointer operator->() noexcept {
+        assert(!valueless_after_move());
+        return header()->object;
+    }
+
+    bool valueless_after_move() const noexcept { return word_.valueless(); }
+
+    allocator_type get_allocator() const noexcept { return allocator_type(word_.resource()); }
+
+    // swap
+
+    void swap(compact_polymorphic& other) noexcept {
+        // Precondition: resources must be equal, as they don't propagate on swap.
+        assert(*word_.resource() == *other.word_.resource());
+        word_.swap(other.word_);
+    }
+
+    friend void swap(compact_polymorphic& lhs, compact_polymorphic& rhs) noexcept { lhs.swap(rhs); }
+
+  private:
+    header_type* header() const noexcept { return static_cast<header_type*>(word_.block()); }
+
+    void reset() noexcept {
+        if (!valueless_after_move()) {
+            std::pmr::memory_resource* r = word_.resource();
+            header()->ops->destroy(header());
+            word_.set_valueless(r);
+        }
+    }
+
+    detail::compact_word word_;
+};
+
+} // namespace beman::indirect::pmr
+
+namespace beman::indirect {
+
+// The handle is a single integer; its block never refers back to it.
+template <class T>
+struct is_trivially_relocatable<pmr::compact_polymorphic<T>> : std::true_type {};
+
+} // namespace beman::indirect
+
+#endif // BEMAN_INDIRECT_COMPACT_POLYMORPHIC_HPP
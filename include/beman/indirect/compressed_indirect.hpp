@@ -0,0 +1,202 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef BEMAN_INDIRECT_COMPRESSED_INDIRECT_HPP
+#define BEMAN_INDIRECT_COMPRESSED_INDIRECT_HPP
+
+#include <beman/indirect/arena.hpp>
+#include <beman/indirect/indirect.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+namespace beman::indirect {
+
+// compressed_indirect: an indirect that stores a 32-bit offset.
+//
+// On 64-bit targets a pointer is 8 bytes, but a graph or tree whose nodes all
+// live in one arena of at most 4 GiB only needs 4 to find them.
+// compressed_indirect<T, Arena> is indirect<T, offset_allocator<T, Arena>>:
+// the allocator's pointer type, offset_ptr, is the distance of the value from
+// Arena::base(), and the allocator is empty. With [[no_unique_address]] the
+// handle is 4 bytes; without it, the empty allocator pads it back to 8. Value
+// semantics are indirect's own: copies are deep, comparisons are by value and
+// moving from a handle leaves it valueless.
+//
+// Arena is a class with static members, so that neither the pointer nor the
+// allocator has to store where the arena is:
+//
+//     static std::byte* base() noexcept;
+//     static void*      allocate(std::size_t bytes, std::size_t alignment);
+//     static void       deallocate(void* p, std::size_t bytes, std::size_t alignment) noexcept;
+//
+// allocate returns memory strictly after base() and less than 4 GiB past it,
+// or throws. offset_arena below is the library's own.
+
+// Fancy pointer: a 32-bit offset from Arena::base(). Offset 0 is the null
+// pointer, which is why an arena never hands out its first byte.
+template <class T, class Arena>
+class offset_ptr {
+  public:
+    using element_type    = T;
+    using difference_type = std::ptrdiff_t;
+
+    template <class U>
+    using rebind = offset_ptr<U, Arena>;
+
+    offset_ptr() noexcept = default;
+    offset_ptr(std::nullptr_t) noexcept {}
+
+    // p must be null or point into the arena.
+    explicit offset_ptr(T* p) noexcept : offset_(to_offset(p)) {}
+
+    // Adds const, or erases the type to void; both keep the address as is.
+    template <class U,
+              std::enable_if_t<std::is_convertible_v<U*, T*> &&
+                                   (std::is_same_v<std::remove_cv_t<U>, std::remove_cv_t<T>> || std::is_void_v<T>),
+                               int> = 0>
+    offset_ptr(const offset_ptr<U, Arena>& other) noexcept : offset_(other.offset_) {}
+
+    template <class U = T, std::enable_if_t<!std::is_void_v<U>, int> = 0>
+    static offset_ptr pointer_to(U& r) noexcept {
+        return offset_ptr(std::addressof(r));
+    }
+
+    T* get() const noexcept {
+        if (offset_ == 0)
+            return nullptr;
+        return reinterpret_cast<T*>(Arena::base() + offset_);
+    }
+
+    T* operator->() const noexcept { return get(); }
+
+    template <class U = T, std::enable_if_t<!std::is_void_v<U>, int> = 0>
+    U& operator*() const noexcept {
+        assert(offset_ != 0);
+        return *get();
+    }
+
+    explicit operator bool() const noexcept { return offset_ != 0; }
+
+    std::uint32_t offset() const noexcept { return offset_; }
+
+    friend bool operator==(offset_ptr lhs, offset_ptr rhs) noexcept { return lhs.offset_ == rhs.offset_; }
+    friend bool operator!=(offset_ptr lhs, offset_ptr rhs) noexcept { return lhs.offset_ != rhs.offset_; }
+    friend bool operator==(offset_ptr lhs, std::nullptr_t) noexcept { return lhs.offset_ == 0; }
+    friend bool operator!=(offset_ptr lhs, std::nullptr_t) noexcept { return lhs.offset_ != 0; }
+    friend bool operator==(std::nullptr_t, offset_ptr rhs) noexcept { return rhs.offset_ == 0; }
+    friend bool operator!=(std::nullptr_t, offset_ptr rhs) noexcept { return rhs.offset_ != 0; }
+
+  private:
+    template <class, class>
+    friend class offset_ptr;
+
+    static std::uint32_t to_offset(T* p) noexcept {
+        if (p == nullptr)
+            return 0;
+        const auto* bytes = reinterpret_cast<const std::byte*>(p);
+        assert(bytes > Arena::base() && bytes - Arena::base() <= std::numeric_limits<std::uint32_t>::max());
+        return static_cast<std::uint32_t>(bytes - Arena::base());
+    }
+
+    std::uint32_t offset_ = 0;
+};
+
+// Stateless allocator whose pointer type is offset_ptr<T, Arena>.
+template <class T, class Arena>
+class offset_allocator {
+  public:
+    using value_type = T;
+    using pointer    = offset_ptr<T, Arena>;
+
+    offset_allocator() noexcept = default;
+
+    template <class U>
+    offset_allocator(const offset_allocator<U, Arena>&) noexcept {}
+
+    pointer allocate(std::size_t n) {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+            throw std::bad_array_new_length();
+        return pointer(static_cast<T*>(Arena::allocate(n * sizeof(T), alignof(T))));
+    }
+
+    void deallocate(pointer p, std::size_t n) noexcept { Arena::deallocate(p.get(), n * sizeof(T), alignof(T)); }
+
+    template <class U>
+    friend bool operator==(const offset_allocator&, const offset_allocator<U, Arena>&) noexcept {
+        return true;
+    }
+
+    template <class U>
+    friend bool operator!=(const offset_allocator&, const offset_allocator<U, Arena>&) noexcept {
+        return false;
+    }
+};
+
+// A monotonic arena of up to 4 GiB, one per Tag.
+//
+// reserve allocates the region, allocate carves memory from it and
+// deallocate does nothing; the memory comes back all at once on release.
+// Like std::pmr::monotonic_buffer_resource, it is not synchronized. Since
+// deallocate is a no-op, offset_allocator over an offset_arena is an arena
+// allocator, and compressed_indirect<T, offset_arena<Tag>> skips destroying
+// arena-discardable values.
+template <class Tag>
+class offset_arena {
+  public:
+    static constexpr std::size_t max_capacity = std::size_t(std::numeric_limits<std::uint32_t>::max()) + 1;
+
+    // Allocate a region of capacity bytes. The arena must not hold one already.
+    static void reserve(std::size_t capacity) {
+        assert(base_ == nullptr);
+        if (capacity > max_capacity)
+            throw std::length_error("offset_arena capacity exceeds 4 GiB");
+        base_     = static_cast<std::byte*>(::operator new(capacity));
+        capacity_ = capacity;
+        used_     = 1;
+    }
+
+    // Free the region. Handles into it must not be used again, other than
+    // being destroyed when their destructors do nothing.
+    static void release() noexcept {
+        ::operator delete(base_);
+        base_     = nullptr;
+        capacity_ = 0;
+        used_     = 0;
+    }
+
+    static std::byte*  base() noexcept { return base_; }
+    static std::size_t capacity() noexcept { return capacity_; }
+    static std::size_t used() noexcept { return used_; }
+
+    static void* allocate(std::size_t bytes, std::size_t alignment) {
+        const auto        address = reinterpret_cast<std::uintptr_t>(base_);
+        const std::size_t start   = ((address + used_ + alignment - 1) & ~(alignment - 1)) - address;
+        if (base_ == nullptr || start > capacity_ || bytes > capacity_ - start)
+            throw std::bad_alloc();
+        used_ = start + bytes;
+        return base_ + start;
+    }
+
+    static void deallocate(void*, std::size_t, std::size_t) noexcept {}
+
+  private:
+    static inline std::byte*  base_     = nullptr;
+    static inline std::size_t capacity_ = 0;
+    static inline std::size_t used_     = 0;
+};
+
+template <class T, class Tag>
+struct is_arena_allocator<offset_allocator<T, offset_arena<Tag>>> : std::true_type {};
+
+template <class T, class Arena>
+using compressed_indirect = indirect<T, offset_allocator<T, Arena>>;
+
+} // namespace beman::indirect
+
+#endif // BEMAN_INDIRECT_COMPRESSED_INDIRECT_HPP
@@ -0,0 +1,247 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef BEMAN_INDIRECT_COUNTING_ALLOCATOR_HPP
+#define BEMAN_INDIRECT_COUNTING_ALLOCATOR_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+namespace beman::indirect {
+
+// Counter policies for allocation_stats.
+
+// Safe for statistics shared by allocators on several threads. Every update
+// is a relaxed read-modify-write: totals are exact once the threads are done,
+// but a reading taken while they allocate may mix old and new values.
+class relaxed_counter {
+  public:
+    std::size_t add(std::size_t n) noexcept { return n_.fetch_add(n, std::memory_order_relaxed) + n; }
+    void        sub(std::size_t n) noexcept { n_.fetch_sub(n, std::memory_order_relaxed); }
+    void        raise_to(std::size_t n) noexcept {
+        std::size_t current = n_.load(std::memory_order_relaxed);
+        while (current < n && !n_.compare_exchange_weak(current, n, std::memory_order_relaxed)) {
+        }
+    }
+    void        store(std::size_t n) noexcept { n_.store(n, std::memory_order_relaxed); }
+    std::size_t load() const noexcept { return n_.load(std::memory_order_relaxed); }
+
+  private:
+    std::atomic<std::size_t> n_{0};
+};
+
+// For statistics only ever updated by one thread, such as a thread_local
+// allocation_stats; avoids locked instructions.
+class local_counter {
+  public:
+    std::size_t add(std::size_t n) noexcept { return n_ += n; }
+    void        sub(std::size_t n) noexcept { n_ -= n; }
+    void        raise_to(std::size_t n) noexcept {
+        if (n_ < n)
+            n_ = n;
+    }
+    void        store(std::size_t n) noexcept { n_ = n; }
+    std::size_t load() const noexcept { return n_; }
+
+  private:
+    std::size_t n_ = 0;
+};
+
+// allocation_stats: what a counting_allocator or counting_resource has
+// allocated.
+//
+// Counts allocations and deallocations, the bytes currently live and their
+// peak, and a histogram of allocation sizes in powers of two: bucket b counts
+// the allocations of [2^b, 2^(b+1)) bytes, bucket 0 also counts empty ones,
+// and the last bucket everything larger. Sizes are the bytes asked of the
+// underlying allocator, so for a polymorphic they include the control block.
+template <class Counter = relaxed_counter>
+class allocation_stats {
+  public:
+    static constexpr std::size_t size_buckets = 32;
+
+    allocation_stats() noexcept = default;
+
+    allocation_stats(const allocation_stats&)            = delete;
+    allocation_stats& operator=(const allocation_stats&) = delete;
+
+    static constexpr std::size_t size_bucket_of(std::size_t bytes) noexcept {
+        std::size_t bucket = 0;
+        while (bytes > 1 && bucket + 1 < size_buckets) {
+            bytes >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+
+    std::size_t allocations() const noexcept { return allocations_.load(); }
+    std::size_t deallocations() const noexcept { return deallocations_.load(); }
+    std::size_t bytes_live() const noexcept { return bytes_live_.load(); }
+    std::size_t peak_bytes() const noexcept { return peak_bytes_.load(); }
+    std::size_t size_histogram(std::size_t bucket) const noexcept { return histogram_[bucket].load(); }
+
+    // Starts a new measurement: clears the counts and the histogram, and
+    // lowers the peak to the bytes live now. Live bytes are kept, since
+    // their deallocations are still to come.
+    void reset() noexcept {
+        allocations_.store(0);
+        deallocations_.store(0);
+        peak_bytes_.store(bytes_live_.load());
+        for (Counter& c : histogram_)
+            c.store(0);
+    }
+
+    void record_allocation(std::size_t bytes) noexcept {
+        allocations_.add(1);
+        histogram_[size_bucket_of(bytes)].add(1);
+        peak_bytes_.raise_to(bytes_live_.add(bytes));
+    }
+
+    void record_deallocation(std::size_t bytes) noexcept {
+        deallocations_.add(1);
+        bytes_live_.sub(bytes);
+    }
+
+  private:
+    Counter allocations_;
+    Counter deallocations_;
+    Counter bytes_live_;
+    Counter peak_bytes_;
+    Counter histogram_[size_buckets];
+};
+
+// counting_allocator: allocator adaptor that records into allocation_stats.
+//
+// Forwards allocation, construction and the propagation traits to Inner, and
+// records every allocation and deallocation in a stats object that it refers
+// to but does not own. Rebinding rebinds Inner and keeps the stats, so the
+// control blocks a polymorphic allocates through a rebound copy are counted
+// in the same place as the values of an indirect. Allocators compare equal
+// when they share their stats and their inner allocators compare equal.
+//
+// With Counter = local_counter, the stats must only be updated from one
+// thread; a thread_local allocation_stats gives per-thread figures without
+// atomic operations.
+template <class T, class Inner = std::allocator<T>, class Counter = relaxed_counter>
+class counting_allocator {
+    using inner_traits = std::allocator_traits<Inner>;
+
+    static_assert(std::is_same_v<typename inner_traits::value_type, T>,
+                  "counting_allocator's inner allocator must allocate T");
+
+    template <class U, class I, class C>
+    friend class counting_allocator;
+
+  public:
+    using value_type                             = T;
+    using inner_allocator_type                   = Inner;
+    using stats_type                             = allocation_stats<Counter>;
+    using size_type                              = typename inner_traits::size_type;
+    using difference_type                        = typename inner_traits::difference_type;
+    using propagate_on_container_copy_assignment = typename inner_traits::propagate_on_container_copy_assignment;
+    using propagate_on_container_move_assignment = typename inner_traits::propagate_on_container_move_assignment;
+    using propagate_on_container_swap            = typename inner_traits::propagate_on_container_swap;
+    using is_always_equal                        = std::false_type;
+
+    template <class U>
+    struct rebind {
+        using other = counting_allocator<U, typename inner_traits::template rebind_alloc<U>, Counter>;
+    };
+
+    explicit counting_allocator(stats_type& stats) noexcept(std::is_nothrow_default_constructible_v<Inner>)
+        : stats_(&stats), inner_() {}
+
+    counting_allocator(stats_type& stats, const Inner& inner) noexcept : stats_(&stats), inner_(inner) {}
+
+    template <class U, class I>
+    counting_allocator(const counting_allocator<U, I, Counter>& other) noexcept
+        : stats_(other.stats_), inner_(other.inner_) {}
+
+    T* allocate(std::size_t n) {
+        T* p = inner_traits::allocate(inner_, n);
+        stats_->record_allocation(n * sizeof(T));
+        return p;
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        stats_->record_deallocation(n * sizeof(T));
+        inner_traits::deallocate(inner_, p, n);
+    }
+
+    template <class U, class... Args>
+    void construct(U* p, Args&&... args) {
+        inner_traits::construct(inner_, p, std::forward<Args>(args)...);
+    }
+
+    template <class U>
+    void destroy(U* p) {
+        inner_traits::destroy(inner_, p);
+    }
+
+    counting_allocator select_on_container_copy_construction() const {
+        return counting_allocator(*stats_, inner_traits::select_on_container_copy_construction(inner_));
+    }
+
+    stats_type&  stats() const noexcept { return *stats_; }
+    const Inner& inner_allocator() const noexcept { return inner_; }
+
+    friend bool operator==(const counting_allocator& lhs, const counting_allocator& rhs) noexcept {
+        return lhs.stats_ == rhs.stats_ && lhs.inner_ == rhs.inner_;
+    }
+
+    friend bool operator!=(const counting_allocator& lhs, const counting_allocator& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+
+  private:
+    stats_type* stats_;
+    Inner       inner_;
+};
+
+// counting_resource: memory resource that records into allocation_stats.
+//
+// Passes every request to the upstream resource and records it in stats(),
+// which the resource owns. Handy for pmr::indirect and pmr::polymorphic,
+// whose allocators all end up at a resource however they were rebound.
+template <class Counter = relaxed_counter>
+class counting_resource : public std::pmr::memory_resource {
+  public:
+    using stats_type = allocation_stats<Counter>;
+
+    counting_resource() noexcept : counting_resource(std::pmr::get_default_resource()) {}
+
+    explicit counting_resource(std::pmr::memory_resource* upstream) noexcept : upstream_(upstream) {}
+
+    counting_resource(const counting_resource&)            = delete;
+    counting_resource& operator=(const counting_resource&) = delete;
+
+    std::pmr::memory_resource* upstream_resource() const noexcept { return upstream_; }
+
+    stats_type&       stats() noexcept { return stats_; }
+    const stats_type& stats() const noexcept { return stats_; }
+
+  protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        void* p = upstream_->allocate(bytes, alignment);
+        stats_.record_allocation(bytes);
+        return p;
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        stats_.record_deallocation(bytes);
+        upstream_->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+  private:
+    std::pmr::memory_resource* upstream_;
+    stats_type                 stats_;
+};
+
+} // namespace beman::indirect
+
+#endif // BEMAN_INDIRECT_COUNTING_ALLOCATOR_HPP
@@ -0,0 +1,561 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef BEMAN_INDIRECT_COW_INDIRECT_HPP
+#define BEMAN_INDIRECT_COW_INDIRECT_HPP
+
+#include <beman/indirect/detail/config.hpp>
+#include <beman/indirect/detail/synth_three_way.hpp>
+#include <beman/indirect/relocate.hpp>
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+namespace beman::indirect {
+
+// Reference count policies for cow_indirect. A policy starts at one owner;
+// release() returns true when the caller was the last owner.
+
+// Safe for handles that share a value across threads, like shared_ptr.
+class atomic_refcount {
+  public:
+    void acquire() noexcept { n_.fetch_add(1, std::memory_order_relaxed); }
+    bool release() noexcept { return n_.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+    // Acquire so that a handle seeing itself as the sole owner also sees the
+    // writes other owners made before releasing.
+    std::size_t count() const noexcept { return n_.load(std::memory_order_acquire); }
+
+  private:
+    std::atomic<std::size_t> n_{1};
+};
+
+// For values that are never shared across threads; avoids locked instructions.
+class local_refcount {
+  public:
+    void        acquire() noexcept { ++n_; }
+    bool        release() noexcept { return --n_ == 0; }
+    std::size_t count() const noexcept { return n_; }
+
+  private:
+    std::size_t n_ = 1;
+};
+
+template <class T, class Allocator, class RefCount>
+class cow_indirect;
+
+namespace detail {
+
+template <class>
+inline constexpr bool is_cow_indirect_v = false;
+
+template <class T, class A, class R>
+inline constexpr bool is_cow_indirect_v<cow_indirect<T, A, R>> = true;
+
+// Shared allocation of a cow_indirect: the owner count followed by the value.
+template <class T, class RefCount>
+struct cow_block {
+    RefCount count;
+    union storage {
+        T value;
+        storage() {}
+        ~storage() {}
+    } storage_;
+};
+
+} // namespace detail
+
+// cow_indirect: indirect with copy-on-write sharing.
+//
+// Has the value semantics of indirect<T, Allocator>, but copying only shares
+// the allocation and bumps a reference count. The value is cloned on the first
+// mutable access through a shared handle (non-const operator* or operator->),
+// so copies that are only read never allocate. Sharing requires the two
+// handles' allocators to compare equal; otherwise a copy is deep, as for
+// indirect.
+//
+// A reference obtained through mutable access stays valid only until the
+// handle is next copied: after that the value is shared again, and writing
+// through the old reference would be visible to both copies.
+template <class T, class Allocator = std::allocator<T>, class RefCount = atomic_refcount>
+class cow_indirect {
+    static_assert(std::is_object_v<T>, "T must be an object type");
+    static_assert(!std::is_array_v<T>, "T must not be an array type");
+    static_assert(!std::is_const_v<T> && !std::is_volatile_v<T>, "T must not be cv-qualified");
+    static_assert(std::is_same_v<T, typename std::allocator_traits<Allocator>::value_type>,
+                  "Allocator::value_type must be T");
+
+    using alloc_traits = std::allocator_traits<Allocator>;
+    using block_type   = detail::cow_block<T, RefCount>;
+    using block_alloc  = typename alloc_traits::template rebind_alloc<block_type>;
+    using block_traits = std::allocator_traits<block_alloc>;
+
+  public:
+    using value_type     = T;
+    using allocator_type = Allocator;
+    using pointer        = T*;
+    using const_pointer  = const T*;
+
+    // constructors
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    explicit cow_indirect()
+        requires std::is_default_constructible_v<Allocator>
+#else
+    template <class Alloc_ = Allocator, std::enable_if_t<std::is_default_constructible_v<Alloc_>, int> = 0>
+    explicit cow_indirect()
+#endif
+    {
+        static_assert(std::is_default_constructible_v<T>);
+        b_ = make_block(alloc_);
+    }
+
+    explicit cow_indirect(std::allocator_arg_t, const Allocator& a) : alloc_(a) {
+        static_assert(std::is_default_constructible_v<T>);
+        b_ = make_block(alloc_);
+    }
+
+    cow_indirect(const cow_indirect& other)
+        : alloc_(alloc_traits::select_on_container_copy_construction(other.alloc_)) {
+        static_assert(std::is_copy_constructible_v<T>);
+        share_or_copy(other);
+    }
+
+    cow_indirect(std::allocator_arg_t, const Allocator& a, const cow_indirect& other) : alloc_(a) {
+        static_assert(std::is_copy_constructible_v<T>);
+        share_or_copy(other);
+    }
+
+    cow_indirect(cow_indirect&& other) noexcept : b_(other.b_), alloc_(std::move(other.alloc_)) { other.b_ = nullptr; }
+
+    cow_indirect(std::allocator_arg_t,
+                 const Allocator& a,
+                 cow_indirect&&   other) noexcept(alloc_traits::is_always_equal::value)
+        : alloc_(a) {
+        if (other.valueless_after_move()) {
+            // *this is valueless
+        } else if (alloc_traits::is_always_equal::value || alloc_ == other.alloc_) {
+            b_       = other.b_;
+            other.b_ = nullptr;
+        } else {
+            // other's value may still be shared, so it can only be moved from
+            // when other is its sole owner.
+            if (other.b_->count.count() == 1) {
+                b_ = make_block(alloc_, std::move(other.b_->storage_.value));
+            } else {
+                b_ = make_block(alloc_, std::as_const(other.b_->storage_.value));
+            }
+            other.reset();
+        }
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U = T>
+        requires(!std::is_same_v<detail::remove_cvref_t<U>, cow_indirect> &&
+                 !std::is_same_v<detail::remove_cvref_t<U>, std::in_place_t> && std::is_constructible_v<T, U> &&
+                 std::is_default_constructible_v<Allocator>)
+#else
+    template <class U               = T,
+              std::enable_if_t<!std::is_same_v<detail::remove_cvref_t<U>, cow_indirect> &&
+                                   !std::is_same_v<detail::remove_cvref_t<U>, std::in_place_t> &&
+                                   std::is_constructible_v<T, U> && std::is_default_constructible_v<Allocator>,
+                               int> = 0>
+#endif
+    explicit cow_indirect(U&& u) {
+        b_ = make_block(alloc_, std::forward<U>(u));
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U = T>
+        requires(!std::is_same_v<detail::remove_cvref_t<U>, cow_indirect> &&
+                 !std::is_same_v<detail::remove_cvref_t<U>, std::in_place_t> && std::is_constructible_v<T, U>)
+#else
+    template <class U               = T,
+              std::enable_if_t<!std::is_same_v<detail::remove_cvref_t<U>, cow_indirect> &&
+                                   !std::is_same_v<detail::remove_cvref_t<U>, std::in_place_t> &&
+                                   std::is_constructible_v<T, U>,
+                               int> = 0>
+#endif
+    explicit cow_indirect(std::allocator_arg_t, const Allocator& a, U&& u) : alloc_(a) {
+        b_ = make_block(alloc_, std::forward<U>(u));
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class... Us>
+        requires(std::is_constructible_v<T, Us...> && std::is_default_constructible_v<Allocator>)
+#else
+    template <
+        class... Us,
+        std::enable_if_t<std::is_constructible_v<T, Us...> && std::is_default_constructible_v<Allocator>, int> = 0>
+#endif
+    explicit cow_indirect(std::in_place_t, Us&&... us) {
+        b_ = make_block(alloc_, std::forward<Us>(us)...);
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class... Us>
+        requires std::is_constructible_v<T, Us...>
+#else
+    template <class... Us, std::enable_if_t<std::is_constructible_v<T, Us...>, int> = 0>
+#endif
+    explicit cow_indirect(std::allocator_arg_t, const Allocator& a, std::in_place_t, Us&&... us) : alloc_(a) {
+        b_ = make_block(alloc_, std::forward<Us>(us)...);
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class I, class... Us>
+        requires(std::is_constructible_v<T, std::initializer_list<I>&, Us...> &&
+                 std::is_default_constructible_v<Allocator>)
+#else
+    template <class I,
+              class... Us,
+              std::enable_if_t<std::is_constructible_v<T, std::initializer_list<I>&, Us...> &&
+                                   std::is_default_constructible_v<Allocator>,
+                               int> = 0>
+#endif
+    explicit cow_indirect(std::in_place_t, std::initializer_list<I> ilist, Us&&... us) {
+        b_ = make_block(alloc_, ilist, std::forward<Us>(us)...);
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class I, class... Us>
+        requires std::is_constructible_v<T, std::initializer_list<I>&, Us...>
+#else
+    template <class I,
+              class... Us,
+              std::enable_if_t<std::is_constructible_v<T, std::initializer_list<I>&, Us...>, int> = 0>
+#endif
+    explicit cow_indirect(
+        std::allocator_arg_t, const Allocator& a, std::in_place_t, std::initializer_list<I> ilist, Us&&... us)
+        : alloc_(a) {
+        b_ = make_block(alloc_, ilist, std::forward<Us>(us)...);
+    }
+
+    // destructor
+
+    ~cow_indirect() {
+        static_assert(detail::is_complete_v<T>);
+        reset();
+    }
+
+    // assignment
+
+    cow_indirect& operator=(const cow_indirect& other) {
+        static_assert(std::is_copy_constructible_v<T>);
+        if (std::addressof(other) == this || b_ == other.b_)
+            return *this;
+
+        constexpr bool pocca                  = alloc_traits::propagate_on_container_copy_assignment::value;
+        Allocator      alloc_for_construction = pocca ? other.alloc_ : alloc_;
+
+        // Build the new owner first for the strong exception guarantee.
+        cow_indirect tmp(std::allocator_arg, alloc_for_construction, other);
+        reset();
+        if constexpr (pocca) {
+            alloc_ = other.alloc_;
+        }
+        b_     = tmp.b_;
+        tmp.b_ = nullptr;
+        return *this;
+    }
+
+    cow_indirect&
+    operator=(cow_indirect&& other) noexcept(alloc_traits::propagate_on_container_move_assignment::value ||
+                                             alloc_traits::is_always_equal::value) {
+        if (std::addressof(other) == this)
+            return *this;
+
+        constexpr bool pocma = alloc_traits::propagate_on_container_move_assignment::value;
+
+        if (other.valueless_after_move()) {
+            reset();
+        } else if (pocma || alloc_ == other.alloc_) {
+            reset();
+            b_       = other.b_;
+            other.b_ = nullptr;
+        } else {
+            cow_indirect tmp(std::allocator_arg, alloc_, std::move(other));
+            reset();
+            b_     = tmp.b_;
+            tmp.b_ = nullptr;
+        }
+
+        if constexpr (pocma) {
+            alloc_ = other.alloc_;
+        }
+        return *this;
+    }
+
+    // Assigns through when this handle is the sole owner; otherwise the shared
+    // value is left alone and a fresh one is constructed from u.
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U = T>
+        requires(!std::is_same_v<detail::remove_cvref_t<U>, cow_indirect> && std::is_constructible_v<T, U> &&
+                 std::is_assignable_v<T&, U>)
+#else
+    template <class U = T,
+              std::enable_if_t<!std::is_same_v<detail::remove_cvref_t<U>, cow_indirect> &&
+                                   std::is_constructible_v<T, U> && std::is_assignable_v<T&, U>,
+                               int> = 0>
+#endif
+    cow_indirect& operator=(U&& u) {
+        if (!valueless_after_move() && b_->count.count() == 1) {
+            b_->storage_.value = std::forward<U>(u);
+        } else {
+            block_type* b = make_block(alloc_, std::forward<U>(u));
+            reset();
+            b_ = b;
+        }
+        return *this;
+    }
+
+    // observers
+    //
+    // The const overloads never copy. The non-const overloads first make this
+    // handle the sole owner of its value, cloning it if it is shared.
+
+    const T& operator*() const& noexcept {
+        assert(!valueless_after_move());
+        return b_->storage_.value;
+    }
+
+    T& operator*() & {
+        assert(!valueless_after_move());
+        detach();
+        return b_->storage_.value;
+    }
+
+    const T&& operator*() const&& noexcept {
+        assert(!valueless_after_move());
+        return std::move(b_->storage_.value);
+    }
+
+    T&& operator*() && {
+        assert(!valueless_after_move());
+        detach();
+        return std::move(b_->storage_.value);
+    }
+
+    const_pointer operator->() const noexcept {
+        assert(!valueless_after_move());
+        return std::addressof(b_->storage_.value);
+    }
+
+    pointer operator->() {
+        assert(!valueless_after_move());
+        detach();
+        return std::addressof(b_->storage_.value);
+    }
+
+    bool valueless_after_move() const noexcept { return b_ == nullptr; }
+
+    // Number of handles sharing this handle's value; 0 when valueless. With
+    // atomic_refcount the result may be stale as soon as it is returned.
+    std::size_t use_count() const noexcept { return b_ ? b_->count.count() : 0; }
+
+    allocator_type get_allocator() const noexcept { return alloc_; }
+
+    // swap
+
+    void swap(cow_indirect& other) noexcept(alloc_traits::propagate_on_container_swap::value ||
+                                            alloc_traits::is_always_equal::value) {
+        // Precondition: allocators must be equal when they don't propagate on swap.
+        assert(alloc_traits::propagate_on_container_swap::value || alloc_ == other.alloc_);
+        using std::swap;
+        swap(b_, other.b_);
+        if constexpr (alloc_traits::propagate_on_container_swap::value) {
+            swap(alloc_, other.alloc_);
+        }
+    }
+
+    friend void swap(cow_indirect& lhs, cow_indirect& rhs) noexcept(noexcept(lhs.swap(rhs))) { lhs.swap(rhs); }
+
+    // relational operators
+
+    template <class U, class AA, class RR>
+    friend bool operator==(const cow_indirect&            lhs,
+                           const cow_indirect<U, AA, RR>& rhs) noexcept(noexcept(*lhs == *rhs)) {
+        if (lhs.valueless_after_move() || rhs.valueless_after_move())
+            return lhs.valueless_after_move() == rhs.valueless_after_move();
+        return *lhs == *rhs;
+    }
+
+#if BEMAN_INDIRECT_USE_THREE_WAY_COMPARISON
+    template <class U, class AA, class RR>
+    friend auto operator<=>(const cow_indirect& lhs, const cow_indirect<U, AA, RR>& rhs)
+        -> detail::synth_three_way_result<T, U> {
+        if (lhs.valueless_after_move() || rhs.valueless_after_move())
+            return !lhs.valueless_after_move() <=> !rhs.valueless_after_move();
+        return detail::synth_three_way(*lhs, *rhs);
+    }
+#else
+    template <class U, class AA, class RR>
+    friend bool operator!=(const cow_indirect&            lhs,
+                           const cow_indirect<U, AA, RR>& rhs) noexcept(noexcept(lhs == rhs)) {
+        return !(lhs == rhs);
+    }
+
+    template <class U, class AA, class RR>
+    friend bool operator<(const cow_indirect& lhs, const cow_indirect<U, AA, RR>& rhs) {
+        if (lhs.valueless_after_move() || rhs.valueless_after_move())
+            return !lhs.valueless_after_move() < !rhs.valueless_after_move();
+        return *lhs < *rhs;
+    }
+
+    template <class U, class AA, class RR>
+    friend bool operator>(const cow_indirect& lhs, const cow_indirect<U, AA, RR>& rhs) {
+        return rhs < lhs;
+    }
+
+    template <class U, class AA, class RR>
+    friend bool operator<=(const cow_indirect& lhs, const cow_indirect<U, AA, RR>& rhs) {
+        return !(rhs < lhs);
+    }
+
+    template <class U, class AA, class RR>
+    friend bool operator>=(const cow_indirect& lhs, const cow_indirect<U, AA, RR>& rhs) {
+        return !(lhs < rhs);
+    }
+#endif // BEMAN_INDIRECT_USE_THREE_WAY_COMPARISON
+
+    // equality with T
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U>
+        requires(!detail::is_cow_indirect_v<U>)
+    friend bool operator==(const cow_indirect& lhs, const U& rhs) noexcept(noexcept(*lhs == rhs)) {
+        if (lhs.valueless_after_move())
+            return false;
+        return *lhs == rhs;
+    }
+#else
+    template <class U, std::enable_if_t<!detail::is_cow_indirect_v<U>, int> = 0>
+    friend bool operator==(const cow_indirect& lhs, const U& rhs) noexcept(noexcept(*lhs == rhs)) {
+        if (lhs.valueless_after_move())
+            return false;
+        return *lhs == rhs;
+    }
+
+    template <class U, std::enable_if_t<!detail::is_cow_indirect_v<U>, int> = 0>
+    friend bool operator==(const U& lhs, const cow_indirect& rhs) noexcept(noexcept(rhs == lhs)) {
+        return rhs == lhs;
+    }
+
+    template <class U, std::enable_if_t<!detail::is_cow_indirect_v<U>, int> = 0>
+    friend bool operator!=(const cow_indirect& lhs, const U& rhs) noexcept(noexcept(lhs == rhs)) {
+        return !(lhs == rhs);
+    }
+
+    template <class U, std::enable_if_t<!detail::is_cow_indirect_v<U>, int> = 0>
+    friend bool operator!=(const U& lhs, const cow_indirect& rhs) noexcept(noexcept(rhs == lhs)) {
+        return !(rhs == lhs);
+    }
+#endif // BEMAN_INDIRECT_USE_CONCEPTS
+
+  private:
+    // Allocate a block owned by one handle and construct its value from args.
+    template <class... Args>
+    static block_type* make_block(Allocator& a, Args&&... args) {
+        block_alloc ba(a);
+        block_type* b = block_traits::allocate(ba, 1);
+        detail::construct_at_impl(b);
+        try {
+            alloc_traits::construct(a, std::addressof(b->storage_.value), std::forward<Args>(args)...);
+        } catch (...) {
+            std::destroy_at(b);
+            block_traits::deallocate(ba, b, 1);
+            throw;
+        }
+        return b;
+    }
+
+    // Share other's block when our allocator can free it; deep copy otherwise.
+    void share_or_copy(const cow_indirect& other) {
+        if (other.valueless_after_move())
+            return;
+        if (alloc_ == other.alloc_) {
+            other.b_->count.acquire();
+            b_ = other.b_;
+        } else {
+            b_ = make_block(alloc_, std::as_const(other.b_->storage_.value));
+        }
+    }
+
+    // Give this handle a block of its own before the value is modified.
+    void detach() {
+        if (b_->count.count() == 1)
+            return;
+        block_type* b = make_block(alloc_, std::as_const(b_->storage_.value));
+        reset();
+        b_ = b;
+    }
+
+    // Drop this handle's ownership, destroying the value if it was the last.
+    void reset() noexcept {
+        if (b_ == nullptr)
+            return;
+        if (b_->count.release()) {
+            block_alloc ba(alloc_);
+            alloc_traits::destroy(alloc_, std::addressof(b_->storage_.value));
+            std::destroy_at(b_);
+            block_traits::deallocate(ba, b_, 1);
+        }
+        b_ = nullptr;
+    }
+
+    block_type*                                b_     = nullptr;
+    BEMAN_INDIRECT_NO_UNIQUE_ADDRESS Allocator alloc_ = Allocator();
+};
+
+// Deduction guides
+template <class Value>
+cow_indirect(Value) -> cow_indirect<Value>;
+
+template <class Allocator, class Value>
+cow_indirect(std::allocator_arg_t, Allocator, Value)
+    -> cow_indirect<Value, typename std::allocator_traits<Allocator>::template rebind_alloc<Value>>;
+
+// The reference count lives in the shared block, so only the allocator matters.
+template <class T, class Allocator, class RefCount>
+struct is_trivially_relocatable<cow_indirect<T, Allocator, RefCount>> : is_trivially_relocatable<Allocator> {};
+
+} // namespace beman::indirect
+
+// Hash support
+#if BEMAN_INDIRECT_USE_CONCEPTS
+template <class T, class Allocator, class RefCount>
+    requires std::is_default_constructible_v<std::hash<T>>
+struct std::hash<beman::indirect::cow_indirect<T, Allocator, RefCount>> {
+    std::size_t operator()(const beman::indirect::cow_indirect<T, Allocator, RefCount>& i) const
+        noexcept(noexcept(std::hash<T>{}(*i))) {
+        if (i.valueless_after_move())
+            return static_cast<std::size_t>(-1);
+        return std::hash<T>{}(*i);
+    }
+};
+#else
+template <class T, class Allocator, class RefCount>
+struct std::hash<beman::indirect::cow_indirect<T, Allocator, RefCount>> {
+    template <class U = T, std::enable_if_t<std::is_default_constructible_v<std::hash<U>>, int> = 0>
+    std::size_t operator()(const beman::indirect::cow_indirect<T, Allocator, RefCount>& i) const
+        noexcept(noexcept(std::hash<T>{}(*i))) {
+        if (i.valueless_after_move())
+            return static_cast<std::size_t>(-1);
+        return std::hash<T>{}(*i);
+    }
+};
+#endif
+
+namespace beman::indirect::pmr {
+
+template <class T, class RefCount = atomic_refcount>
+using cow_indirect = beman::indirect::cow_indirect<T, std::pmr::polymorphic_allocator<T>, RefCount>;
+
+} // namespace beman::indirect::pmr
+
+#endif // BEMAN_INDIRECT_COW_INDIRECT_HPP
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef BEMAN_INDIRECT_DETAIL_COMPACT_BLOCK_HPP
+#define BEMAN_INDIRECT_DETAIL_COMPACT_BLOCK_HPP
+
+#include <cassert>
+#include <cstdint>
+#include <memory_resource>
+
+namespace beman::indirect::detail {
+
+// Start of every heap block owned by a compact handle: the resource the block
+// was allocated from, and must be returned to.
+struct compact_block_base {
+    std::pmr::memory_resource* resource;
+
+    explicit compact_block_base(std::pmr::memory_resource* r) noexcept : resource(r) {}
+};
+
+// The single word of a compact handle. It holds the address of the handle's
+// block or, when the handle has no value, the address of its memory resource
+// with the low bit set, so that a moved-from handle still knows where to
+// allocate. Neither a block nor a resource is ever at an odd address.
+class compact_word {
+  public:
+    explicit compact_word(std::pmr::memory_resource* r) noexcept : bits_(tagged(r)) {}
+
+    bool valueless() const noexcept { return (bits_ & valueless_bit) != 0; }
+
+    compact_block_base* block() const noexcept {
+        assert(!valueless());
+        return reinterpret_cast<compact_block_base*>(bits_);
+    }
+
+    std::pmr::memory_resource* resource() const noexcept {
+        if (valueless())
+            return reinterpret_cast<std::pmr::memory_resource*>(bits_ & ~valueless_bit);
+        return block()->resource;
+    }
+
+    void set_block(compact_block_base* b) noexcept { bits_ = reinterpret_cast<std::uintptr_t>(b); }
+    void set_valueless(std::pmr::memory_resource* r) noexcept { bits_ = tagged(r); }
+
+    // Take other's block or resource, leaving other valueless with the
+    // resource it had.
+    void steal(compact_word& other) noexcept {
+        std::pmr::memory_resource* r = other.resource();
+        bits_                        = other.bits_;
+        other.set_valueless(r);
+    }
+
+    void swap(compact_word& other) noexcept {
+        std::uintptr_t tmp = bits_;
+        bits_              = other.bits_;
+        other.bits_        = tmp;
+    }
+
+  private:
+    static constexpr std::uintptr_t valueless_bit = 1;
+
+    static std::uintptr_t tagged(std::pmr::memory_resource* r) noexcept {
+        return reinterpret_cast<std::uintptr_t>(r) | valueless_bit;
+    }
+
+    std::uintptr_t bits_;
+};
+
+} // namespace beman::indirect::detail
+
+#endif // BEMAN_INDIRECT_DETAIL_COMPACT_BLOCK_HPP
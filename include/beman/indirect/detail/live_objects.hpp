@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef BEMAN_INDIRECT_DETAIL_LIVE_OBJECTS_HPP
+#define BEMAN_INDIRECT_DETAIL_LIVE_OBJECTS_HPP
+
+#include <beman/indirect/detail/config.hpp>
+#include <beman/indirect/detail/type_name.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <string_view>
+
+namespace beman::indirect::detail {
+
+inline constexpr std::size_t live_shards = 16;
+
+// One shard of a type's counters, on a cache line of its own so that threads
+// updating different shards do not contend. A block destroyed on another
+// thread than the one that created it is taken off a different shard, so a
+// single shard may wrap around; only the sum over all shards is meaningful.
+struct alignas(64) live_shard {
+    std::atomic<std::size_t> objects{0};
+    std::atomic<std::size_t> bytes{0};
+};
+
+struct live_type_entry;
+
+// Every type that has had a control block, most recently registered first.
+inline std::atomic<live_type_entry*> live_types{nullptr};
+
+// Live control block counters for one dynamic type. Created on first use and
+// pushed onto live_types; never removed.
+struct live_type_entry {
+    live_shard       shards[live_shards];
+    const void*      tag;
+    std::string_view name;
+    live_type_entry* next;
+
+    live_type_entry(const void* type_tag, std::string_view spelling) noexcept
+        : tag(type_tag), name(spelling), next(live_types.load(std::memory_order_relaxed)) {
+        while (!live_types.compare_exchange_weak(next, this, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+
+    live_type_entry(const live_type_entry&)            = delete;
+    live_type_entry& operator=(const live_type_entry&) = delete;
+};
+
+// The shard the calling thread updates. Threads take shards round robin.
+inline std::size_t live_shard_index() noexcept {
+    static std::atomic<std::size_t> next_index{0};
+    thread_local const std::size_t  index = next_index.fetch_add(1, std::memory_order_relaxed) % live_shards;
+    return index;
+}
+
+template <class U>
+live_type_entry& live_entry(const void* tag) noexcept {
+    static live_type_entry entry(tag, type_name<U>());
+    return entry;
+}
+
+// Called when a control block of `bytes` bytes holding a U, identified by
+// tag, is created or destroyed. Blocks in constant evaluation are not counted.
+template <class U>
+constexpr void live_object_added(const void* tag, std::size_t bytes) noexcept {
+    if (is_constant_evaluated())
+        return;
+    live_shard& s = live_entry<U>(tag).shards[live_shard_index()];
+    s.objects.fetch_add(1, std::memory_order_relaxed);
+    s.bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+template <class U>
+constexpr void live_object_removed(const void* tag, std::size_t bytes) noexcept {
+    if (is_constant_evaluated())
+        return;
+    live_shard& s = live_entry<U>(tag).shards[live_shard_index()];
+    s.objects.fetch_sub(1, std::memory_order_relaxed);
+    s.bytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+} // namespace beman::indirect::detail
+
+#endif // BEMAN_INDIRECT_DETAIL_LIVE_OBJECTS_HPP
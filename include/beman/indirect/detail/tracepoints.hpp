@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef BEMAN_INDIRECT_DETAIL_TRACEPOINTS_HPP
+#define BEMAN_INDIRECT_DETAIL_TRACEPOINTS_HPP
+
+#include <beman/indirect/detail/config.hpp>
+#include <beman/indirect/detail/type_name.hpp>
+
+#if BEMAN_INDIRECT_USE_TRACEPOINTS
+
+#include <cstddef>
+#include <cstdint>
+
+#include <sys/sdt.h>
+
+namespace beman::indirect::detail {
+
+// USDT probes of provider beman_indirect, compiled in with
+// BEMAN_INDIRECT_USE_TRACEPOINTS. Each carries the type_name_hash_v of the
+// type involved and the size in bytes of the allocation:
+//
+//   indirect_construct, indirect_destroy          T and sizeof(T)
+//   polymorphic_construct, polymorphic_clone,
+//   polymorphic_move_clone, polymorphic_destroy   U and the control block size
+//
+// An unattached probe is a single nop. The probes are plain functions so
+// that constexpr callers can skip them during constant evaluation.
+
+inline void probe_indirect_construct(std::uint64_t type_hash, std::size_t bytes) noexcept {
+    DTRACE_PROBE2(beman_indirect, indirect_construct, type_hash, bytes);
+}
+
+inline void probe_indirect_destroy(std::uint64_t type_hash, std::size_t bytes) noexcept {
+    DTRACE_PROBE2(beman_indirect, indirect_destroy, type_hash, bytes);
+}
+
+inline void probe_polymorphic_construct(std::uint64_t type_hash, std::size_t bytes) noexcept {
+    DTRACE_PROBE2(beman_indirect, polymorphic_construct, type_hash, bytes);
+}
+
+inline void probe_polymorphic_clone(std::uint64_t type_hash, std::size_t bytes) noexcept {
+    DTRACE_PROBE2(beman_indirect, polymorphic_clone, type_hash, bytes);
+}
+
+inline void probe_polymorphic_move_clone(std::uint64_t type_hash, std::size_t bytes) noexcept {
+    DTRACE_PROBE2(beman_indirect, polymorphic_move_clone, type_hash, bytes);
+}
+
+inline void probe_polymorphic_destroy(std::uint64_t type_hash, std::size_t bytes) noexcept {
+    DTRACE_PROBE2(beman_indirect, polymorphic_destroy, type_hash, bytes);
+}
+
+} // namespace beman::indirect::detail
+
+#endif // BEMAN_INDIRECT_USE_TRACEPOINTS
+
+#endif // BEMAN_INDIRECT_DETAIL_TRACEPOINTS_HPP
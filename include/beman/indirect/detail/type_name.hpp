@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef BEMAN_INDIRECT_DETAIL_TYPE_NAME_HPP
+#define BEMAN_INDIRECT_DETAIL_TYPE_NAME_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace beman::indirect::detail {
+
+// U's name as the compiler spells it, or empty where that is not available.
+template <class U>
+constexpr std::string_view type_name() noexcept {
+#if defined(__clang__) || defined(__GNUC__)
+    // "... type_name() [with U = Name; ...]" or "... [U = Name]"
+    constexpr std::string_view f     = __PRETTY_FUNCTION__;
+    constexpr std::size_t      begin = f.find("U = ") + 4;
+    return f.substr(begin, f.find_first_of(";]", begin) - begin);
+#elif defined(_MSC_VER)
+    // "... type_name<Name>(void) noexcept"
+    constexpr std::string_view f     = __FUNCSIG__;
+    constexpr std::size_t      begin = f.find("type_name<") + 10;
+    return f.substr(begin, f.rfind(">(void)") - begin);
+#else
+    return {};
+#endif
+}
+
+// 64-bit FNV-1a.
+constexpr std::uint64_t fnv1a(std::string_view s) noexcept {
+    std::uint64_t h = 14695981039346656037u;
+    for (char c : s) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211u;
+    }
+    return h;
+}
+
+// A stable 64-bit identifier for U across processes built by the same
+// compiler: the FNV-1a hash of type_name<U>().
+template <class U>
+inline constexpr std::uint64_t type_name_hash_v = fnv1a(type_name<U>());
+
+} // namespace beman::indirect::detail
+
+#endif // BEMAN_INDIRECT_DETAIL_TYPE_NAME_HPP
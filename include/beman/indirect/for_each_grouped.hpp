@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef BEMAN_INDIRECT_FOR_EACH_GROUPED_HPP
+#define BEMAN_INDIRECT_FOR_EACH_GROUPED_HPP
+
+#include <beman/indirect/polymorphic.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace beman::indirect {
+
+namespace detail {
+
+// Index of the first of Us... whose type id is id, or sizeof...(Us) if there
+// is none.
+template <class... Us>
+std::size_t grouped_index(polymorphic_type_id id) noexcept {
+    const polymorphic_type_id ids[] = {polymorphic_type_id::of<Us>()..., id};
+    std::size_t               index = 0;
+    while (ids[index] != id)
+        ++index;
+    return index;
+}
+
+// Calls f on the objects in [first, last), each as a U.
+template <class U, class Object, class F>
+void grouped_run(Object* const* first, Object* const* last, F& f) {
+    using target = std::conditional_t<std::is_const_v<Object>, const U, U>;
+    for (; first != last; ++first)
+        f(static_cast<target&>(**first));
+}
+
+template <class... Us, class Object, class F, std::size_t... I>
+void grouped_run_all(const std::vector<Object*>& sorted, const std::size_t* starts, F& f, std::index_sequence<I...>) {
+    (grouped_run<Us>(sorted.data() + starts[I], sorted.data() + starts[I + 1], f), ...);
+}
+
+} // namespace detail
+
+// for_each_grouped: calls f on the object owned by every handle in range,
+// grouped by dynamic type.
+//
+// range holds handles with polymorphic's dynamic type queries: polymorphic or
+// sealed_polymorphic. One pass over it sorts the objects whose dynamic type is
+// exactly one of Us... into a bucket per type, with a counting sort into a
+// single array; f is then called on each bucket in turn, with the objects as
+// U&. Each U gets its own instantiation of f's body, in which calls resolve
+// statically when U is final, instead of a virtual call per element. The
+// remaining objects are passed to f last, as T&. Valueless handles are
+// skipped.
+//
+// Objects keep their range order within a bucket; buckets are visited in the
+// order of Us.... f must accept every U& and T&, as a generic lambda does.
+// Returns f, as std::for_each does.
+template <class... Us, class Range, class F>
+F for_each_grouped(Range&& range, F f) {
+    using object = std::remove_reference_t<decltype(**std::begin(range))>;
+
+    constexpr std::size_t groups = sizeof...(Us) + 1;
+
+    // Counting sort: record each object's group, then lay the objects out
+    // group by group, keeping range order within a group.
+    std::vector<std::pair<std::size_t, object*>> tagged;
+    std::size_t                                  starts[groups + 1] = {};
+    for (auto&& h : range) {
+        const polymorphic_type_id id = h.type_id();
+        if (id == polymorphic_type_id())
+            continue;
+        const std::size_t g = detail::grouped_index<Us...>(id);
+        tagged.emplace_back(g, std::addressof(*h));
+        ++starts[g + 1];
+    }
+    for (std::size_t g = 0; g < groups; ++g)
+        starts[g + 1] += starts[g];
+
+    std::vector<object*> sorted(tagged.size());
+    std::size_t          next[groups];
+    std::copy(starts, starts + groups, next);
+    for (const auto& [g, p] : tagged)
+        sorted[next[g]++] = p;
+
+    detail::grouped_run_all<Us...>(sorted, starts, f, std::index_sequence_for<Us...>());
+    for (std::size_t i = starts[groups - 1]; i < starts[groups]; ++i)
+        f(*sorted[i]);
+    return f;
+}
+
+} // namespace beman::indirect
+
+#endif // BEMAN_INDIRECT_FOR_EACH_GROUPED_HPP
@@ -0,0 +1,279 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef BEMAN_INDIRECT_HASHED_INDIRECT_HPP
+#define BEMAN_INDIRECT_HASHED_INDIRECT_HPP
+
+#include <beman/indirect/detail/config.hpp>
+#include <beman/indirect/detail/synth_three_way.hpp>
+#include <beman/indirect/indirect.hpp>
+#include <beman/indirect/relocate.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+namespace beman::indirect {
+
+template <class T, class Allocator, class Hash>
+class hashed_indirect;
+
+namespace detail {
+
+template <class>
+inline constexpr bool is_hashed_indirect_v = false;
+
+template <class T, class A, class H>
+inline constexpr bool is_hashed_indirect_v<hashed_indirect<T, A, H>> = true;
+
+} // namespace detail
+
+// hashed_indirect: indirect that caches Hash{}(value).
+//
+// The hash is computed when a value is constructed, assigned or emplaced and
+// kept in the handle, next to the pointer, so hashing and most unequal
+// comparisons never touch the owned object. Mutable access through operator*
+// or operator-> marks the cache stale. A stale handle still hashes correctly,
+// computing the hash on each call, until update_hash() or the next assignment
+// refreshes it. const member functions never write the cache, so a handle can
+// be hashed and compared from several threads at once, as with indirect.
+template <class T, class Allocator = std::allocator<T>, class Hash = std::hash<T>>
+class hashed_indirect {
+    static_assert(std::is_default_constructible_v<Hash>, "Hash must be default constructible");
+
+    using indirect_type = indirect<T, Allocator>;
+
+  public:
+    using value_type     = T;
+    using allocator_type = Allocator;
+    using hasher         = Hash;
+    using pointer        = typename indirect_type::pointer;
+    using const_pointer  = typename indirect_type::const_pointer;
+
+    // constructors
+    //
+    // Every constructor of indirect<T, Allocator> is available, with the same
+    // arguments and allocator behaviour.
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class... Args>
+        requires(!(sizeof...(Args) == 1 && (detail::is_hashed_indirect_v<detail::remove_cvref_t<Args>> && ...)) &&
+                 std::is_constructible_v<indirect_type, Args...>)
+#else
+    template <class... Args,
+              std::enable_if_t<!(sizeof...(Args) == 1 &&
+                                 (detail::is_hashed_indirect_v<detail::remove_cvref_t<Args>> && ...)) &&
+                                   std::is_constructible_v<indirect_type, Args...>,
+                               int> = 0>
+#endif
+    constexpr explicit hashed_indirect(Args&&... args) : value_(std::forward<Args>(args)...) {
+        update_hash();
+    }
+
+    constexpr hashed_indirect(const hashed_indirect&) = default;
+    constexpr hashed_indirect(hashed_indirect&&)      = default;
+
+    constexpr hashed_indirect(std::allocator_arg_t, const Allocator& a, const hashed_indirect& other)
+        : value_(std::allocator_arg, a, other.value_), hash_(other.hash_), fresh_(other.fresh_) {}
+
+    constexpr hashed_indirect(std::allocator_arg_t, const Allocator& a, hashed_indirect&& other) noexcept(
+        std::allocator_traits<Allocator>::is_always_equal::value)
+        : value_(std::allocator_arg, a, std::move(other.value_)), hash_(other.hash_), fresh_(other.fresh_) {}
+
+    // assignment
+
+    constexpr hashed_indirect& operator=(const hashed_indirect&) = default;
+    constexpr hashed_indirect& operator=(hashed_indirect&&)      = default;
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U = T>
+        requires(!detail::is_hashed_indirect_v<detail::remove_cvref_t<U>> && std::is_assignable_v<indirect_type&, U>)
+#else
+    template <class U = T,
+              std::enable_if_t<!detail::is_hashed_indirect_v<detail::remove_cvref_t<U>> &&
+                                   std::is_assignable_v<indirect_type&, U>,
+                               int> = 0>
+#endif
+    constexpr hashed_indirect& operator=(U&& u) {
+        fresh_ = false;
+        value_ = std::forward<U>(u);
+        update_hash();
+        return *this;
+    }
+
+    // Rebuild the owned value in place; see indirect::emplace.
+    template <class... Us>
+    constexpr auto emplace(Us&&... us) -> decltype(std::declval<indirect_type&>().emplace(std::forward<Us>(us)...)) {
+        fresh_ = false;
+        T& result = value_.emplace(std::forward<Us>(us)...);
+        update_hash();
+        return result;
+    }
+
+    // observers
+
+    constexpr const T& operator*() const& noexcept { return *value_; }
+
+    constexpr T& operator*() & noexcept {
+        fresh_ = false;
+        return *value_;
+    }
+
+    constexpr const T&& operator*() const&& noexcept { return *std::move(value_); }
+
+    constexpr T&& operator*() && noexcept {
+        fresh_ = false;
+        return *std::move(value_);
+    }
+
+    constexpr const_pointer operator->() const noexcept { return value_.operator->(); }
+
+    constexpr pointer operator->() noexcept {
+        fresh_ = false;
+        return value_.operator->();
+    }
+
+    constexpr bool valueless_after_move() const noexcept { return value_.valueless_after_move(); }
+
+    constexpr allocator_type get_allocator() const noexcept { return value_.get_allocator(); }
+
+    // Hash of the owned value, as std::hash<indirect<T, Allocator>> would
+    // compute it with Hash. Served from the cache unless the handle is stale.
+    constexpr std::size_t hash() const noexcept(std::is_nothrow_invocable_v<Hash, const T&>) {
+        if (valueless_after_move())
+            return static_cast<std::size_t>(-1);
+        if (fresh_)
+            return hash_;
+        return Hash{}(*value_);
+    }
+
+    // True when hash() is served from the cache.
+    constexpr bool hash_is_cached() const noexcept { return fresh_ && !valueless_after_move(); }
+
+    // Recompute and cache the hash after the value was modified in place.
+    constexpr void update_hash() {
+        if (valueless_after_move())
+            return;
+        hash_  = Hash{}(*value_);
+        fresh_ = true;
+    }
+
+    // swap
+
+    constexpr void swap(hashed_indirect& other) noexcept(noexcept(std::declval<indirect_type&>().swap(other.value_))) {
+        using std::swap;
+        swap(value_, other.value_);
+        swap(hash_, other.hash_);
+        swap(fresh_, other.fresh_);
+    }
+
+    friend constexpr void swap(hashed_indirect& lhs, hashed_indirect& rhs) noexcept(noexcept(lhs.swap(rhs))) {
+        lhs.swap(rhs);
+    }
+
+    // relational operators
+    //
+    // Two handles whose cached hashes differ hold unequal values, so equality
+    // only dereferences when the hashes match or one of them is stale.
+
+    friend constexpr bool operator==(const hashed_indirect& lhs,
+                                     const hashed_indirect& rhs) noexcept(noexcept(lhs.value_ == rhs.value_)) {
+        if (lhs.hash_is_cached() && rhs.hash_is_cached() && lhs.hash_ != rhs.hash_)
+            return false;
+        return lhs.value_ == rhs.value_;
+    }
+
+#if BEMAN_INDIRECT_USE_THREE_WAY_COMPARISON
+    friend constexpr auto operator<=>(const hashed_indirect& lhs, const hashed_indirect& rhs)
+        -> detail::synth_three_way_result<T> {
+        return lhs.value_ <=> rhs.value_;
+    }
+#else
+    friend constexpr bool operator!=(const hashed_indirect& lhs,
+                                     const hashed_indirect& rhs) noexcept(noexcept(lhs == rhs)) {
+        return !(lhs == rhs);
+    }
+
+    friend constexpr bool operator<(const hashed_indirect& lhs, const hashed_indirect& rhs) {
+        return lhs.value_ < rhs.value_;
+    }
+
+    friend constexpr bool operator>(const hashed_indirect& lhs, const hashed_indirect& rhs) { return rhs < lhs; }
+
+    friend constexpr bool operator<=(const hashed_indirect& lhs, const hashed_indirect& rhs) { return !(rhs < lhs); }
+
+    friend constexpr bool operator>=(const hashed_indirect& lhs, const hashed_indirect& rhs) { return !(lhs < rhs); }
+#endif // BEMAN_INDIRECT_USE_THREE_WAY_COMPARISON
+
+    // equality with T
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U>
+        requires(!detail::is_hashed_indirect_v<U>)
+    friend constexpr bool operator==(const hashed_indirect& lhs, const U& rhs) noexcept(noexcept(lhs.value_ == rhs)) {
+        return lhs.value_ == rhs;
+    }
+#else
+    template <class U, std::enable_if_t<!detail::is_hashed_indirect_v<U>, int> = 0>
+    friend constexpr bool operator==(const hashed_indirect& lhs, const U& rhs) noexcept(noexcept(lhs.value_ == rhs)) {
+        return lhs.value_ == rhs;
+    }
+
+    template <class U, std::enable_if_t<!detail::is_hashed_indirect_v<U>, int> = 0>
+    friend constexpr bool operator==(const U& lhs, const hashed_indirect& rhs) noexcept(noexcept(rhs == lhs)) {
+        return rhs == lhs;
+    }
+
+    template <class U, std::enable_if_t<!detail::is_hashed_indirect_v<U>, int> = 0>
+    friend constexpr bool operator!=(const hashed_indirect& lhs, const U& rhs) noexcept(noexcept(lhs == rhs)) {
+        return !(lhs == rhs);
+    }
+
+    template <class U, std::enable_if_t<!detail::is_hashed_indirect_v<U>, int> = 0>
+    friend constexpr bool operator!=(const U& lhs, const hashed_indirect& rhs) noexcept(noexcept(rhs == lhs)) {
+        return !(rhs == lhs);
+    }
+#endif // BEMAN_INDIRECT_USE_CONCEPTS
+
+  private:
+    // hash_ is meaningful only while fresh_ is set.
+    indirect_type value_;
+    std::size_t   hash_  = 0;
+    bool          fresh_ = false;
+};
+
+// The handle is an indirect plus the cached hash; Hash is never stored.
+template <class T, class Allocator, class Hash>
+struct is_trivially_relocatable<hashed_indirect<T, Allocator, Hash>>
+    : is_trivially_relocatable<indirect<T, Allocator>> {};
+
+// Deduction guides
+template <class Value>
+hashed_indirect(Value) -> hashed_indirect<Value>;
+
+template <class Allocator, class Value>
+hashed_indirect(std::allocator_arg_t, Allocator, Value)
+    -> hashed_indirect<Value, typename std::allocator_traits<Allocator>::template rebind_alloc<Value>>;
+
+} // namespace beman::indirect
+
+template <class T, class Allocator, class Hash>
+struct std::hash<beman::indirect::hashed_indirect<T, Allocator, Hash>> {
+    constexpr std::size_t operator()(const beman::indirect::hashed_indirect<T, Allocator, Hash>& h) const
+        noexcept(noexcept(h.hash())) {
+        return h.hash();
+    }
+};
+
+namespace beman::indirect::pmr {
+
+template <class T, class Hash = std::hash<T>>
+using hashed_indirect = beman::indirect::hashed_indirect<T, std::pmr::polymorphic_allocator<T>, Hash>;
+
+} // namespace beman::indirect::pmr
+
+#endif // BEMAN_INDIRECT_HASHED_INDIRECT_HPP
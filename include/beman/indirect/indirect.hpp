@@ -3,8 +3,18 @@
 #ifndef BEMAN_INDIRECT_INDIRECT_HPP
 #define BEMAN_INDIRECT_INDIRECT_HPP
 
+#include <beman/indirect/arena.hpp>
 #include <beman/indirect/detail/config.hpp>
 #include <beman/indirect/detail/synth_three_way.hpp>
+#include <beman/indirect/relocate.hpp>
+
+#if BEMAN_INDIRECT_USE_LATENCY_HOOKS
+#include <beman/indirect/latency_histogram.hpp>
+#endif
+
+#if BEMAN_INDIRECT_USE_TRACEPOINTS
+#include <beman/indirect/detail/tracepoints.hpp>
+#endif
 
 #include <cassert>
 #include <functional>
@@ -20,8 +30,16 @@ namespace beman::indirect {
 template <class T, class Allocator>
 class indirect;
 
+template <class T, class Allocator>
+class optional_indirect;
+
 namespace detail {
 
+// Selects indirect's private constructor of a valueless handle.
+struct valueless_t {
+    explicit valueless_t() = default;
+};
+
 // Trait to detect indirect specializations.
 // Used to prevent recursive constraint evaluation in comparison-with-T operators.
 template <class>
@@ -276,6 +294,45 @@ class indirect {
         return *this;
     }
 
+    // Extension: emplace
+
+    // Replaces the owned value with one constructed from us, reusing the
+    // existing allocation. A valueless indirect allocates as on construction.
+    // If constructing the new value throws, the old value has already been
+    // destroyed: the allocation is released and *this is left valueless
+    // (basic guarantee). us must not refer to the current value.
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class... Us>
+        requires std::is_constructible_v<T, Us...>
+#else
+    template <class... Us, std::enable_if_t<std::is_constructible_v<T, Us...>, int> = 0>
+#endif
+    constexpr T& emplace(Us&&... us) {
+        if (valueless_after_move()) {
+            p_ = construct_from(alloc_, std::forward<Us>(us)...);
+        } else {
+            reconstruct(std::forward<Us>(us)...);
+        }
+        return *p_;
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class I, class... Us>
+        requires std::is_constructible_v<T, std::initializer_list<I>&, Us...>
+#else
+    template <class I,
+              class... Us,
+              std::enable_if_t<std::is_constructible_v<T, std::initializer_list<I>&, Us...>, int> = 0>
+#endif
+    constexpr T& emplace(std::initializer_list<I> ilist, Us&&... us) {
+        if (valueless_after_move()) {
+            p_ = construct_from(alloc_, ilist, std::forward<Us>(us)...);
+        } else {
+            reconstruct(ilist, std::forward<Us>(us)...);
+        }
+        return *p_;
+    }
+
     // [indirect.obs] observers
 
     constexpr const T& operator*() const& noexcept {
@@ -472,8 +529,17 @@ class indirect {
 #endif     // BEMAN_INDIRECT_USE_THREE_WAY_COMPARISON
 
   private:
+    template <class, class>
+    friend class optional_indirect;
+
+    // A valueless handle that has never allocated: optional_indirect's empty state.
+    constexpr indirect(detail::valueless_t, const Allocator& a) noexcept : alloc_(a) {}
+
     template <class... Args>
     static constexpr pointer construct_from(Allocator& a, Args&&... args) {
+#if BEMAN_INDIRECT_USE_LATENCY_HOOKS
+        const std::uint64_t start = detail::latency_start();
+#endif
         pointer p = alloc_traits::allocate(a, 1);
         try {
             alloc_traits::construct(a, detail::to_address_impl(p), std::forward<Args>(args)...);
@@ -481,19 +547,52 @@ class indirect {
             alloc_traits::deallocate(a, p, 1);
             throw;
         }
+#if BEMAN_INDIRECT_USE_LATENCY_HOOKS
+        detail::latency_stop(latency_op::indirect_construct, start);
+#endif
+#if BEMAN_INDIRECT_USE_TRACEPOINTS
+        if (!detail::is_constant_evaluated())
+            detail::probe_indirect_construct(detail::type_name_hash_v<T>, sizeof(T));
+#endif
         return p;
     }
 
     static constexpr void destroy_with(Allocator& a, pointer p) {
+#if BEMAN_INDIRECT_USE_TRACEPOINTS
+        if (!detail::is_constant_evaluated())
+            detail::probe_indirect_destroy(detail::type_name_hash_v<T>, sizeof(T));
+#endif
+#if BEMAN_INDIRECT_USE_LATENCY_HOOKS
+        const std::uint64_t start = detail::latency_start();
+#endif
         alloc_traits::destroy(a, detail::to_address_impl(p));
         alloc_traits::deallocate(a, p, 1);
+#if BEMAN_INDIRECT_USE_LATENCY_HOOKS
+        detail::latency_stop(latency_op::indirect_destroy, start);
+#endif
     }
 
-    constexpr void reset() {
-        if (p_) {
-            destroy_with(alloc_, p_);
+    // Destroy the owned value and construct a new one in the same allocation.
+    template <class... Args>
+    constexpr void reconstruct(Args&&... args) {
+        alloc_traits::destroy(alloc_, detail::to_address_impl(p_));
+        try {
+            alloc_traits::construct(alloc_, detail::to_address_impl(p_), std::forward<Args>(args)...);
+        } catch (...) {
+            alloc_traits::deallocate(alloc_, p_, 1);
             p_ = nullptr;
+            throw;
+        }
+    }
+
+    constexpr void reset() {
+        // In arena mode the value needs no destructor and its memory goes back
+        // with the arena, so the pointer is simply forgotten.
+        if constexpr (!(is_arena_allocator_v<Allocator> && is_arena_discardable_v<T>)) {
+            if (p_)
+                destroy_with(alloc_, p_);
         }
+        p_ = nullptr;
     }
 
     pointer                                    p_     = pointer();
@@ -508,6 +607,19 @@ template <class Allocator, class Value>
 indirect(std::allocator_arg_t, Allocator, Value)
     -> indirect<Value, typename std::allocator_traits<Allocator>::template rebind_alloc<Value>>;
 
+// An indirect is its pointer and its allocator. A fancy pointer that depends
+// on its own address has a user-provided copy constructor, so it is not
+// trivially relocatable and neither is the indirect.
+template <class T, class Allocator>
+struct is_trivially_relocatable<indirect<T, Allocator>>
+    : std::bool_constant<is_trivially_relocatable_v<typename std::allocator_traits<Allocator>::pointer> &&
+                         is_trivially_relocatable_v<Allocator>> {};
+
+// In arena mode the handle's destructor does nothing.
+template <class T, class Allocator>
+struct is_arena_discardable<indirect<T, Allocator>>
+    : std::bool_constant<is_arena_allocator_v<Allocator> && is_arena_discardable_v<T>> {};
+
 } // namespace beman::indirect
 
 // [indirect.hash] Hash support
@@ -0,0 +1,497 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef BEMAN_INDIRECT_INDIRECT_VARIANT_HPP
+#define BEMAN_INDIRECT_INDIRECT_VARIANT_HPP
+
+#include <beman/indirect/detail/config.hpp>
+#include <beman/indirect/detail/synth_three_way.hpp>
+#include <beman/indirect/relocate.hpp>
+#include <beman/indirect/sealed_polymorphic.hpp>
+
+#include <cassert>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace beman::indirect {
+
+namespace detail {
+
+// Number of bits needed to store every value from 0 to n.
+constexpr std::size_t variant_tag_bits(std::size_t n) noexcept {
+    std::size_t bits = 0;
+    while ((n >> bits) != 0)
+        ++bits;
+    return bits;
+}
+
+// The unsigned integer exactly Size bytes wide, if there is one.
+template <std::size_t Size>
+struct variant_payload {};
+
+template <>
+struct variant_payload<1> {
+    using type = std::uint8_t;
+};
+
+template <>
+struct variant_payload<2> {
+    using type = std::uint16_t;
+};
+
+template <>
+struct variant_payload<4> {
+    using type = std::uint32_t;
+};
+
+// True when a U can be kept in the bits of an indirect_variant's word above
+// its TagBits tag bits: U is trivially copyable and exactly as wide as an
+// unsigned integer that fits there.
+template <class U, std::size_t TagBits>
+inline constexpr bool variant_inline_v = std::is_trivially_copyable_v<U> &&
+                                         (sizeof(U) == 1 || sizeof(U) == 2 || sizeof(U) == 4) &&
+                                         sizeof(U) * CHAR_BIT + TagBits <= sizeof(std::uintptr_t) * CHAR_BIT;
+
+} // namespace detail
+
+// indirect_variant: a variant in one word.
+//
+// std::variant is as large as its largest alternative, even when the large
+// alternatives are only there behind an indirect. indirect_variant is a
+// single std::uintptr_t instead. Its low bits hold the index of the
+// alternative. A small trivially copyable alternative (one, two or four bytes
+// that fit next to the index) is kept in the remaining bits. Any other
+// alternative is boxed on the heap, as indirect<U> would box it, in an
+// allocation aligned so that the low bits of its address are free for the
+// index. The alternatives may be incomplete where indirect_variant is named,
+// so recursive types such as a JSON value can hold themselves.
+//
+// Copies are deep and comparisons are by value, as for indirect and
+// std::variant. Moving from a handle leaves it valueless. Inline alternatives
+// have no address: get<U>() returns them by value, and visit passes a const
+// reference to a copy, which f must not return. Like sealed_polymorphic, this
+// type is not usable in constant expressions.
+template <class... Ts>
+class indirect_variant {
+    static_assert(sizeof...(Ts) > 0, "indirect_variant needs at least one alternative");
+    static_assert((std::is_object_v<Ts> && ...), "alternatives must be object types");
+    static_assert((!std::is_array_v<Ts> && ...), "alternatives must not be array types");
+    static_assert((std::is_same_v<detail::remove_cvref_t<Ts>, Ts> && ...), "alternatives must not be cv-qualified");
+    static_assert(detail::sealed_distinct<Ts...>(), "alternatives must be distinct");
+
+    template <std::size_t I>
+    using alternative = std::tuple_element_t<I, std::tuple<Ts...>>;
+
+    template <class U>
+    static constexpr bool is_alternative_v = detail::sealed_index_of<U, Ts...>() < sizeof...(Ts);
+
+    // Tags 0 to N - 1 are the alternatives; tag N is the valueless state.
+    static constexpr std::size_t    tag_bits       = detail::variant_tag_bits(sizeof...(Ts));
+    static constexpr std::uintptr_t tag_mask       = (std::uintptr_t(1) << tag_bits) - 1;
+    static constexpr std::uintptr_t valueless_word = sizeof...(Ts);
+
+    template <class U>
+    static constexpr std::size_t box_alignment =
+        alignof(U) > (std::size_t(1) << tag_bits) ? alignof(U) : (std::size_t(1) << tag_bits);
+
+  public:
+    static constexpr std::size_t alternatives = sizeof...(Ts);
+
+    // index() of a valueless handle.
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    template <class U>
+    static constexpr std::size_t index_of = detail::sealed_index_of<U, Ts...>();
+
+    // True when the alternative U is kept in the handle's word.
+    template <class U>
+    static constexpr bool stored_inline = detail::variant_inline_v<U, tag_bits>;
+
+    // constructors
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    indirect_variant()
+        requires std::is_default_constructible_v<alternative<0>>
+#else
+    template <class U0 = alternative<0>, std::enable_if_t<std::is_default_constructible_v<U0>, int> = 0>
+    indirect_variant()
+#endif
+        : word_(make<0>()) {
+    }
+
+    indirect_variant(const indirect_variant& other) : word_(other.copy_word()) {}
+
+    indirect_variant(indirect_variant&& other) noexcept : word_(other.word_) { other.word_ = valueless_word; }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U>
+        requires(!std::is_same_v<detail::remove_cvref_t<U>, indirect_variant> &&
+                 is_alternative_v<detail::remove_cvref_t<U>> && std::is_constructible_v<detail::remove_cvref_t<U>, U>)
+#else
+    template <class U,
+              std::enable_if_t<!std::is_same_v<detail::remove_cvref_t<U>, indirect_variant> &&
+                                   is_alternative_v<detail::remove_cvref_t<U>> &&
+                                   std::is_constructible_v<detail::remove_cvref_t<U>, U>,
+                               int> = 0>
+#endif
+    explicit indirect_variant(U&& u) : word_(make<index_of<detail::remove_cvref_t<U>>>(std::forward<U>(u))) {
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U, class... Args>
+        requires(is_alternative_v<U> && std::is_constructible_v<U, Args...>)
+#else
+    template <class U,
+              class... Args,
+              std::enable_if_t<is_alternative_v<U> && std::is_constructible_v<U, Args...>, int> = 0>
+#endif
+    explicit indirect_variant(std::in_place_type_t<U>, Args&&... args)
+        : word_(make<index_of<U>>(std::forward<Args>(args)...)) {
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U, class I, class... Args>
+        requires(is_alternative_v<U> && std::is_constructible_v<U, std::initializer_list<I>&, Args...>)
+#else
+    template <class U,
+              class I,
+              class... Args,
+              std::enable_if_t<is_alternative_v<U> && std::is_constructible_v<U, std::initializer_list<I>&, Args...>,
+                               int> = 0>
+#endif
+    explicit indirect_variant(std::in_place_type_t<U>, std::initializer_list<I> ilist, Args&&... args)
+        : word_(make<index_of<U>>(ilist, std::forward<Args>(args)...)) {
+    }
+
+    // destructor
+
+    ~indirect_variant() { reset(); }
+
+    // assignment
+
+    // Assigns in place when both handles hold the same boxed alternative.
+    // Otherwise copies other first, so a throwing copy leaves *this unchanged.
+    indirect_variant& operator=(const indirect_variant& other) {
+        if (std::addressof(other) == this)
+            return *this;
+        if (!valueless_after_move() && tag() == other.tag()) {
+            bool assigned = dispatch([&](auto i) {
+                using U = alternative<i>;
+                if constexpr (stored_inline<U>) {
+                    word_ = other.word_;
+                    return true;
+                } else if constexpr (std::is_copy_assignable_v<U>) {
+                    *box<U>() = *other.box<U>();
+                    return true;
+                } else {
+                    return false;
+                }
+            });
+            if (assigned)
+                return *this;
+        }
+        const std::uintptr_t w = other.copy_word();
+        reset();
+        word_ = w;
+        return *this;
+    }
+
+    indirect_variant& operator=(indirect_variant&& other) noexcept {
+        if (std::addressof(other) == this)
+            return *this;
+        reset();
+        word_       = other.word_;
+        other.word_ = valueless_word;
+        return *this;
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U>
+        requires(!std::is_same_v<detail::remove_cvref_t<U>, indirect_variant> &&
+                 is_alternative_v<detail::remove_cvref_t<U>> && std::is_constructible_v<detail::remove_cvref_t<U>, U>)
+#else
+    template <class U,
+              std::enable_if_t<!std::is_same_v<detail::remove_cvref_t<U>, indirect_variant> &&
+                                   is_alternative_v<detail::remove_cvref_t<U>> &&
+                                   std::is_constructible_v<detail::remove_cvref_t<U>, U>,
+                               int> = 0>
+#endif
+    indirect_variant& operator=(U&& u) {
+        using V = detail::remove_cvref_t<U>;
+        if constexpr (!stored_inline<V> && std::is_assignable_v<V&, U>) {
+            if (holds<V>()) {
+                *box<V>() = std::forward<U>(u);
+                return *this;
+            }
+        }
+        emplace<V>(std::forward<U>(u));
+        return *this;
+    }
+
+    // Replaces the alternative with a U constructed from args. The new value is
+    // constructed before the old one is destroyed, so if that throws *this is
+    // unchanged, and args may refer to the current value.
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U, class... Args>
+        requires(is_alternative_v<U> && std::is_constructible_v<U, Args...>)
+#else
+    template <class U,
+              class... Args,
+              std::enable_if_t<is_alternative_v<U> && std::is_constructible_v<U, Args...>, int> = 0>
+#endif
+    void emplace(Args&&... args) {
+        const std::uintptr_t w = make<index_of<U>>(std::forward<Args>(args)...);
+        reset();
+        word_ = w;
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U, class I, class... Args>
+        requires(is_alternative_v<U> && std::is_constructible_v<U, std::initializer_list<I>&, Args...>)
+#else
+    template <class U,
+              class I,
+              class... Args,
+              std::enable_if_t<is_alternative_v<U> && std::is_constructible_v<U, std::initializer_list<I>&, Args...>,
+                               int> = 0>
+#endif
+    void emplace(std::initializer_list<I> ilist, Args&&... args) {
+        const std::uintptr_t w = make<index_of<U>>(ilist, std::forward<Args>(args)...);
+        reset();
+        word_ = w;
+    }
+
+    // observers
+
+    bool valueless_after_move() const noexcept { return word_ == valueless_word; }
+
+    // Position of the alternative's type in Ts..., or npos if valueless.
+    std::size_t index() const noexcept { return valueless_after_move() ? npos : tag(); }
+
+    template <class U>
+    bool holds() const noexcept {
+        static_assert(is_alternative_v<U>, "U must be one of the alternatives");
+        return word_ != valueless_word && tag() == index_of<U>;
+    }
+
+    // The held U: by value if it is stored inline, otherwise by reference to
+    // the boxed object. holds<U>() must be true.
+    template <class U>
+    decltype(auto) get() const noexcept {
+        assert(holds<U>());
+        if constexpr (stored_inline<U>)
+            return load<U>();
+        else
+            return static_cast<const U&>(*box<U>());
+    }
+
+    template <class U>
+    decltype(auto) get() noexcept {
+        assert(holds<U>());
+        if constexpr (stored_inline<U>)
+            return load<U>();
+        else
+            return static_cast<U&>(*box<U>());
+    }
+
+    // Pointer to the boxed U if that is the alternative held, else null.
+    // Inline alternatives have no address; use get or visit for them.
+    template <class U>
+    U* get_if() noexcept {
+        if constexpr (is_alternative_v<U>) {
+            static_assert(!stored_inline<U>, "inline alternatives have no address; use get<U>() instead");
+            return holds<U>() ? box<U>() : nullptr;
+        } else {
+            return nullptr;
+        }
+    }
+
+    template <class U>
+    const U* get_if() const noexcept {
+        return const_cast<indirect_variant&>(*this).template get_if<U>();
+    }
+
+    // Returns f(u), where u is the held alternative as its own type U, by
+    // reference for boxed alternatives and as a const reference to a copy for
+    // inline ones. f must return the same type for every alternative. *this
+    // must not be valueless.
+    template <class F>
+    decltype(auto) visit(F&& f) {
+        return visit_impl<indirect_variant>(*this, f);
+    }
+
+    template <class F>
+    decltype(auto) visit(F&& f) const {
+        return visit_impl<const indirect_variant>(*this, f);
+    }
+
+    // swap
+
+    void swap(indirect_variant& other) noexcept { std::swap(word_, other.word_); }
+
+    friend void swap(indirect_variant& lhs, indirect_variant& rhs) noexcept { lhs.swap(rhs); }
+
+    // relational operators
+    //
+    // As for std::variant: a valueless handle is equal to another valueless
+    // one and less than any other, handles holding different alternatives
+    // order by index, and otherwise the values are compared.
+
+    friend bool operator==(const indirect_variant& lhs, const indirect_variant& rhs) {
+        if (lhs.index() != rhs.index())
+            return false;
+        if (lhs.valueless_after_move())
+            return true;
+        return lhs.dispatch([&](auto i) -> bool {
+            using U = alternative<i>;
+            return lhs.template get<U>() == rhs.template get<U>();
+        });
+    }
+
+#if BEMAN_INDIRECT_USE_THREE_WAY_COMPARISON
+    friend auto operator<=>(const indirect_variant& lhs, const indirect_variant& rhs) {
+        using R = std::common_comparison_category_t<detail::synth_three_way_result<Ts>...>;
+        if (lhs.valueless_after_move() || rhs.valueless_after_move())
+            return R(!lhs.valueless_after_move() <=> !rhs.valueless_after_move());
+        if (lhs.index() != rhs.index())
+            return R(lhs.index() <=> rhs.index());
+        return lhs.dispatch([&](auto i) -> R {
+            using U = alternative<i>;
+            return detail::synth_three_way(lhs.template get<U>(), rhs.template get<U>());
+        });
+    }
+#else
+    friend bool operator!=(const indirect_variant& lhs, const indirect_variant& rhs) { return !(lhs == rhs); }
+
+    friend bool operator<(const indirect_variant& lhs, const indirect_variant& rhs) {
+        if (rhs.valueless_after_move())
+            return false;
+        if (lhs.valueless_after_move())
+            return true;
+        if (lhs.index() != rhs.index())
+            return lhs.index() < rhs.index();
+        return lhs.dispatch([&](auto i) -> bool {
+            using U = alternative<i>;
+            return lhs.template get<U>() < rhs.template get<U>();
+        });
+    }
+
+    friend bool operator>(const indirect_variant& lhs, const indirect_variant& rhs) { return rhs < lhs; }
+    friend bool operator<=(const indirect_variant& lhs, const indirect_variant& rhs) { return !(rhs < lhs); }
+    friend bool operator>=(const indirect_variant& lhs, const indirect_variant& rhs) { return !(lhs < rhs); }
+#endif // BEMAN_INDIRECT_USE_THREE_WAY_COMPARISON
+
+  private:
+    std::size_t tag() const noexcept { return static_cast<std::size_t>(word_ & tag_mask); }
+
+    template <class U>
+    U* box() const noexcept {
+        return reinterpret_cast<U*>(word_ & ~tag_mask);
+    }
+
+    template <class U>
+    U load() const noexcept {
+        using payload = typename detail::variant_payload<sizeof(U)>::type;
+        const payload n = static_cast<payload>(word_ >> tag_bits);
+        alignas(U) unsigned char bytes[sizeof(U)];
+        std::memcpy(bytes, &n, sizeof(U));
+        return *std::launder(reinterpret_cast<U*>(bytes));
+    }
+
+    // The word for a new alternative I constructed from args.
+    template <std::size_t I, class... Args>
+    static std::uintptr_t make(Args&&... args) {
+        using U = alternative<I>;
+        if constexpr (stored_inline<U>) {
+            using payload = typename detail::variant_payload<sizeof(U)>::type;
+            alignas(U) unsigned char bytes[sizeof(U)];
+            ::new (static_cast<void*>(bytes)) U(std::forward<Args>(args)...);
+            payload n;
+            std::memcpy(&n, bytes, sizeof(U));
+            return (std::uintptr_t(n) << tag_bits) | I;
+        } else {
+            void* raw = ::operator new(sizeof(U), std::align_val_t(box_alignment<U>));
+            U*    u;
+            try {
+                u = ::new (raw) U(std::forward<Args>(args)...);
+            } catch (...) {
+                ::operator delete(raw, sizeof(U), std::align_val_t(box_alignment<U>));
+                throw;
+            }
+            return reinterpret_cast<std::uintptr_t>(u) | I;
+        }
+    }
+
+    // A word holding a copy of this handle's value.
+    std::uintptr_t copy_word() const {
+        if (valueless_after_move())
+            return valueless_word;
+        return dispatch([&](auto i) -> std::uintptr_t {
+            using U = alternative<i>;
+            if constexpr (stored_inline<U>)
+                return word_;
+            else
+                return make<i>(static_cast<const U&>(*box<U>()));
+        });
+    }
+
+    void reset() noexcept {
+        if (valueless_after_move())
+            return;
+        dispatch([&](auto i) {
+            using U = alternative<i>;
+            if constexpr (!stored_inline<U>) {
+                U* u = box<U>();
+                u->~U();
+                ::operator delete(static_cast<void*>(u), sizeof(U), std::align_val_t(box_alignment<U>));
+            }
+        });
+        word_ = valueless_word;
+    }
+
+    // Calls f(std::integral_constant<std::size_t, tag()>{}). *this must not be
+    // valueless.
+    template <class F>
+    decltype(auto) dispatch(F&& f) const {
+        using R = decltype(f(std::integral_constant<std::size_t, 0>{}));
+        return detail::sealed_dispatch<alternatives, 0, R>(tag(), f);
+    }
+
+    template <std::size_t I, class Self, class F>
+    static decltype(auto) visit_one(Self& self, F& f) {
+        using U = alternative<I>;
+        if constexpr (stored_inline<U>) {
+            const U u = self.template load<U>();
+            return std::forward<F>(f)(u);
+        } else {
+            using ref = std::conditional_t<std::is_const_v<Self>, const U&, U&>;
+            return std::forward<F>(f)(static_cast<ref>(*self.template box<U>()));
+        }
+    }
+
+    template <class Self, class F>
+    static decltype(auto) visit_impl(Self& self, F& f) {
+        using R = decltype(visit_one<0>(self, f));
+        static_assert((std::is_same_v<R, decltype(visit_one<index_of<Ts>>(self, f))> && ...),
+                      "visit requires the same result type for every alternative");
+        assert(!self.valueless_after_move());
+        return self.dispatch([&](auto i) -> R { return visit_one<i>(self, f); });
+    }
+
+    std::uintptr_t word_;
+};
+
+// The handle is a single integer; boxed alternatives never refer back to it.
+template <class... Ts>
+struct is_trivially_relocatable<indirect_variant<Ts...>> : std::true_type {};
+
+} // namespace beman::indirect
+
+#endif // BEMAN_INDIRECT_INDIRECT_VARIANT_HPP
@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef BEMAN_INDIRECT_LATENCY_HISTOGRAM_HPP
+#define BEMAN_INDIRECT_LATENCY_HISTOGRAM_HPP
+
+#include <beman/indirect/detail/config.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace beman::indirect {
+
+// latency_histogram: lock-free log-linear histogram of durations in
+// nanoseconds.
+//
+// Values below 8 get a bucket each; above that every power of two is split
+// into 8 equal buckets, so a bucket is at most 1/8 of its lower bound wide
+// and percentiles are accurate to within 12.5%. All 2^64 values fit in 496
+// buckets. Recording is a few relaxed atomic increments and never blocks.
+// Readers do not stop writers, so a reading taken while other threads record
+// may be slightly out of date.
+class latency_histogram {
+  public:
+    static constexpr std::size_t sub_buckets = 8;
+    static constexpr std::size_t buckets     = (64 - 3 + 1) * sub_buckets;
+
+    constexpr latency_histogram() noexcept = default;
+
+    latency_histogram(const latency_histogram&)            = delete;
+    latency_histogram& operator=(const latency_histogram&) = delete;
+
+    static constexpr std::size_t bucket_of(std::uint64_t ns) noexcept {
+        if (ns < sub_buckets)
+            return static_cast<std::size_t>(ns);
+        const std::size_t e = log2(ns);
+        return (e - 2) * sub_buckets + static_cast<std::size_t>((ns >> (e - 3)) & (sub_buckets - 1));
+    }
+
+    // Smallest and largest value in a bucket.
+    static constexpr std::uint64_t bucket_lower(std::size_t bucket) noexcept {
+        if (bucket < sub_buckets)
+            return bucket;
+        const std::size_t e = bucket / sub_buckets + 2;
+        return (sub_buckets + bucket % sub_buckets) << (e - 3);
+    }
+
+    static constexpr std::uint64_t bucket_upper(std::size_t bucket) noexcept {
+        return bucket + 1 == buckets ? ~std::uint64_t(0) : bucket_lower(bucket + 1) - 1;
+    }
+
+    void record(std::uint64_t ns) noexcept {
+        counts_[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+        total_.fetch_add(ns, std::memory_order_relaxed);
+        std::uint64_t current = max_.load(std::memory_order_relaxed);
+        while (current < ns && !max_.compare_exchange_weak(current, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    std::uint64_t count(std::size_t bucket) const noexcept { return counts_[bucket].load(std::memory_order_relaxed); }
+
+    std::uint64_t count() const noexcept {
+        std::uint64_t n = 0;
+        for (const auto& c : counts_)
+            n += c.load(std::memory_order_relaxed);
+        return n;
+    }
+
+    std::uint64_t total() const noexcept { return total_.load(std::memory_order_relaxed); }
+    std::uint64_t max() const noexcept { return max_.load(std::memory_order_relaxed); }
+
+    // The value below which p percent of the recorded values fall, reported
+    // as the upper bound of its bucket but never above max(). 0 when nothing
+    // has been recorded.
+    std::uint64_t percentile(double p) const noexcept {
+        const std::uint64_t n = count();
+        if (n == 0)
+            return 0;
+        std::uint64_t rank = static_cast<std::uint64_t>(p / 100 * static_cast<double>(n) + 0.5);
+        if (rank < 1)
+            rank = 1;
+        std::uint64_t seen = 0;
+        for (std::size_t b = 0; b < buckets; ++b) {
+            seen += count(b);
+            if (seen >= rank) {
+                const std::uint64_t upper = bucket_upper(b);
+                return upper < max() ? upper : max();
+            }
+        }
+        return max();
+    }
+
+    void reset() noexcept {
+        for (auto& c : counts_)
+            c.store(0, std::memory_order_relaxed);
+        total_.store(0, std::memory_order_relaxed);
+        max_.store(0, std::memory_order_relaxed);
+    }
+
+  private:
+    // Index of the highest set bit, by binary search.
+    static constexpr std::size_t log2(std::uint64_t v) noexcept {
+        std::size_t e = 0;
+        for (std::size_t shift = 32; shift != 0; shift /= 2) {
+            if (v >> shift) {
+                v >>= shift;
+                e += shift;
+            }
+        }
+        return e;
+    }
+
+    std::atomic<std::uint64_t> counts_[buckets] = {};
+    std::atomic<std::uint64_t> total_{0};
+    std::atomic<std::uint64_t> max_{0};
+};
+
+// Operations timed when BEMAN_INDIRECT_USE_LATENCY_HOOKS is on.
+enum class latency_op : unsigned char {
+    indirect_construct,     // allocate and construct an indirect's value
+    indirect_destroy,       // destroy and deallocate an indirect's value
+    polymorphic_construct,  // allocate a control block and construct its object
+    polymorphic_clone,      // copy a control block and its object
+    polymorphic_move_clone, // move an object into a new control block
+    polymorphic_destroy,    // destroy a control block and its object
+};
+
+inline constexpr std::size_t latency_op_count = 6;
+
+namespace detail {
+
+inline latency_histogram latency_histograms[latency_op_count];
+
+inline std::uint64_t latency_now() noexcept {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+// Hooks called around the timed operations. Nothing is timed during constant
+// evaluation, and operations that throw are not recorded.
+#if defined(__cpp_lib_is_constant_evaluated)
+constexpr std::uint64_t latency_start() noexcept { return std::is_constant_evaluated() ? 0 : latency_now(); }
+
+constexpr void latency_stop(latency_op op, std::uint64_t start) noexcept {
+    if (!std::is_constant_evaluated())
+        latency_histograms[static_cast<std::size_t>(op)].record(latency_now() - start);
+}
+#else
+// Before C++20 none of the timed operations can be constant-evaluated.
+inline std::uint64_t latency_start() noexcept { return latency_now(); }
+
+inline void latency_stop(latency_op op, std::uint64_t start) noexcept {
+    latency_histograms[static_cast<std::size_t>(op)].record(latency_now() - start);
+}
+#endif
+
+} // namespace detail
+
+// The process-wide histogram for op. It only fills up when the library is
+// built with BEMAN_INDIRECT_USE_LATENCY_HOOKS; otherwise the operations are
+// not timed at all.
+inline latency_histogram& latency_histogram_of(latency_op op) noexcept {
+    return detail::latency_histograms[static_cast<std::size_t>(op)];
+}
+
+} // namespace beman::indirect
+
+#endif // BEMAN_INDIRECT_LATENCY_HISTOGRAM_HPP
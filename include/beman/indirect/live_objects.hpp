@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef BEMAN_INDIRECT_LIVE_OBJECTS_HPP
+#define BEMAN_INDIRECT_LIVE_OBJECTS_HPP
+
+#include <beman/indirect/detail/live_objects.hpp>
+#include <beman/indirect/polymorphic.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace beman::indirect {
+
+// Live polymorphic control blocks holding one dynamic type.
+struct live_type_stats {
+    polymorphic_type_id type;
+    std::string_view    name;    // as the compiler spells the type; may be empty
+    std::size_t         objects; // control blocks alive
+    std::size_t         bytes;   // their size, object included
+};
+
+namespace detail {
+
+inline live_type_stats live_stats_of(const live_type_entry& entry) noexcept {
+    std::size_t objects = 0;
+    std::size_t bytes   = 0;
+    for (const live_shard& s : entry.shards) {
+        objects += s.objects.load(std::memory_order_relaxed);
+        bytes += s.bytes.load(std::memory_order_relaxed);
+    }
+    return {type_id_from_tag(entry.tag), entry.name, objects, bytes};
+}
+
+} // namespace detail
+
+// Live object registry: when the library is built with
+// BEMAN_INDIRECT_USE_LIVE_OBJECT_REGISTRY, every polymorphic control block is
+// counted, with its size, under the dynamic type of its object from the
+// moment it is constructed until it is destroyed, whichever polymorphic and
+// allocator own it. Blocks whose destruction arena mode skips are not
+// counted. Without the flag nothing is counted.
+//
+// Each type's counters are sharded per thread, so creating and destroying
+// blocks costs two relaxed atomic additions on a cache line that is usually
+// the calling thread's own. Readers do not stop writers: figures read while
+// other threads create or destroy blocks may be slightly out of date.
+
+// One entry for every type that has had a control block, or been passed to
+// live_objects_of, since the program started, including types with nothing
+// left alive, in no particular order.
+inline std::vector<live_type_stats> live_objects_snapshot() {
+    std::vector<live_type_stats> result;
+    for (const detail::live_type_entry* e = detail::live_types.load(std::memory_order_acquire); e; e = e->next)
+        result.push_back(detail::live_stats_of(*e));
+    return result;
+}
+
+template <class U>
+live_type_stats live_objects_of() noexcept {
+    return detail::live_stats_of(detail::live_entry<U>(&detail::type_tag_v<U>));
+}
+
+} // namespace beman::indirect
+
+#endif // BEMAN_INDIRECT_LIVE_OBJECTS_HPP
@@ -0,0 +1,371 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef BEMAN_INDIRECT_MAYBE_INDIRECT_HPP
+#define BEMAN_INDIRECT_MAYBE_INDIRECT_HPP
+
+#include <beman/indirect/arena.hpp>
+#include <beman/indirect/detail/config.hpp>
+#include <beman/indirect/detail/synth_three_way.hpp>
+#include <beman/indirect/indirect.hpp>
+#include <beman/indirect/relocate.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace beman::indirect {
+
+template <class T, std::size_t Threshold = 2 * sizeof(void*)>
+class maybe_indirect;
+
+namespace detail {
+
+template <class>
+inline constexpr bool is_maybe_indirect_v = false;
+
+template <class T, std::size_t Threshold>
+inline constexpr bool is_maybe_indirect_v<maybe_indirect<T, Threshold>> = true;
+
+// Whether maybe_indirect<T, Threshold> keeps T inline. This is not written
+// with is_complete_v: indirect's destructor asks that of T once T is
+// complete, and must not be given the answer cached while T was not.
+template <class T, std::size_t Threshold, class = void>
+struct maybe_indirect_inline : std::false_type {};
+
+template <class T, std::size_t Threshold>
+struct maybe_indirect_inline<T, Threshold, std::void_t<decltype(sizeof(T))>>
+    : std::bool_constant<sizeof(T) <= Threshold && std::is_nothrow_move_constructible_v<T>> {};
+
+template <class T, std::size_t Threshold>
+using maybe_indirect_storage_t = std::conditional_t<maybe_indirect_inline<T, Threshold>::value, T, indirect<T>>;
+
+} // namespace detail
+
+// maybe_indirect: indirect<T>, or T itself when that is cheaper.
+//
+// Wrapping every member in indirect makes recursive types possible, but
+// costs an allocation per member even when the member is an int. A
+// maybe_indirect<T, Threshold> stores T inline when T is complete, at most
+// Threshold bytes and nothrow move constructible, and holds an indirect<T>
+// otherwise, behind the same interface. A recursive member is still boxed,
+// since its type is incomplete where it is declared.
+//
+// The choice is made where maybe_indirect<T, Threshold> is first
+// instantiated, and kept for the rest of the translation unit; name it for a
+// forward-declared T either always before T's definition or always after it,
+// or translation units will disagree on its layout. stored_inline says which
+// layout was chosen.
+//
+// Copies are deep and comparisons are by value either way. An inline value
+// is never valueless: moving from it leaves a moved-from T, where a boxed
+// handle becomes valueless. The allocator-extended constructors of indirect
+// are not provided, as the inline layout has no allocator.
+template <class T, std::size_t Threshold>
+class maybe_indirect {
+    using storage_type = detail::maybe_indirect_storage_t<T, Threshold>;
+
+  public:
+    using value_type    = T;
+    using pointer       = T*;
+    using const_pointer = const T*;
+
+    static constexpr bool stored_inline = detail::maybe_indirect_inline<T, Threshold>::value;
+
+    // constructors
+
+    constexpr explicit maybe_indirect() : value_(make()) {}
+
+    constexpr maybe_indirect(const maybe_indirect&) = default;
+    constexpr maybe_indirect(maybe_indirect&&)      = default;
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U = T>
+        requires(!detail::is_maybe_indirect_v<detail::remove_cvref_t<U>> &&
+                 !std::is_same_v<detail::remove_cvref_t<U>, std::in_place_t> && std::is_constructible_v<T, U>)
+#else
+    template <class U = T,
+              std::enable_if_t<!detail::is_maybe_indirect_v<detail::remove_cvref_t<U>> &&
+                                   !std::is_same_v<detail::remove_cvref_t<U>, std::in_place_t> &&
+                                   std::is_constructible_v<T, U>,
+                               int> = 0>
+#endif
+    constexpr explicit maybe_indirect(U&& u) : value_(make(std::forward<U>(u))) {
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class... Us>
+        requires std::is_constructible_v<T, Us...>
+#else
+    template <class... Us, std::enable_if_t<std::is_constructible_v<T, Us...>, int> = 0>
+#endif
+    constexpr explicit maybe_indirect(std::in_place_t, Us&&... us) : value_(make(std::forward<Us>(us)...)) {
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class I, class... Us>
+        requires std::is_constructible_v<T, std::initializer_list<I>&, Us...>
+#else
+    template <class I,
+              class... Us,
+              std::enable_if_t<std::is_constructible_v<T, std::initializer_list<I>&, Us...>, int> = 0>
+#endif
+    constexpr explicit maybe_indirect(std::in_place_t, std::initializer_list<I> ilist, Us&&... us)
+        : value_(make(ilist, std::forward<Us>(us)...)) {
+    }
+
+    // assignment
+
+    constexpr maybe_indirect& operator=(const maybe_indirect&) = default;
+    constexpr maybe_indirect& operator=(maybe_indirect&&)      = default;
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U = T>
+        requires(!detail::is_maybe_indirect_v<detail::remove_cvref_t<U>> && std::is_constructible_v<T, U> &&
+                 std::is_assignable_v<T&, U>)
+#else
+    template <class U = T,
+              std::enable_if_t<!detail::is_maybe_indirect_v<detail::remove_cvref_t<U>> &&
+                                   std::is_constructible_v<T, U> && std::is_assignable_v<T&, U>,
+                               int> = 0>
+#endif
+    constexpr maybe_indirect& operator=(U&& u) {
+        value_ = std::forward<U>(u);
+        return *this;
+    }
+
+    // Replaces the value with one constructed from us. An inline value is
+    // built aside and then moved into place, so a throwing constructor leaves
+    // it unchanged; a boxed one behaves as indirect::emplace.
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class... Us>
+        requires std::is_constructible_v<T, Us...>
+#else
+    template <class... Us, std::enable_if_t<std::is_constructible_v<T, Us...>, int> = 0>
+#endif
+    constexpr T& emplace(Us&&... us) {
+        if constexpr (stored_inline) {
+            T tmp(std::forward<Us>(us)...);
+            std::destroy_at(std::addressof(value_));
+            return *detail::construct_at_impl(std::addressof(value_), std::move(tmp));
+        } else {
+            return value_.emplace(std::forward<Us>(us)...);
+        }
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class I, class... Us>
+        requires std::is_constructible_v<T, std::initializer_list<I>&, Us...>
+#else
+    template <class I,
+              class... Us,
+              std::enable_if_t<std::is_constructible_v<T, std::initializer_list<I>&, Us...>, int> = 0>
+#endif
+    constexpr T& emplace(std::initializer_list<I> ilist, Us&&... us) {
+        if constexpr (stored_inline) {
+            T tmp(ilist, std::forward<Us>(us)...);
+            std::destroy_at(std::addressof(value_));
+            return *detail::construct_at_impl(std::addressof(value_), std::move(tmp));
+        } else {
+            return value_.emplace(ilist, std::forward<Us>(us)...);
+        }
+    }
+
+    // observers
+
+    constexpr const T& operator*() const& noexcept { return get(); }
+    constexpr T&       operator*() & noexcept { return get(); }
+    constexpr const T&& operator*() const&& noexcept { return std::move(get()); }
+    constexpr T&&       operator*() && noexcept { return std::move(get()); }
+
+    constexpr const_pointer operator->() const noexcept { return std::addressof(get()); }
+    constexpr pointer       operator->() noexcept { return std::addressof(get()); }
+
+    constexpr bool valueless_after_move() const noexcept {
+        if constexpr (stored_inline)
+            return false;
+        else
+            return value_.valueless_after_move();
+    }
+
+    // swap
+
+    constexpr void swap(maybe_indirect& other) noexcept(std::is_nothrow_swappable_v<storage_type>) {
+        using std::swap;
+        swap(value_, other.value_);
+    }
+
+    friend constexpr void swap(maybe_indirect& lhs, maybe_indirect& rhs) noexcept(noexcept(lhs.swap(rhs))) {
+        lhs.swap(rhs);
+    }
+
+    // relational operators
+    //
+    // T and indirect<T> compare the same way, so both layouts compare their
+    // storage.
+
+    friend constexpr bool operator==(const maybe_indirect& lhs,
+                                     const maybe_indirect& rhs) noexcept(noexcept(lhs.value_ == rhs.value_)) {
+        return lhs.value_ == rhs.value_;
+    }
+
+#if BEMAN_INDIRECT_USE_THREE_WAY_COMPARISON
+    friend constexpr auto operator<=>(const maybe_indirect& lhs, const maybe_indirect& rhs) {
+        return detail::synth_three_way(lhs.value_, rhs.value_);
+    }
+#else
+    friend constexpr bool operator!=(const maybe_indirect& lhs,
+                                     const maybe_indirect& rhs) noexcept(noexcept(lhs == rhs)) {
+        return !(lhs == rhs);
+    }
+
+    friend constexpr bool operator<(const maybe_indirect& lhs, const maybe_indirect& rhs) {
+        return lhs.value_ < rhs.value_;
+    }
+
+    friend constexpr bool operator>(const maybe_indirect& lhs, const maybe_indirect& rhs) { return rhs < lhs; }
+
+    friend constexpr bool operator<=(const maybe_indirect& lhs, const maybe_indirect& rhs) { return !(rhs < lhs); }
+
+    friend constexpr bool operator>=(const maybe_indirect& lhs, const maybe_indirect& rhs) { return !(lhs < rhs); }
+#endif // BEMAN_INDIRECT_USE_THREE_WAY_COMPARISON
+
+    // comparison with T
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U>
+        requires(!detail::is_maybe_indirect_v<U>)
+    friend constexpr bool operator==(const maybe_indirect& lhs, const U& rhs) noexcept(noexcept(lhs.value_ == rhs)) {
+        return lhs.value_ == rhs;
+    }
+#else
+    template <class U, std::enable_if_t<!detail::is_maybe_indirect_v<U>, int> = 0>
+    friend constexpr bool operator==(const maybe_indirect& lhs, const U& rhs) noexcept(noexcept(lhs.value_ == rhs)) {
+        return lhs.value_ == rhs;
+    }
+
+    template <class U, std::enable_if_t<!detail::is_maybe_indirect_v<U>, int> = 0>
+    friend constexpr bool operator==(const U& lhs, const maybe_indirect& rhs) noexcept(noexcept(rhs == lhs)) {
+        return rhs == lhs;
+    }
+
+    template <class U, std::enable_if_t<!detail::is_maybe_indirect_v<U>, int> = 0>
+    friend constexpr bool operator!=(const maybe_indirect& lhs, const U& rhs) noexcept(noexcept(lhs == rhs)) {
+        return !(lhs == rhs);
+    }
+
+    template <class U, std::enable_if_t<!detail::is_maybe_indirect_v<U>, int> = 0>
+    friend constexpr bool operator!=(const U& lhs, const maybe_indirect& rhs) noexcept(noexcept(rhs == lhs)) {
+        return !(rhs == lhs);
+    }
+
+    template <class U, std::enable_if_t<!detail::is_maybe_indirect_v<U>, int> = 0>
+    friend constexpr bool operator<(const maybe_indirect& lhs, const U& rhs) {
+        return lhs.value_ < rhs;
+    }
+
+    template <class U, std::enable_if_t<!detail::is_maybe_indirect_v<U>, int> = 0>
+    friend constexpr bool operator<(const U& lhs, const maybe_indirect& rhs) {
+        return lhs < rhs.value_;
+    }
+
+    template <class U, std::enable_if_t<!detail::is_maybe_indirect_v<U>, int> = 0>
+    friend constexpr bool operator>(const maybe_indirect& lhs, const U& rhs) {
+        return rhs < lhs;
+    }
+
+    template <class U, std::enable_if_t<!detail::is_maybe_indirect_v<U>, int> = 0>
+    friend constexpr bool operator>(const U& lhs, const maybe_indirect& rhs) {
+        return rhs < lhs;
+    }
+
+    template <class U, std::enable_if_t<!detail::is_maybe_indirect_v<U>, int> = 0>
+    friend constexpr bool operator<=(const maybe_indirect& lhs, const U& rhs) {
+        return !(rhs < lhs);
+    }
+
+    template <class U, std::enable_if_t<!detail::is_maybe_indirect_v<U>, int> = 0>
+    friend constexpr bool operator<=(const U& lhs, const maybe_indirect& rhs) {
+        return !(rhs < lhs);
+    }
+
+    template <class U, std::enable_if_t<!detail::is_maybe_indirect_v<U>, int> = 0>
+    friend constexpr bool operator>=(const maybe_indirect& lhs, const U& rhs) {
+        return !(lhs < rhs);
+    }
+
+    template <class U, std::enable_if_t<!detail::is_maybe_indirect_v<U>, int> = 0>
+    friend constexpr bool operator>=(const U& lhs, const maybe_indirect& rhs) {
+        return !(lhs < rhs);
+    }
+#endif // BEMAN_INDIRECT_USE_CONCEPTS
+
+#if BEMAN_INDIRECT_USE_THREE_WAY_COMPARISON
+    #if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U>
+        requires(!detail::is_maybe_indirect_v<U>)
+    friend constexpr auto operator<=>(const maybe_indirect& lhs, const U& rhs) {
+        return detail::synth_three_way(lhs.value_, rhs);
+    }
+    #else
+    template <class U, std::enable_if_t<!detail::is_maybe_indirect_v<U>, int> = 0>
+    friend constexpr auto operator<=>(const maybe_indirect& lhs, const U& rhs) {
+        return detail::synth_three_way(lhs.value_, rhs);
+    }
+    #endif // BEMAN_INDIRECT_USE_CONCEPTS
+#endif     // BEMAN_INDIRECT_USE_THREE_WAY_COMPARISON
+
+  private:
+    template <class... Us>
+    static constexpr storage_type make(Us&&... us) {
+        if constexpr (stored_inline)
+            return T(std::forward<Us>(us)...);
+        else
+            return indirect<T>(std::in_place, std::forward<Us>(us)...);
+    }
+
+    constexpr const T& get() const noexcept {
+        if constexpr (stored_inline)
+            return value_;
+        else
+            return *value_;
+    }
+
+    constexpr T& get() noexcept {
+        if constexpr (stored_inline)
+            return value_;
+        else
+            return *value_;
+    }
+
+    storage_type value_;
+};
+
+// Each layout relocates and discards as its storage does.
+template <class T, std::size_t Threshold>
+struct is_trivially_relocatable<maybe_indirect<T, Threshold>>
+    : is_trivially_relocatable<detail::maybe_indirect_storage_t<T, Threshold>> {};
+
+template <class T, std::size_t Threshold>
+struct is_arena_discardable<maybe_indirect<T, Threshold>>
+    : is_arena_discardable<detail::maybe_indirect_storage_t<T, Threshold>> {};
+
+// Deduction guides
+template <class Value>
+maybe_indirect(Value) -> maybe_indirect<Value>;
+
+} // namespace beman::indirect
+
+template <class T, std::size_t Threshold>
+struct std::hash<beman::indirect::maybe_indirect<T, Threshold>> {
+    constexpr std::size_t operator()(const beman::indirect::maybe_indirect<T, Threshold>& m) const
+        noexcept(noexcept(std::hash<T>{}(*m))) {
+        if (m.valueless_after_move())
+            return static_cast<std::size_t>(-1);
+        return std::hash<T>{}(*m);
+    }
+};
+
+#endif // BEMAN_INDIRECT_MAYBE_INDIRECT_HPP
@@ -0,0 +1,396 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef BEMAN_INDIRECT_OPTIONAL_INDIRECT_HPP
+#define BEMAN_INDIRECT_OPTIONAL_INDIRECT_HPP
+
+#include <beman/indirect/arena.hpp>
+#include <beman/indirect/detail/config.hpp>
+#include <beman/indirect/detail/synth_three_way.hpp>
+#include <beman/indirect/indirect.hpp>
+#include <beman/indirect/relocate.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace beman::indirect {
+
+namespace detail {
+
+template <class>
+inline constexpr bool is_optional_indirect_v = false;
+
+template <class T, class A>
+inline constexpr bool is_optional_indirect_v<optional_indirect<T, A>> = true;
+
+} // namespace detail
+
+// optional_indirect: std::optional<indirect<T, Allocator>> without the flag.
+//
+// An indirect's null pointer already means "no value", so optional_indirect
+// uses it as the empty state and is exactly as large as indirect, where
+// std::optional would add a bool and padding. An empty handle owns no
+// allocation. Copies are deep and comparisons are by value, as for indirect;
+// an empty handle compares equal to another empty one and less than any
+// value. Unlike std::optional, moving from a handle leaves it empty.
+template <class T, class Allocator = std::allocator<T>>
+class optional_indirect {
+    using indirect_type = indirect<T, Allocator>;
+
+  public:
+    using value_type     = T;
+    using allocator_type = Allocator;
+    using pointer        = typename indirect_type::pointer;
+    using const_pointer  = typename indirect_type::const_pointer;
+
+    // constructors
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    constexpr optional_indirect() noexcept
+        requires std::is_default_constructible_v<Allocator>
+#else
+    template <class Alloc_ = Allocator, std::enable_if_t<std::is_default_constructible_v<Alloc_>, int> = 0>
+    constexpr optional_indirect() noexcept
+#endif
+        : value_(detail::valueless_t(), Allocator()) {
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    constexpr optional_indirect(std::nullopt_t) noexcept
+        requires std::is_default_constructible_v<Allocator>
+#else
+    template <class Alloc_ = Allocator, std::enable_if_t<std::is_default_constructible_v<Alloc_>, int> = 0>
+    constexpr optional_indirect(std::nullopt_t) noexcept
+#endif
+        : value_(detail::valueless_t(), Allocator()) {
+    }
+
+    constexpr optional_indirect(std::allocator_arg_t, const Allocator& a) noexcept
+        : value_(detail::valueless_t(), a) {}
+
+    constexpr optional_indirect(std::allocator_arg_t, const Allocator& a, std::nullopt_t) noexcept
+        : value_(detail::valueless_t(), a) {}
+
+    // Takes over the value of v, if it has one, without allocating.
+    constexpr optional_indirect(indirect_type&& v) noexcept : value_(std::move(v)) {}
+
+    constexpr optional_indirect(const optional_indirect&) = default;
+    constexpr optional_indirect(optional_indirect&&)      = default;
+
+    constexpr optional_indirect(std::allocator_arg_t, const Allocator& a, const optional_indirect& other)
+        : value_(std::allocator_arg, a, other.value_) {}
+
+    constexpr optional_indirect(std::allocator_arg_t, const Allocator& a, optional_indirect&& other) noexcept(
+        std::allocator_traits<Allocator>::is_always_equal::value)
+        : value_(std::allocator_arg, a, std::move(other.value_)) {}
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U = T>
+        requires(!detail::is_optional_indirect_v<detail::remove_cvref_t<U>> &&
+                 !std::is_same_v<detail::remove_cvref_t<U>, indirect_type> &&
+                 !std::is_same_v<detail::remove_cvref_t<U>, std::nullopt_t> &&
+                 !std::is_same_v<detail::remove_cvref_t<U>, std::in_place_t> && std::is_constructible_v<T, U> &&
+                 std::is_default_constructible_v<Allocator>)
+#else
+    template <class U = T,
+              std::enable_if_t<!detail::is_optional_indirect_v<detail::remove_cvref_t<U>> &&
+                                   !std::is_same_v<detail::remove_cvref_t<U>, indirect_type> &&
+                                   !std::is_same_v<detail::remove_cvref_t<U>, std::nullopt_t> &&
+                                   !std::is_same_v<detail::remove_cvref_t<U>, std::in_place_t> &&
+                                   std::is_constructible_v<T, U> && std::is_default_constructible_v<Allocator>,
+                               int> = 0>
+#endif
+    constexpr explicit optional_indirect(U&& u) : value_(std::forward<U>(u)) {
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U = T>
+        requires(!detail::is_optional_indirect_v<detail::remove_cvref_t<U>> &&
+                 !std::is_same_v<detail::remove_cvref_t<U>, indirect_type> &&
+                 !std::is_same_v<detail::remove_cvref_t<U>, std::nullopt_t> &&
+                 !std::is_same_v<detail::remove_cvref_t<U>, std::in_place_t> && std::is_constructible_v<T, U>)
+#else
+    template <class U = T,
+              std::enable_if_t<!detail::is_optional_indirect_v<detail::remove_cvref_t<U>> &&
+                                   !std::is_same_v<detail::remove_cvref_t<U>, indirect_type> &&
+                                   !std::is_same_v<detail::remove_cvref_t<U>, std::nullopt_t> &&
+                                   !std::is_same_v<detail::remove_cvref_t<U>, std::in_place_t> &&
+                                   std::is_constructible_v<T, U>,
+                               int> = 0>
+#endif
+    constexpr explicit optional_indirect(std::allocator_arg_t, const Allocator& a, U&& u)
+        : value_(std::allocator_arg, a, std::forward<U>(u)) {
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class... Us>
+        requires(std::is_constructible_v<T, Us...> && std::is_default_constructible_v<Allocator>)
+#else
+    template <
+        class... Us,
+        std::enable_if_t<std::is_constructible_v<T, Us...> && std::is_default_constructible_v<Allocator>, int> = 0>
+#endif
+    constexpr explicit optional_indirect(std::in_place_t, Us&&... us)
+        : value_(std::in_place, std::forward<Us>(us)...) {
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class... Us>
+        requires std::is_constructible_v<T, Us...>
+#else
+    template <class... Us, std::enable_if_t<std::is_constructible_v<T, Us...>, int> = 0>
+#endif
+    constexpr explicit optional_indirect(std::allocator_arg_t, const Allocator& a, std::in_place_t, Us&&... us)
+        : value_(std::allocator_arg, a, std::in_place, std::forward<Us>(us)...) {
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class I, class... Us>
+        requires(std::is_constructible_v<T, std::initializer_list<I>&, Us...> &&
+                 std::is_default_constructible_v<Allocator>)
+#else
+    template <class I,
+              class... Us,
+              std::enable_if_t<std::is_constructible_v<T, std::initializer_list<I>&, Us...> &&
+                                   std::is_default_constructible_v<Allocator>,
+                               int> = 0>
+#endif
+    constexpr explicit optional_indirect(std::in_place_t, std::initializer_list<I> ilist, Us&&... us)
+        : value_(std::in_place, ilist, std::forward<Us>(us)...) {
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class I, class... Us>
+        requires std::is_constructible_v<T, std::initializer_list<I>&, Us...>
+#else
+    template <class I,
+              class... Us,
+              std::enable_if_t<std::is_constructible_v<T, std::initializer_list<I>&, Us...>, int> = 0>
+#endif
+    constexpr explicit optional_indirect(
+        std::allocator_arg_t, const Allocator& a, std::in_place_t, std::initializer_list<I> ilist, Us&&... us)
+        : value_(std::allocator_arg, a, std::in_place, ilist, std::forward<Us>(us)...) {
+    }
+
+    // assignment
+
+    constexpr optional_indirect& operator=(const optional_indirect&) = default;
+    constexpr optional_indirect& operator=(optional_indirect&&)      = default;
+
+    constexpr optional_indirect& operator=(std::nullopt_t) noexcept {
+        reset();
+        return *this;
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U = T>
+        requires(!detail::is_optional_indirect_v<detail::remove_cvref_t<U>> &&
+                 !std::is_same_v<detail::remove_cvref_t<U>, std::nullopt_t> && std::is_assignable_v<indirect_type&, U>)
+#else
+    template <class U = T,
+              std::enable_if_t<!detail::is_optional_indirect_v<detail::remove_cvref_t<U>> &&
+                                   !std::is_same_v<detail::remove_cvref_t<U>, std::nullopt_t> &&
+                                   std::is_assignable_v<indirect_type&, U>,
+                               int> = 0>
+#endif
+    constexpr optional_indirect& operator=(U&& u) {
+        value_ = std::forward<U>(u);
+        return *this;
+    }
+
+    // Construct a new value, reusing the allocation when there is one; see
+    // indirect::emplace.
+    template <class... Us>
+    constexpr auto emplace(Us&&... us) -> decltype(std::declval<indirect_type&>().emplace(std::forward<Us>(us)...)) {
+        return value_.emplace(std::forward<Us>(us)...);
+    }
+
+    // Destroy the value, if any, and release its allocation.
+    constexpr void reset() noexcept { value_ = indirect_type(detail::valueless_t(), value_.get_allocator()); }
+
+    // observers
+
+    constexpr bool has_value() const noexcept { return !value_.valueless_after_move(); }
+    constexpr explicit operator bool() const noexcept { return has_value(); }
+
+    constexpr const T& operator*() const& noexcept { return *value_; }
+    constexpr T&       operator*() & noexcept { return *value_; }
+    constexpr const T&& operator*() const&& noexcept { return *std::move(value_); }
+    constexpr T&&       operator*() && noexcept { return *std::move(value_); }
+
+    constexpr const_pointer operator->() const noexcept { return value_.operator->(); }
+    constexpr pointer       operator->() noexcept { return value_.operator->(); }
+
+    constexpr const T& value() const& {
+        if (!has_value())
+            throw std::bad_optional_access();
+        return *value_;
+    }
+
+    constexpr T& value() & {
+        if (!has_value())
+            throw std::bad_optional_access();
+        return *value_;
+    }
+
+    constexpr const T&& value() const&& {
+        if (!has_value())
+            throw std::bad_optional_access();
+        return *std::move(value_);
+    }
+
+    constexpr T&& value() && {
+        if (!has_value())
+            throw std::bad_optional_access();
+        return *std::move(value_);
+    }
+
+    template <class U>
+    constexpr T value_or(U&& u) const& {
+        return has_value() ? *value_ : static_cast<T>(std::forward<U>(u));
+    }
+
+    template <class U>
+    constexpr T value_or(U&& u) && {
+        return has_value() ? *std::move(value_) : static_cast<T>(std::forward<U>(u));
+    }
+
+    constexpr allocator_type get_allocator() const noexcept { return value_.get_allocator(); }
+
+    // The underlying indirect, valueless when *this is empty.
+    constexpr const indirect_type& as_indirect() const& noexcept { return value_; }
+    constexpr indirect_type&&      as_indirect() && noexcept { return std::move(value_); }
+
+    // swap
+
+    constexpr void swap(optional_indirect& other) noexcept(noexcept(other.value_.swap(other.value_))) {
+        value_.swap(other.value_);
+    }
+
+    friend constexpr void swap(optional_indirect& lhs, optional_indirect& rhs) noexcept(noexcept(lhs.swap(rhs))) {
+        lhs.swap(rhs);
+    }
+
+    // relational operators
+    //
+    // indirect already orders a valueless handle before any value and equal to
+    // another valueless one, which is std::optional's order.
+
+    friend constexpr bool operator==(const optional_indirect& lhs,
+                                     const optional_indirect& rhs) noexcept(noexcept(lhs.value_ == rhs.value_)) {
+        return lhs.value_ == rhs.value_;
+    }
+
+    friend constexpr bool operator==(const optional_indirect& lhs, std::nullopt_t) noexcept { return !lhs; }
+
+#if BEMAN_INDIRECT_USE_THREE_WAY_COMPARISON
+    friend constexpr auto operator<=>(const optional_indirect& lhs, const optional_indirect& rhs)
+        -> detail::synth_three_way_result<T> {
+        return lhs.value_ <=> rhs.value_;
+    }
+
+    friend constexpr std::strong_ordering operator<=>(const optional_indirect& lhs, std::nullopt_t) noexcept {
+        return lhs.has_value() <=> false;
+    }
+#else
+    friend constexpr bool operator==(std::nullopt_t, const optional_indirect& rhs) noexcept { return !rhs; }
+    friend constexpr bool operator!=(const optional_indirect& lhs, std::nullopt_t) noexcept { return bool(lhs); }
+    friend constexpr bool operator!=(std::nullopt_t, const optional_indirect& rhs) noexcept { return bool(rhs); }
+
+    friend constexpr bool operator!=(const optional_indirect& lhs,
+                                     const optional_indirect& rhs) noexcept(noexcept(lhs == rhs)) {
+        return !(lhs == rhs);
+    }
+
+    friend constexpr bool operator<(const optional_indirect& lhs, const optional_indirect& rhs) {
+        return lhs.value_ < rhs.value_;
+    }
+
+    friend constexpr bool operator>(const optional_indirect& lhs, const optional_indirect& rhs) { return rhs < lhs; }
+
+    friend constexpr bool operator<=(const optional_indirect& lhs, const optional_indirect& rhs) {
+        return !(rhs < lhs);
+    }
+
+    friend constexpr bool operator>=(const optional_indirect& lhs, const optional_indirect& rhs) {
+        return !(lhs < rhs);
+    }
+#endif // BEMAN_INDIRECT_USE_THREE_WAY_COMPARISON
+
+    // equality with T
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U>
+        requires(!detail::is_optional_indirect_v<U> && !std::is_same_v<U, std::nullopt_t>)
+    friend constexpr bool operator==(const optional_indirect& lhs,
+                                     const U&                 rhs) noexcept(noexcept(lhs.value_ == rhs)) {
+        return lhs.value_ == rhs;
+    }
+#else
+    template <class U,
+              std::enable_if_t<!detail::is_optional_indirect_v<U> && !std::is_same_v<U, std::nullopt_t>, int> = 0>
+    friend constexpr bool operator==(const optional_indirect& lhs,
+                                     const U&                 rhs) noexcept(noexcept(lhs.value_ == rhs)) {
+        return lhs.value_ == rhs;
+    }
+
+    template <class U,
+              std::enable_if_t<!detail::is_optional_indirect_v<U> && !std::is_same_v<U, std::nullopt_t>, int> = 0>
+    friend constexpr bool operator==(const U& lhs, const optional_indirect& rhs) noexcept(noexcept(rhs == lhs)) {
+        return rhs == lhs;
+    }
+
+    template <class U,
+              std::enable_if_t<!detail::is_optional_indirect_v<U> && !std::is_same_v<U, std::nullopt_t>, int> = 0>
+    friend constexpr bool operator!=(const optional_indirect& lhs, const U& rhs) noexcept(noexcept(lhs == rhs)) {
+        return !(lhs == rhs);
+    }
+
+    template <class U,
+              std::enable_if_t<!detail::is_optional_indirect_v<U> && !std::is_same_v<U, std::nullopt_t>, int> = 0>
+    friend constexpr bool operator!=(const U& lhs, const optional_indirect& rhs) noexcept(noexcept(rhs == lhs)) {
+        return !(rhs == lhs);
+    }
+#endif // BEMAN_INDIRECT_USE_CONCEPTS
+
+  private:
+    indirect_type value_;
+};
+
+// The handle is an indirect, null when empty.
+template <class T, class Allocator>
+struct is_trivially_relocatable<optional_indirect<T, Allocator>> : is_trivially_relocatable<indirect<T, Allocator>> {};
+
+template <class T, class Allocator>
+struct is_arena_discardable<optional_indirect<T, Allocator>> : is_arena_discardable<indirect<T, Allocator>> {};
+
+// Deduction guides
+template <class Value>
+optional_indirect(Value) -> optional_indirect<Value>;
+
+template <class T, class Allocator>
+optional_indirect(indirect<T, Allocator>) -> optional_indirect<T, Allocator>;
+
+} // namespace beman::indirect
+
+template <class T, class Allocator>
+struct std::hash<beman::indirect::optional_indirect<T, Allocator>> {
+    constexpr std::size_t operator()(const beman::indirect::optional_indirect<T, Allocator>& o) const
+        noexcept(noexcept(std::hash<beman::indirect::indirect<T, Allocator>>{}(o.as_indirect()))) {
+        return std::hash<beman::indirect::indirect<T, Allocator>>{}(o.as_indirect());
+    }
+};
+
+namespace beman::indirect::pmr {
+
+template <class T>
+using optional_indirect = beman::indirect::optional_indirect<T, std::pmr::polymorphic_allocator<T>>;
+
+} // namespace beman::indirect::pmr
+
+#endif // BEMAN_INDIRECT_OPTIONAL_INDIRECT_HPP
@@ -3,10 +3,26 @@
 #ifndef BEMAN_INDIRECT_POLYMORPHIC_HPP
 #define BEMAN_INDIRECT_POLYMORPHIC_HPP
 
+#include <beman/indirect/arena.hpp>
 #include <beman/indirect/detail/config.hpp>
 #include <beman/indirect/detail/synth_three_way.hpp>
+#include <beman/indirect/relocate.hpp>
+
+#if BEMAN_INDIRECT_USE_LATENCY_HOOKS
+#include <beman/indirect/latency_histogram.hpp>
+#endif
+
+#if BEMAN_INDIRECT_USE_LIVE_OBJECT_REGISTRY
+#include <beman/indirect/detail/live_objects.hpp>
+#endif
+
+#if BEMAN_INDIRECT_USE_TRACEPOINTS
+#include <beman/indirect/detail/tracepoints.hpp>
+#endif
 
 #include <cassert>
+#include <cstddef>
+#include <functional>
 #include <initializer_list>
 #include <memory>
 #include <memory_resource>
@@ -24,22 +40,122 @@ inline constexpr bool is_in_place_type_v = false;
 template <class T>
 inline constexpr bool is_in_place_type_v<std::in_place_type_t<T>> = true;
 
-// Abstract control block for type-erased polymorphic storage.
+// Per-type object whose address identifies U without RTTI.
+template <class U>
+inline constexpr char type_tag_v = 0;
+
+template <class T, class Allocator>
+struct control_block;
+
+// Dispatch table for a control block, one per stored type U: a plain
+// aggregate of function pointers and constants, so using it requires neither
+// virtual functions nor RTTI and works in constant expressions. clone and
+// move_clone report the new object's address through `p`.
+//
+// assign copies the value owned by src into self's object, which requires
+// both blocks to share a table. It returns false, with no effects, when that
+// cannot be done without risking the strong exception guarantee; the caller
+// then falls back to clone.
+//
+// recycle destroys the object and the block but keeps the allocation, of
+// `size` bytes aligned to `align`, and returns it for a new block to be built
+// in.
+//
+// type_tag identifies U. New entries go at the end.
+template <class T, class Allocator>
+struct control_block_ops {
+    using cb_type = control_block<T, Allocator>;
+
+    cb_type* (*clone)(const cb_type& self, const Allocator& alloc, T*& p);
+    cb_type* (*move_clone)(cb_type& self, const Allocator& alloc, T*& p);
+    bool (*assign)(cb_type& self, const cb_type& src, const Allocator& alloc);
+    void* (*recycle)(cb_type& self, Allocator& alloc) noexcept;
+    void (*destroy)(cb_type& self, Allocator& alloc) noexcept;
+    std::size_t size;
+    std::size_t align;
+    const void* type_tag;
+};
+
+// Type-erased control block: a pointer to the table for the stored type,
+// followed (in direct_control_block) by the object itself. The block does not
+// record where its object lives: the owning polymorphic caches that pointer,
+// so dereferencing costs a single load.
 template <class T, class Allocator>
 struct control_block {
-    T* p_;
+    const control_block_ops<T, Allocator>* ops;
+
+    constexpr explicit control_block(const control_block_ops<T, Allocator>* table) noexcept : ops(table) {}
+
+#if BEMAN_INDIRECT_USE_LATENCY_HOOKS
+    constexpr control_block* clone(const Allocator& alloc, T*& p) const {
+        const std::uint64_t start = latency_start();
+        control_block*      cb    = ops->clone(*this, alloc, p);
+        latency_stop(latency_op::polymorphic_clone, start);
+        return cb;
+    }
+
+    constexpr control_block* move_clone(const Allocator& alloc, T*& p) {
+        const std::uint64_t start = latency_start();
+        control_block*      cb    = ops->move_clone(*this, alloc, p);
+        latency_stop(latency_op::polymorphic_move_clone, start);
+        return cb;
+    }
+#else
+    constexpr control_block* clone(const Allocator& alloc, T*& p) const { return ops->clone(*this, alloc, p); }
+
+    constexpr control_block* move_clone(const Allocator& alloc, T*& p) { return ops->move_clone(*this, alloc, p); }
+#endif
+
+    constexpr bool assign(const control_block& src, const Allocator& alloc) {
+        assert(src.ops == ops);
+        return ops->assign(*this, src, alloc);
+    }
 
-    BEMAN_INDIRECT_CONSTEXPR_VIRTUAL virtual control_block* clone(const Allocator& alloc) const = 0;
-    BEMAN_INDIRECT_CONSTEXPR_VIRTUAL virtual control_block* move_clone(const Allocator& alloc)  = 0;
-    BEMAN_INDIRECT_CONSTEXPR_VIRTUAL virtual void           destroy(Allocator& alloc) noexcept  = 0;
+    constexpr const void* type_tag() const noexcept { return ops->type_tag; }
+
+    // Returns the allocation for reuse when it has exactly the given size and
+    // alignment. Otherwise returns nullptr and leaves the block untouched.
+    constexpr void* recycle(std::size_t size, std::size_t align, Allocator& alloc) noexcept {
+        if (size != ops->size || align != ops->align)
+            return nullptr;
+        return ops->recycle(*this, alloc);
+    }
+
+#if BEMAN_INDIRECT_USE_LATENCY_HOOKS
+    constexpr void destroy(Allocator& alloc) noexcept {
+        const std::uint64_t start = latency_start();
+        ops->destroy(*this, alloc);
+        latency_stop(latency_op::polymorphic_destroy, start);
+    }
+#else
+    constexpr void destroy(Allocator& alloc) noexcept { ops->destroy(*this, alloc); }
+#endif
 
   protected:
     BEMAN_INDIRECT_CONSTEXPR_DTOR ~control_block() = default;
 };
 
+template <class T, class U, class Allocator>
+struct direct_control_block;
+
+// The table for direct_control_block<T, U, Allocator>. Its initializer is only
+// instantiated once that class is complete.
+template <class T, class U, class Allocator>
+inline constexpr control_block_ops<T, Allocator> direct_control_block_ops = {
+    &direct_control_block<T, U, Allocator>::clone,
+    &direct_control_block<T, U, Allocator>::move_clone,
+    &direct_control_block<T, U, Allocator>::assign,
+    &direct_control_block<T, U, Allocator>::recycle,
+    &direct_control_block<T, U, Allocator>::destroy,
+    sizeof(direct_control_block<T, U, Allocator>),
+    alignof(direct_control_block<T, U, Allocator>),
+    &type_tag_v<U>,
+};
+
 // Concrete control block that stores a value of type U (derived from T) inline.
 template <class T, class U, class Allocator>
 struct direct_control_block final : control_block<T, Allocator> {
+    using base_type = control_block<T, Allocator>;
     using cb_alloc  = typename std::allocator_traits<Allocator>::template rebind_alloc<direct_control_block>;
     using cb_traits = std::allocator_traits<cb_alloc>;
 
@@ -50,46 +166,198 @@ struct direct_control_block final : control_block<T, Allocator> {
     } storage_;
 
     template <class... Args>
-    constexpr explicit direct_control_block(const Allocator& alloc, Args&&... args) {
+    constexpr explicit direct_control_block(const Allocator& alloc, Args&&... args)
+        : base_type(&direct_control_block_ops<T, U, Allocator>) {
         Allocator a(alloc);
         std::allocator_traits<Allocator>::construct(a, std::addressof(storage_.value), std::forward<Args>(args)...);
-        this->p_ = std::addressof(storage_.value);
+#if BEMAN_INDIRECT_USE_LIVE_OBJECT_REGISTRY
+        // Arena-discardable blocks are never destroyed, so they are not counted.
+        if constexpr (!(is_arena_allocator_v<Allocator> && is_arena_discardable_v<T>))
+            live_object_added<U>(&type_tag_v<U>, sizeof(direct_control_block));
+#endif
     }
 
-    BEMAN_INDIRECT_CONSTEXPR_VIRTUAL control_block<T, Allocator>* clone(const Allocator& alloc) const override {
-        cb_alloc a(alloc);
-        auto*    mem = cb_traits::allocate(a, 1);
-        try {
-            construct_at_impl(mem, alloc, storage_.value);
-        } catch (...) {
-            cb_traits::deallocate(a, mem, 1);
-            throw;
+    constexpr T* get() noexcept { return std::addressof(storage_.value); }
+
+    // In arena mode is_arena_discardable<T> covers U as well, see polymorphic::reset.
+    constexpr void destroy_value(Allocator& alloc) noexcept {
+        if constexpr (!(is_arena_allocator_v<Allocator> && is_arena_discardable_v<T>)) {
+            std::allocator_traits<Allocator>::destroy(alloc, std::addressof(storage_.value));
+#if BEMAN_INDIRECT_USE_LIVE_OBJECT_REGISTRY
+            live_object_removed<U>(&type_tag_v<U>, sizeof(direct_control_block));
+#endif
         }
-        return mem;
     }
 
-    BEMAN_INDIRECT_CONSTEXPR_VIRTUAL control_block<T, Allocator>* move_clone(const Allocator& alloc) override {
+    // Table entries.
+
+    static constexpr direct_control_block& self(base_type& cb) noexcept {
+        return static_cast<direct_control_block&>(cb);
+    }
+
+    static constexpr const direct_control_block& self(const base_type& cb) noexcept {
+        return static_cast<const direct_control_block&>(cb);
+    }
+
+    template <class V>
+    static constexpr base_type* make(const Allocator& alloc, T*& p, V&& value) {
         cb_alloc a(alloc);
         auto*    mem = cb_traits::allocate(a, 1);
         try {
-            construct_at_impl(mem, alloc, std::move(storage_.value));
+            construct_at_impl(mem, alloc, std::forward<V>(value));
         } catch (...) {
             cb_traits::deallocate(a, mem, 1);
             throw;
         }
+        p = mem->get();
         return mem;
     }
 
-    BEMAN_INDIRECT_CONSTEXPR_VIRTUAL void destroy(Allocator& alloc) noexcept override {
-        cb_alloc a(alloc);
-        std::destroy_at(std::addressof(storage_.value));
-        cb_traits::destroy(a, this);
-        cb_traits::deallocate(a, this, 1);
+#if BEMAN_INDIRECT_USE_TRACEPOINTS
+    static constexpr base_type* clone(const base_type& cb, const Allocator& alloc, T*& p) {
+        base_type* copy = make(alloc, p, self(cb).storage_.value);
+        if (!is_constant_evaluated())
+            probe_polymorphic_clone(type_name_hash_v<U>, sizeof(direct_control_block));
+        return copy;
+    }
+
+    static constexpr base_type* move_clone(base_type& cb, const Allocator& alloc, T*& p) {
+        base_type* copy = make(alloc, p, std::move(self(cb).storage_.value));
+        if (!is_constant_evaluated())
+            probe_polymorphic_move_clone(type_name_hash_v<U>, sizeof(direct_control_block));
+        return copy;
+    }
+#else
+    static constexpr base_type* clone(const base_type& cb, const Allocator& alloc, T*& p) {
+        return make(alloc, p, self(cb).storage_.value);
+    }
+
+    static constexpr base_type* move_clone(base_type& cb, const Allocator& alloc, T*& p) {
+        return make(alloc, p, std::move(self(cb).storage_.value));
+    }
+#endif
+
+    static constexpr bool assign(base_type& cb, const base_type& src, const Allocator& alloc) {
+        const U& value = self(src).storage_.value;
+        if constexpr (std::is_nothrow_copy_assignable_v<U>) {
+            self(cb).storage_.value = value;
+            return true;
+        } else if constexpr (std::is_nothrow_move_assignable_v<U>) {
+            // Copy into a temporary first so that a throwing copy leaves *this untouched.
+            Allocator a(alloc);
+            storage   tmp;
+            std::allocator_traits<Allocator>::construct(a, std::addressof(tmp.value), value);
+            self(cb).storage_.value = std::move(tmp.value);
+            std::allocator_traits<Allocator>::destroy(a, std::addressof(tmp.value));
+            return true;
+        } else {
+            (void)cb;
+            (void)value;
+            (void)alloc;
+            return false;
+        }
+    }
+
+    static constexpr void* recycle(base_type& cb, Allocator& alloc) noexcept {
+        cb_alloc              a(alloc);
+        direct_control_block* p = std::addressof(self(cb));
+        p->destroy_value(alloc);
+        cb_traits::destroy(a, p);
+        return p;
+    }
+
+    static constexpr void destroy(base_type& cb, Allocator& alloc) noexcept {
+#if BEMAN_INDIRECT_USE_TRACEPOINTS
+        if (!is_constant_evaluated())
+            probe_polymorphic_destroy(type_name_hash_v<U>, sizeof(direct_control_block));
+#endif
+        cb_alloc              a(alloc);
+        direct_control_block* p = std::addressof(self(cb));
+        p->destroy_value(alloc);
+        cb_traits::destroy(a, p);
+        cb_traits::deallocate(a, p, 1);
     }
 };
 
+// Allocate a direct_control_block<T, U, Allocator> and construct its U from args.
+// Reports the new object's address through p.
+template <class T, class U, class Allocator, class... Args>
+BEMAN_INDIRECT_CONSTEXPR_DTOR control_block<T, Allocator>* make_control_block(Allocator& alloc,
+                                                                              T*&        p,
+                                                                              Args&&... args) {
+    using cb        = direct_control_block<T, U, Allocator>;
+    using cb_traits = typename cb::cb_traits;
+
+#if BEMAN_INDIRECT_USE_LATENCY_HOOKS
+    const std::uint64_t start = latency_start();
+#endif
+    typename cb::cb_alloc a(alloc);
+    auto*                 mem = cb_traits::allocate(a, 1);
+    try {
+        construct_at_impl(mem, alloc, std::forward<Args>(args)...);
+    } catch (...) {
+        cb_traits::deallocate(a, mem, 1);
+        throw;
+    }
+#if BEMAN_INDIRECT_USE_LATENCY_HOOKS
+    latency_stop(latency_op::polymorphic_construct, start);
+#endif
+#if BEMAN_INDIRECT_USE_TRACEPOINTS
+    if (!is_constant_evaluated())
+        probe_polymorphic_construct(type_name_hash_v<U>, sizeof(cb));
+#endif
+    p = mem->get();
+    return mem;
+}
+
 } // namespace detail
 
+template <class T, class Allocator>
+class polymorphic;
+
+class polymorphic_type_id;
+
+namespace detail {
+
+// The id of the type whose type_tag_v is at tag.
+constexpr polymorphic_type_id type_id_from_tag(const void* tag) noexcept;
+
+} // namespace detail
+
+// Extension: identifies the dynamic type of the object owned by a
+// polymorphic, without RTTI. Two ids compare equal exactly when they name the
+// same type; a default-constructed id names no type, as does the id of a
+// valueless polymorphic.
+class polymorphic_type_id {
+  public:
+    constexpr polymorphic_type_id() noexcept = default;
+
+    template <class U>
+    static constexpr polymorphic_type_id of() noexcept {
+        return polymorphic_type_id(&detail::type_tag_v<U>);
+    }
+
+    friend constexpr bool operator==(polymorphic_type_id lhs, polymorphic_type_id rhs) noexcept {
+        return lhs.tag_ == rhs.tag_;
+    }
+
+    friend constexpr bool operator!=(polymorphic_type_id lhs, polymorphic_type_id rhs) noexcept {
+        return lhs.tag_ != rhs.tag_;
+    }
+
+  private:
+    template <class T, class Allocator>
+    friend class polymorphic;
+    friend struct std::hash<polymorphic_type_id>;
+    friend constexpr polymorphic_type_id detail::type_id_from_tag(const void* tag) noexcept;
+
+    constexpr explicit polymorphic_type_id(const void* tag) noexcept : tag_(tag) {}
+
+    const void* tag_ = nullptr;
+};
+
+constexpr polymorphic_type_id detail::type_id_from_tag(const void* tag) noexcept { return polymorphic_type_id(tag); }
+
 // [polymorphic] Class template polymorphic
 // N5032 §20.4.2
 template <class T, class Allocator = std::allocator<T>>
@@ -103,15 +371,6 @@ class polymorphic {
     using alloc_traits = std::allocator_traits<Allocator>;
     using cb_type      = detail::control_block<T, Allocator>;
 
-    template <class U>
-    using direct_cb = detail::direct_control_block<T, U, Allocator>;
-
-    template <class U>
-    using cb_alloc = typename alloc_traits::template rebind_alloc<direct_cb<U>>;
-
-    template <class U>
-    using cb_traits = std::allocator_traits<cb_alloc<U>>;
-
   public:
     using value_type     = T;
     using allocator_type = Allocator;
@@ -130,30 +389,32 @@ class polymorphic {
     {
         static_assert(std::is_default_constructible_v<T>);
         static_assert(std::is_copy_constructible_v<T>);
-        cb_ = make_cb<T>(alloc_);
+        cb_ = make_cb<T>(alloc_, p_);
     }
 
     constexpr explicit polymorphic(std::allocator_arg_t, const Allocator& a) : alloc_(a) {
         static_assert(std::is_default_constructible_v<T>);
         static_assert(std::is_copy_constructible_v<T>);
-        cb_ = make_cb<T>(alloc_);
+        cb_ = make_cb<T>(alloc_, p_);
     }
 
     constexpr polymorphic(const polymorphic& other)
         : alloc_(alloc_traits::select_on_container_copy_construction(other.alloc_)) {
         if (!other.valueless_after_move()) {
-            cb_ = other.cb_->clone(alloc_);
+            cb_ = other.cb_->clone(alloc_, p_);
         }
     }
 
     constexpr polymorphic(std::allocator_arg_t, const Allocator& a, const polymorphic& other) : alloc_(a) {
         if (!other.valueless_after_move()) {
-            cb_ = other.cb_->clone(alloc_);
+            cb_ = other.cb_->clone(alloc_, p_);
         }
     }
 
-    constexpr polymorphic(polymorphic&& other) noexcept : alloc_(std::move(other.alloc_)), cb_(other.cb_) {
+    constexpr polymorphic(polymorphic&& other) noexcept
+        : alloc_(std::move(other.alloc_)), cb_(other.cb_), p_(other.p_) {
         other.cb_ = nullptr;
+        other.p_  = nullptr;
     }
 
     constexpr polymorphic(std::allocator_arg_t,
@@ -163,14 +424,12 @@ class polymorphic {
         if (other.valueless_after_move()) {
             // *this is valueless
         } else if constexpr (alloc_traits::is_always_equal::value) {
-            cb_       = other.cb_;
-            other.cb_ = nullptr;
+            steal(other);
         } else {
             if (alloc_ == other.alloc_) {
-                cb_       = other.cb_;
-                other.cb_ = nullptr;
+                steal(other);
             } else {
-                cb_ = other.cb_->move_clone(alloc_);
+                cb_ = other.cb_->move_clone(alloc_, p_);
                 other.reset();
             }
         }
@@ -194,7 +453,7 @@ class polymorphic {
                                int> = 0>
 #endif
     constexpr explicit polymorphic(U&& u) {
-        cb_ = make_cb<detail::remove_cvref_t<U>>(alloc_, std::forward<U>(u));
+        cb_ = make_cb<detail::remove_cvref_t<U>>(alloc_, p_, std::forward<U>(u));
     }
 
 #if BEMAN_INDIRECT_USE_CONCEPTS
@@ -214,7 +473,7 @@ class polymorphic {
                                int> = 0>
 #endif
     constexpr explicit polymorphic(std::allocator_arg_t, const Allocator& a, U&& u) : alloc_(a) {
-        cb_ = make_cb<detail::remove_cvref_t<U>>(alloc_, std::forward<U>(u));
+        cb_ = make_cb<detail::remove_cvref_t<U>>(alloc_, p_, std::forward<U>(u));
     }
 
 #if BEMAN_INDIRECT_USE_CONCEPTS
@@ -231,7 +490,7 @@ class polymorphic {
                                int> = 0>
 #endif
     constexpr explicit polymorphic(std::in_place_type_t<U>, Ts&&... ts) {
-        cb_ = make_cb<U>(alloc_, std::forward<Ts>(ts)...);
+        cb_ = make_cb<U>(alloc_, p_, std::forward<Ts>(ts)...);
     }
 
 #if BEMAN_INDIRECT_USE_CONCEPTS
@@ -247,7 +506,7 @@ class polymorphic {
 #endif
     constexpr explicit polymorphic(std::allocator_arg_t, const Allocator& a, std::in_place_type_t<U>, Ts&&... ts)
         : alloc_(a) {
-        cb_ = make_cb<U>(alloc_, std::forward<Ts>(ts)...);
+        cb_ = make_cb<U>(alloc_, p_, std::forward<Ts>(ts)...);
     }
 
 #if BEMAN_INDIRECT_USE_CONCEPTS
@@ -265,7 +524,7 @@ class polymorphic {
                                int> = 0>
 #endif
     constexpr explicit polymorphic(std::in_place_type_t<U>, std::initializer_list<I> ilist, Us&&... us) {
-        cb_ = make_cb<U>(alloc_, ilist, std::forward<Us>(us)...);
+        cb_ = make_cb<U>(alloc_, p_, ilist, std::forward<Us>(us)...);
     }
 
 #if BEMAN_INDIRECT_USE_CONCEPTS
@@ -284,7 +543,7 @@ class polymorphic {
     constexpr explicit polymorphic(
         std::allocator_arg_t, const Allocator& a, std::in_place_type_t<U>, std::initializer_list<I> ilist, Us&&... us)
         : alloc_(a) {
-        cb_ = make_cb<U>(alloc_, ilist, std::forward<Us>(us)...);
+        cb_ = make_cb<U>(alloc_, p_, ilist, std::forward<Us>(us)...);
     }
 
     // [polymorphic.dtor] destructor
@@ -304,12 +563,19 @@ class polymorphic {
         constexpr bool pocca                  = alloc_traits::propagate_on_container_copy_assignment::value;
         Allocator      alloc_for_construction = pocca ? other.alloc_ : alloc_;
 
-        cb_type* new_cb = nullptr;
-        if (!other.valueless_after_move()) {
-            new_cb = other.cb_->clone(alloc_for_construction);
+        if (other.valueless_after_move()) {
+            reset();
+        } else if (!valueless_after_move() && alloc_ == alloc_for_construction &&
+                   cb_->type_tag() == other.cb_->type_tag() && cb_->assign(*other.cb_, alloc_)) {
+            // Same dynamic type: the value was assigned into the existing block.
+        } else {
+            // Construct new first for strong exception guarantee
+            T*       new_p  = nullptr;
+            cb_type* new_cb = other.cb_->clone(alloc_for_construction, new_p);
+            reset();
+            cb_ = new_cb;
+            p_  = new_p;
         }
-        reset();
-        cb_ = new_cb;
 
         if constexpr (pocca) {
             alloc_ = other.alloc_;
@@ -332,12 +598,13 @@ class polymorphic {
             reset();
         } else if (pocma || alloc_ == other.alloc_) {
             reset();
-            cb_       = other.cb_;
-            other.cb_ = nullptr;
+            steal(other);
         } else {
-            cb_type* new_cb = other.cb_->move_clone(alloc_);
+            T*       new_p  = nullptr;
+            cb_type* new_cb = other.cb_->move_clone(alloc_, new_p);
             reset();
             cb_ = new_cb;
+            p_  = new_p;
             other.reset();
         }
 
@@ -347,32 +614,103 @@ class polymorphic {
         return *this;
     }
 
+    // Extension: emplace
+
+    // Replaces the owned object with a U constructed from ts. When the current
+    // control block has the same size and alignment as the one U needs, its
+    // allocation is reused; otherwise a new block is allocated.
+    //
+    // If a new block is allocated and constructing U throws, *this is unchanged
+    // (strong guarantee). If the block is reused, the old object has already
+    // been destroyed: the allocation is released and *this is left valueless
+    // (basic guarantee). ts must not refer to the current object.
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U, class... Ts>
+        requires(std::is_same_v<detail::remove_cvref_t<U>, U> && detail::derived_from_v<U, T> &&
+                 std::is_constructible_v<U, Ts...> && std::is_copy_constructible_v<U>)
+#else
+    template <class U,
+              class... Ts,
+              std::enable_if_t<std::is_same_v<detail::remove_cvref_t<U>, U> && detail::derived_from_v<U, T> &&
+                                   std::is_constructible_v<U, Ts...> && std::is_copy_constructible_v<U>,
+                               int> = 0>
+#endif
+    BEMAN_INDIRECT_CONSTEXPR_DTOR U& emplace(Ts&&... ts) {
+        return emplace_cb<U>(std::forward<Ts>(ts)...);
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U, class I, class... Us>
+        requires(std::is_same_v<detail::remove_cvref_t<U>, U> && detail::derived_from_v<U, T> &&
+                 std::is_constructible_v<U, std::initializer_list<I>&, Us...> && std::is_copy_constructible_v<U>)
+#else
+    template <class U,
+              class I,
+              class... Us,
+              std::enable_if_t<std::is_same_v<detail::remove_cvref_t<U>, U> && detail::derived_from_v<U, T> &&
+                                   std::is_constructible_v<U, std::initializer_list<I>&, Us...> &&
+                                   std::is_copy_constructible_v<U>,
+                               int> = 0>
+#endif
+    BEMAN_INDIRECT_CONSTEXPR_DTOR U& emplace(std::initializer_list<I> ilist, Us&&... us) {
+        return emplace_cb<U>(ilist, std::forward<Us>(us)...);
+    }
+
     // [polymorphic.obs] observers
 
     constexpr const T& operator*() const noexcept {
         assert(!valueless_after_move());
-        return *(cb_->p_);
+        return *p_;
     }
 
     constexpr T& operator*() noexcept {
         assert(!valueless_after_move());
-        return *(cb_->p_);
+        return *p_;
     }
 
     constexpr const_pointer operator->() const noexcept {
         assert(!valueless_after_move());
-        return std::pointer_traits<const_pointer>::pointer_to(*(cb_->p_));
+        return std::pointer_traits<const_pointer>::pointer_to(*p_);
     }
 
     constexpr pointer operator->() noexcept {
         assert(!valueless_after_move());
-        return std::pointer_traits<pointer>::pointer_to(*(cb_->p_));
+        return std::pointer_traits<pointer>::pointer_to(*p_);
     }
 
     constexpr bool valueless_after_move() const noexcept { return cb_ == nullptr; }
 
     constexpr allocator_type get_allocator() const noexcept { return alloc_; }
 
+    // Extension: dynamic type queries
+
+    // The dynamic type of the owned object, read from the control block.
+    constexpr polymorphic_type_id type_id() const noexcept {
+        return cb_ ? polymorphic_type_id(cb_->type_tag()) : polymorphic_type_id();
+    }
+
+    // True when the owned object's dynamic type is exactly U; an object of a
+    // type derived from U does not count. A single comparison, with no RTTI
+    // lookup and no walk of the class hierarchy.
+    template <class U>
+    constexpr bool holds() const noexcept {
+        static_assert(detail::derived_from_v<U, T>, "U must be T or derived from T");
+        return cb_ && cb_->type_tag() == &detail::type_tag_v<U>;
+    }
+
+    // The owned object as a U if holds<U>(), nullptr otherwise.
+    template <class U>
+    constexpr U* get_if() noexcept {
+        if (!holds<U>())
+            return nullptr;
+        return std::addressof(static_cast<detail::direct_control_block<T, U, Allocator>*>(cb_)->storage_.value);
+    }
+
+    template <class U>
+    constexpr const U* get_if() const noexcept {
+        return const_cast<polymorphic&>(*this).template get_if<U>();
+    }
+
     // [polymorphic.swap] swap
 
     constexpr void swap(polymorphic& other) noexcept(alloc_traits::propagate_on_container_swap::value ||
@@ -381,6 +719,7 @@ class polymorphic {
         assert(alloc_traits::propagate_on_container_swap::value || alloc_ == other.alloc_);
         using std::swap;
         swap(cb_, other.cb_);
+        swap(p_, other.p_);
         if constexpr (alloc_traits::propagate_on_container_swap::value) {
             swap(alloc_, other.alloc_);
         }
@@ -390,31 +729,87 @@ class polymorphic {
 
   private:
     template <class U, class... Args>
-    BEMAN_INDIRECT_CONSTEXPR_DTOR static cb_type* make_cb(Allocator& alloc, Args&&... args) {
-        cb_alloc<U> a(alloc);
-        auto*       mem = cb_traits<U>::allocate(a, 1);
+    BEMAN_INDIRECT_CONSTEXPR_DTOR static cb_type* make_cb(Allocator& alloc, T*& p, Args&&... args) {
+        return detail::make_control_block<T, U>(alloc, p, std::forward<Args>(args)...);
+    }
+
+    // Build a block for U in the current block's allocation when recycle()
+    // accepts it, or in a fresh allocation otherwise. Storage cannot change
+    // type during constant evaluation, so that path always allocates.
+    template <class U, class... Args>
+    BEMAN_INDIRECT_CONSTEXPR_DTOR U& emplace_cb(Args&&... args) {
+        using new_cb    = detail::direct_control_block<T, U, Allocator>;
+        using cb_traits = typename new_cb::cb_traits;
+
+        typename new_cb::cb_alloc a(alloc_);
+        new_cb*                   mem = nullptr;
+        if (cb_ && !detail::is_constant_evaluated()) {
+            mem = static_cast<new_cb*>(cb_->recycle(sizeof(new_cb), alignof(new_cb), alloc_));
+        }
+        if (mem) {
+            // The old object is gone; *this stays valueless if construction throws.
+            cb_ = nullptr;
+            p_  = nullptr;
+        } else {
+            mem = cb_traits::allocate(a, 1);
+        }
         try {
-            detail::construct_at_impl(mem, alloc, std::forward<Args>(args)...);
+            detail::construct_at_impl(mem, alloc_, std::forward<Args>(args)...);
         } catch (...) {
-            cb_traits<U>::deallocate(a, mem, 1);
+            cb_traits::deallocate(a, mem, 1);
             throw;
         }
-        return mem;
+        reset();
+        cb_ = mem;
+        p_  = mem->get();
+        return mem->storage_.value;
+    }
+
+    // Take ownership of other's block. Allocators must already be known to be compatible.
+    constexpr void steal(polymorphic& other) noexcept {
+        cb_       = other.cb_;
+        p_        = other.p_;
+        other.cb_ = nullptr;
+        other.p_  = nullptr;
     }
 
     constexpr void reset() {
-        if (cb_) {
-            cb_->destroy(alloc_);
-            cb_ = nullptr;
+        // In arena mode, see indirect::reset; is_arena_discardable<T> vouches
+        // for every type derived from T.
+        if constexpr (!(is_arena_allocator_v<Allocator> && is_arena_discardable_v<T>)) {
+            if (cb_)
+                cb_->destroy(alloc_);
         }
+        cb_ = nullptr;
+        p_  = nullptr;
     }
 
+    // p_ caches the address of the owned object inside *cb_ so that observers
+    // need a single dependent load, as with unique_ptr.
     BEMAN_INDIRECT_NO_UNIQUE_ADDRESS Allocator alloc_ = Allocator();
     cb_type*                                   cb_    = nullptr;
+    T*                                         p_     = nullptr;
 };
 
+// The control block and object pointers are raw and point away from the
+// handle, so only the allocator matters.
+template <class T, class Allocator>
+struct is_trivially_relocatable<polymorphic<T, Allocator>> : is_trivially_relocatable<Allocator> {};
+
+// In arena mode the handle's destructor does nothing.
+template <class T, class Allocator>
+struct is_arena_discardable<polymorphic<T, Allocator>>
+    : std::bool_constant<is_arena_allocator_v<Allocator> && is_arena_discardable_v<T>> {};
+
 } // namespace beman::indirect
 
+template <>
+struct std::hash<beman::indirect::polymorphic_type_id> {
+    std::size_t operator()(beman::indirect::polymorphic_type_id id) const noexcept {
+        return std::hash<const void*>{}(id.tag_);
+    }
+};
+
 namespace beman::indirect::pmr {
 
 template <class T>
@@ -0,0 +1,457 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef BEMAN_INDIRECT_POLYMORPHIC_COLLECTION_HPP
+#define BEMAN_INDIRECT_POLYMORPHIC_COLLECTION_HPP
+
+#include <beman/indirect/detail/config.hpp>
+#include <beman/indirect/polymorphic.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace beman::indirect {
+
+namespace detail {
+
+template <class T, class Allocator>
+struct segment;
+
+// Dispatch table for a segment, one per element type U, in the manner of
+// control_block_ops. data returns the first element as a T*; consecutive
+// elements are `stride` bytes apart. erase_if removes the elements for which
+// pred(element, context) is true and returns how many it removed.
+template <class T, class Allocator>
+struct segment_ops {
+    using segment_type = segment<T, Allocator>;
+
+    segment_type* (*clone)(const segment_type& self, const Allocator& alloc);
+    void (*destroy)(segment_type& self, Allocator& alloc) noexcept;
+    T* (*data)(const segment_type& self) noexcept;
+    std::size_t (*size)(const segment_type& self) noexcept;
+    std::size_t (*erase_if)(segment_type& self, bool (*pred)(const T&, void*), void* context);
+    std::size_t stride;
+    const void* type_tag;
+};
+
+// Type-erased run of elements of one dynamic type. Segments are chained in
+// the order their types were first inserted.
+template <class T, class Allocator>
+struct segment {
+    const segment_ops<T, Allocator>* ops;
+    segment*                         next = nullptr;
+
+    constexpr explicit segment(const segment_ops<T, Allocator>* table) noexcept : ops(table) {}
+
+  protected:
+    ~segment() = default;
+};
+
+template <class T, class U, class Allocator>
+struct typed_segment;
+
+template <class T, class U, class Allocator>
+inline constexpr segment_ops<T, Allocator> typed_segment_ops = {
+    &typed_segment<T, U, Allocator>::clone,
+    &typed_segment<T, U, Allocator>::destroy,
+    &typed_segment<T, U, Allocator>::data,
+    &typed_segment<T, U, Allocator>::size,
+    &typed_segment<T, U, Allocator>::erase_if,
+    sizeof(U),
+    &type_tag_v<U>,
+};
+
+// Segment holding its elements in a vector of U.
+template <class T, class U, class Allocator>
+struct typed_segment final : segment<T, Allocator> {
+    using base_type  = segment<T, Allocator>;
+    using seg_alloc  = typename std::allocator_traits<Allocator>::template rebind_alloc<typed_segment>;
+    using seg_traits = std::allocator_traits<seg_alloc>;
+    using items_type = std::vector<U, typename std::allocator_traits<Allocator>::template rebind_alloc<U>>;
+
+    items_type items;
+
+    explicit typed_segment(const Allocator& alloc) : base_type(&typed_segment_ops<T, U, Allocator>), items(alloc) {}
+
+    typed_segment(const typed_segment& other, const Allocator& alloc)
+        : base_type(&typed_segment_ops<T, U, Allocator>), items(other.items, alloc) {}
+
+    static typed_segment* make(const Allocator& alloc) {
+        seg_alloc a(alloc);
+        auto*     mem = seg_traits::allocate(a, 1);
+        try {
+            return construct_at_impl(mem, alloc);
+        } catch (...) {
+            seg_traits::deallocate(a, mem, 1);
+            throw;
+        }
+    }
+
+    template <class Pred>
+    std::size_t erase_where(Pred pred) {
+        const std::size_t before = items.size();
+        if constexpr (std::is_move_assignable_v<U>) {
+            items.erase(std::remove_if(items.begin(), items.end(), pred), items.end());
+        } else {
+            // Without move assignment, survivors are copied into a new vector.
+            items_type kept(items.get_allocator());
+            kept.reserve(items.size());
+            for (const U& u : items) {
+                if (!pred(u))
+                    kept.push_back(u);
+            }
+            items.swap(kept);
+        }
+        return before - items.size();
+    }
+
+    // Table entries.
+
+    static const typed_segment& self(const base_type& s) noexcept { return static_cast<const typed_segment&>(s); }
+
+    static base_type* clone(const base_type& s, const Allocator& alloc) {
+        seg_alloc a(alloc);
+        auto*     mem = seg_traits::allocate(a, 1);
+        try {
+            return construct_at_impl(mem, self(s), alloc);
+        } catch (...) {
+            seg_traits::deallocate(a, mem, 1);
+            throw;
+        }
+    }
+
+    static void destroy(base_type& s, Allocator& alloc) noexcept {
+        seg_alloc      a(alloc);
+        typed_segment* p = std::addressof(static_cast<typed_segment&>(s));
+        seg_traits::destroy(a, p);
+        seg_traits::deallocate(a, p, 1);
+    }
+
+    static T* data(const base_type& s) noexcept {
+        // The elements are never const objects, whatever the constness of the
+        // collection that reaches them.
+        return const_cast<U*>(self(s).items.data());
+    }
+
+    static std::size_t size(const base_type& s) noexcept { return self(s).items.size(); }
+
+    static std::size_t erase_if(base_type& s, bool (*pred)(const T&, void*), void* context) {
+        return static_cast<typed_segment&>(s).erase_where([&](const U& u) { return pred(u, context); });
+    }
+};
+
+} // namespace detail
+
+// polymorphic_collection: a container of objects derived from T, grouped by
+// dynamic type.
+//
+// Elements of each dynamic type U are stored by value, contiguously, in a
+// segment of their own, so iterating visits one type at a time and walks
+// memory linearly: virtual calls through the T& that for_each passes are
+// predicted, and for_each<U> reaches the elements as U& with no type erasure
+// at all. Iteration follows segment order (the order in which each type was
+// first inserted), then insertion order within a segment.
+//
+// Copying is deep, one vector copy per segment. Inserting into a segment may
+// reallocate it, invalidating references to its elements; erasing preserves
+// the order of the remaining elements.
+template <class T, class Allocator = std::allocator<T>>
+class polymorphic_collection {
+    static_assert(std::is_object_v<T>, "T must be an object type");
+    static_assert(!std::is_array_v<T>, "T must not be an array type");
+    static_assert(!std::is_const_v<T> && !std::is_volatile_v<T>, "T must not be cv-qualified");
+    static_assert(std::is_same_v<T, typename std::allocator_traits<Allocator>::value_type>,
+                  "Allocator::value_type must be T");
+
+    using alloc_traits = std::allocator_traits<Allocator>;
+    using segment_type = detail::segment<T, Allocator>;
+
+    template <class U>
+    using typed_segment = detail::typed_segment<T, U, Allocator>;
+
+  public:
+    using value_type     = T;
+    using allocator_type = Allocator;
+    using size_type      = std::size_t;
+
+    // constructors
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    polymorphic_collection()
+        requires std::is_default_constructible_v<Allocator>
+#else
+    template <class Alloc_ = Allocator, std::enable_if_t<std::is_default_constructible_v<Alloc_>, int> = 0>
+    polymorphic_collection()
+#endif
+    {
+    }
+
+    explicit polymorphic_collection(std::allocator_arg_t, const Allocator& a) : alloc_(a) {}
+
+    polymorphic_collection(const polymorphic_collection& other)
+        : alloc_(alloc_traits::select_on_container_copy_construction(other.alloc_)) {
+        copy_from(other);
+    }
+
+    polymorphic_collection(std::allocator_arg_t, const Allocator& a, const polymorphic_collection& other)
+        : alloc_(a) {
+        copy_from(other);
+    }
+
+    polymorphic_collection(polymorphic_collection&& other) noexcept
+        : alloc_(std::move(other.alloc_)), head_(other.head_) {
+        other.head_ = nullptr;
+    }
+
+    ~polymorphic_collection() { clear(); }
+
+    // assignment
+
+    polymorphic_collection& operator=(const polymorphic_collection& other) {
+        if (std::addressof(other) == this)
+            return *this;
+
+        constexpr bool pocca = alloc_traits::propagate_on_container_copy_assignment::value;
+
+        // Copy first for the strong exception guarantee.
+        polymorphic_collection tmp(std::allocator_arg, pocca ? other.alloc_ : alloc_, other);
+        clear();
+        if constexpr (pocca) {
+            alloc_ = other.alloc_;
+        }
+        steal(tmp);
+        return *this;
+    }
+
+    polymorphic_collection&
+    operator=(polymorphic_collection&& other) noexcept(alloc_traits::propagate_on_container_move_assignment::value ||
+                                                       alloc_traits::is_always_equal::value) {
+        if (std::addressof(other) == this)
+            return *this;
+
+        constexpr bool pocma = alloc_traits::propagate_on_container_move_assignment::value;
+
+        if (pocma || alloc_ == other.alloc_) {
+            clear();
+            if constexpr (pocma) {
+                alloc_ = other.alloc_;
+            }
+            steal(other);
+        } else {
+            // Storage cannot change hands between unequal allocators.
+            polymorphic_collection tmp(std::allocator_arg, alloc_, other);
+            clear();
+            steal(tmp);
+            other.clear();
+        }
+        return *this;
+    }
+
+    // modifiers
+
+    // Constructs a U from args at the end of U's segment.
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U, class... Args>
+        requires(std::is_same_v<detail::remove_cvref_t<U>, U> && detail::derived_from_v<U, T> &&
+                 std::is_constructible_v<U, Args...> && std::is_copy_constructible_v<U>)
+#else
+    template <class U,
+              class... Args,
+              std::enable_if_t<std::is_same_v<detail::remove_cvref_t<U>, U> && detail::derived_from_v<U, T> &&
+                                   std::is_constructible_v<U, Args...> && std::is_copy_constructible_v<U>,
+                               int> = 0>
+#endif
+    U& emplace(Args&&... args) {
+        return segment_for<U>().items.emplace_back(std::forward<Args>(args)...);
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U>
+        requires(detail::derived_from_v<detail::remove_cvref_t<U>, T> &&
+                 std::is_constructible_v<detail::remove_cvref_t<U>, U> &&
+                 std::is_copy_constructible_v<detail::remove_cvref_t<U>>)
+#else
+    template <class U,
+              std::enable_if_t<detail::derived_from_v<detail::remove_cvref_t<U>, T> &&
+                                   std::is_constructible_v<detail::remove_cvref_t<U>, U> &&
+                                   std::is_copy_constructible_v<detail::remove_cvref_t<U>>,
+                               int> = 0>
+#endif
+    detail::remove_cvref_t<U>& insert(U&& u) {
+        return emplace<detail::remove_cvref_t<U>>(std::forward<U>(u));
+    }
+
+    // Erases the elements for which pred(const T&) is true and returns how
+    // many were erased. The predicate is called through a function pointer;
+    // erase_if<U> calls it directly.
+    template <class Pred>
+    size_type erase_if(Pred pred) {
+        auto call = [](const T& t, void* context) -> bool { return (*static_cast<Pred*>(context))(t); };
+
+        size_type erased = 0;
+        for (segment_type* s = head_; s; s = s->next)
+            erased += s->ops->erase_if(*s, call, std::addressof(pred));
+        return erased;
+    }
+
+    // Erases the elements of U's segment for which pred(const U&) is true.
+    template <class U, class Pred>
+    size_type erase_if(Pred pred) {
+        typed_segment<U>* s = find<U>();
+        return s ? s->erase_where([&](const U& u) -> bool { return pred(u); }) : 0;
+    }
+
+    // Destroys every element and releases every segment.
+    void clear() noexcept {
+        while (head_) {
+            segment_type* next = head_->next;
+            head_->ops->destroy(*head_, alloc_);
+            head_ = next;
+        }
+    }
+
+    // iteration
+
+    // Calls f(T&) on every element, one segment at a time.
+    template <class F>
+    void for_each(F f) {
+        for_each_impl<T>(head_, f);
+    }
+
+    template <class F>
+    void for_each(F f) const {
+        for_each_impl<const T>(head_, f);
+    }
+
+    // Calls f(U&) on every element of U's segment. The elements are reached
+    // as U, so calls through them resolve statically when U is final.
+    template <class U, class F>
+    void for_each(F f) {
+        if (typed_segment<U>* s = find<U>()) {
+            for (U& u : s->items)
+                f(u);
+        }
+    }
+
+    template <class U, class F>
+    void for_each(F f) const {
+        if (const typed_segment<U>* s = find<U>()) {
+            for (const U& u : s->items)
+                f(u);
+        }
+    }
+
+    // capacity
+
+    size_type size() const noexcept {
+        size_type n = 0;
+        for (segment_type* s = head_; s; s = s->next)
+            n += s->ops->size(*s);
+        return n;
+    }
+
+    template <class U>
+    size_type size() const noexcept {
+        const typed_segment<U>* s = find<U>();
+        return s ? s->items.size() : 0;
+    }
+
+    bool empty() const noexcept { return size() == 0; }
+
+    allocator_type get_allocator() const noexcept { return alloc_; }
+
+    // swap
+
+    void swap(polymorphic_collection& other) noexcept(alloc_traits::propagate_on_container_swap::value ||
+                                                      alloc_traits::is_always_equal::value) {
+        // Precondition: allocators must be equal when they don't propagate on swap.
+        assert(alloc_traits::propagate_on_container_swap::value || alloc_ == other.alloc_);
+        using std::swap;
+        swap(head_, other.head_);
+        if constexpr (alloc_traits::propagate_on_container_swap::value) {
+            swap(alloc_, other.alloc_);
+        }
+    }
+
+    friend void swap(polymorphic_collection& lhs, polymorphic_collection& rhs) noexcept(noexcept(lhs.swap(rhs))) {
+        lhs.swap(rhs);
+    }
+
+  private:
+    template <class U>
+    typed_segment<U>* find() const noexcept {
+        for (segment_type* s = head_; s; s = s->next) {
+            if (s->ops->type_tag == &detail::type_tag_v<U>)
+                return static_cast<typed_segment<U>*>(s);
+        }
+        return nullptr;
+    }
+
+    // U's segment, appended to the chain if it does not exist yet.
+    template <class U>
+    typed_segment<U>& segment_for() {
+        segment_type** link = &head_;
+        for (; *link; link = &(*link)->next) {
+            if ((*link)->ops->type_tag == &detail::type_tag_v<U>)
+                return static_cast<typed_segment<U>&>(**link);
+        }
+        typed_segment<U>* s = typed_segment<U>::make(alloc_);
+        *link               = s;
+        return *s;
+    }
+
+    // Elements are reached through their T subobjects: the segment's first
+    // one, then steps of `stride` bytes, the size of its element type.
+    template <class Elem, class F>
+    static void for_each_impl(segment_type* s, F& f) {
+        for (; s; s = s->next) {
+            const std::size_t n = s->ops->size(*s);
+            if (n == 0)
+                continue;
+            const std::size_t stride = s->ops->stride;
+            auto*             bytes  = reinterpret_cast<unsigned char*>(s->ops->data(*s));
+            for (std::size_t i = 0; i < n; ++i)
+                f(*std::launder(reinterpret_cast<Elem*>(bytes + i * stride)));
+        }
+    }
+
+    void copy_from(const polymorphic_collection& other) {
+        segment_type** link = &head_;
+        try {
+            for (segment_type* s = other.head_; s; s = s->next) {
+                *link = s->ops->clone(*s, alloc_);
+                link  = &(*link)->next;
+            }
+        } catch (...) {
+            clear();
+            throw;
+        }
+    }
+
+    // Take over other's segments. *this must be empty and its allocator able
+    // to release what other owns.
+    void steal(polymorphic_collection& other) noexcept {
+        head_       = other.head_;
+        other.head_ = nullptr;
+    }
+
+    BEMAN_INDIRECT_NO_UNIQUE_ADDRESS Allocator alloc_ = Allocator();
+    segment_type*                              head_  = nullptr;
+};
+
+} // namespace beman::indirect
+
+namespace beman::indirect::pmr {
+
+template <class T>
+using polymorphic_collection = beman::indirect::polymorphic_collection<T, std::pmr::polymorphic_allocator<T>>;
+
+} // namespace beman::indirect::pmr
+
+#endif // BEMAN_INDIRECT_POLYMORPHIC_COLLECTION_HPP
@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef BEMAN_INDIRECT_POLYMORPHIC_POOL_RESOURCE_HPP
+#define BEMAN_INDIRECT_POLYMORPHIC_POOL_RESOURCE_HPP
+
+#include <beman/indirect/pool_allocator.hpp>
+
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include <utility>
+
+namespace beman::indirect {
+
+// Occupancy of one size class of polymorphic_pool_resource.
+struct size_class_stats {
+    std::size_t block_size;    // bytes per block
+    std::size_t in_use;        // blocks currently allocated
+    std::size_t allocations;   // blocks allocated since the program started
+    std::size_t deallocations; // blocks deallocated since the program started
+};
+
+// polymorphic_pool_resource: memory resource for pmr::polymorphic.
+//
+// Each derived type stored in a polymorphic gets a control block of its own
+// size, so a single fixed-size pool does not fit. This resource rounds every
+// request up to a multiple of 16 bytes and serves requests of up to 256 bytes
+// from one pool per size class, with the per-thread caches and lock-free
+// batch exchange of indirect_pool_allocator (see detail::fixed_pool). Larger
+// or over-aligned requests go to the upstream resource.
+//
+// The pools are the process-wide pools that back indirect_pool_allocator;
+// their memory comes from operator new and is never handed back. The resource
+// itself only dispatches, and is thread-safe. stats() reports the occupancy
+// of those pools, and so covers every polymorphic_pool_resource in the
+// program; threads count their own allocations, so keeping the statistics
+// costs no atomic read-modify-write on the allocation path.
+class polymorphic_pool_resource : public std::pmr::memory_resource {
+  public:
+    static constexpr std::size_t granularity       = 16;
+    static constexpr std::size_t size_classes      = 16;
+    static constexpr std::size_t largest_pooled    = granularity * size_classes;
+    static constexpr std::size_t largest_alignment = granularity;
+
+    polymorphic_pool_resource() noexcept : polymorphic_pool_resource(std::pmr::get_default_resource()) {}
+
+    explicit polymorphic_pool_resource(std::pmr::memory_resource* upstream) noexcept : upstream_(upstream) {}
+
+    polymorphic_pool_resource(const polymorphic_pool_resource&)            = delete;
+    polymorphic_pool_resource& operator=(const polymorphic_pool_resource&) = delete;
+
+    std::pmr::memory_resource* upstream_resource() const noexcept { return upstream_; }
+
+    // Index of the size class serving a request, or size_classes if the
+    // request goes upstream.
+    static constexpr std::size_t size_class_of(std::size_t bytes, std::size_t alignment) noexcept {
+        if (bytes > largest_pooled || alignment > largest_alignment)
+            return size_classes;
+        return bytes == 0 ? 0 : (bytes - 1) / granularity;
+    }
+
+    // Counters are read without stopping other threads, so a snapshot taken
+    // while they allocate may be slightly out of date.
+    static size_class_stats stats(std::size_t size_class) {
+        const auto [allocations, deallocations] = pools()[size_class].counts();
+        return {(size_class + 1) * granularity,
+                allocations > deallocations ? allocations - deallocations : 0,
+                allocations,
+                deallocations};
+    }
+
+    static std::array<size_class_stats, size_classes> stats() {
+        std::array<size_class_stats, size_classes> result{};
+        for (std::size_t i = 0; i < size_classes; ++i)
+            result[i] = stats(i);
+        return result;
+    }
+
+  protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        const std::size_t cls = size_class_of(bytes, alignment);
+        if (cls == size_classes)
+            return upstream_->allocate(bytes, alignment);
+        return pools()[cls].allocate();
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        const std::size_t cls = size_class_of(bytes, alignment);
+        if (cls == size_classes) {
+            upstream_->deallocate(p, bytes, alignment);
+            return;
+        }
+        pools()[cls].deallocate(p);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+  private:
+    struct pool_ops {
+        void* (*allocate)();
+        void (*deallocate)(void*) noexcept;
+        std::pair<std::size_t, std::size_t> (*counts)();
+    };
+
+    template <std::size_t... I>
+    static constexpr std::array<pool_ops, size_classes> make_pools(std::index_sequence<I...>) noexcept {
+        return {{{&detail::fixed_pool<(I + 1) * granularity, largest_alignment>::allocate,
+                  &detail::fixed_pool<(I + 1) * granularity, largest_alignment>::deallocate,
+                  &detail::fixed_pool<(I + 1) * granularity, largest_alignment>::counts}...}};
+    }
+
+    static const std::array<pool_ops, size_classes>& pools() noexcept {
+        static constexpr std::array<pool_ops, size_classes> table =
+            make_pools(std::make_index_sequence<size_classes>());
+        return table;
+    }
+
+    std::pmr::memory_resource* upstream_;
+};
+
+} // namespace beman::indirect
+
+#endif // BEMAN_INDIRECT_POLYMORPHIC_POOL_RESOURCE_HPP
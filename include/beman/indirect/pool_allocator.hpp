@@ -0,0 +1,290 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef BEMAN_INDIRECT_POOL_ALLOCATOR_HPP
+#define BEMAN_INDIRECT_POOL_ALLOCATOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace beman::indirect {
+
+namespace detail {
+
+// A free block. Blocks in a batch are chained through next; batches parked on
+// the overflow list are chained through next_batch of their first block.
+struct pool_block {
+    pool_block* next;
+    pool_block* next_batch;
+};
+
+// Process-wide pool of blocks of Size bytes aligned to Align.
+//
+// Each thread allocates from and frees to its own cache without
+// synchronization, and trades blocks with the other threads a batch at a
+// time. A cache that runs dry takes a batch from the shared slots, and only
+// carves a new slab from operator new when there is none; a cache that grows
+// to two batches publishes one. A slot holds either a whole batch or nothing,
+// so taking one is a single exchange and publishing one a single
+// compare-exchange from null: both are lock-free, and neither can suffer from
+// ABA. Batches that find every slot full go to an overflow stack, which is
+// only ever drained as a whole.
+//
+// A block freed on a thread other than the one that allocated it simply joins
+// the freeing thread's cache, and reaches other threads as part of a batch.
+// A thread's cache is published when the thread exits.
+//
+// Slabs are never returned to the system: the pool is meant for long-lived
+// programs that keep allocating objects of the same size.
+template <std::size_t Size, std::size_t Align>
+class fixed_pool {
+    static_assert(Size >= sizeof(pool_block) && Size % Align == 0);
+    static_assert(Align >= alignof(pool_block));
+
+  public:
+    static constexpr std::size_t batch_size   = 32;
+    static constexpr std::size_t shared_slots = 64;
+    static constexpr std::size_t slab_blocks  = batch_size * std::max<std::size_t>(1, 16384 / (Size * batch_size));
+
+    static void* allocate() {
+        thread_cache& c = cache();
+        if (!c.head)
+            refill(c);
+        pool_block* b = c.head;
+        c.head        = b->next;
+        --c.count;
+        if (c.exited) {
+            flush(c, c.count);
+            retired_allocations_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            bump(c.allocations);
+        }
+        return b;
+    }
+
+    static void deallocate(void* p) noexcept {
+        thread_cache& c = cache();
+        auto*         b = static_cast<pool_block*>(p);
+        b->next         = c.head;
+        c.head          = b;
+        ++c.count;
+        if (c.exited) {
+            flush(c, c.count);
+            retired_deallocations_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        bump(c.deallocations);
+        if (c.count >= 2 * batch_size)
+            flush(c, batch_size);
+    }
+
+    // Blocks allocated and deallocated so far by all threads. Each thread
+    // counts its own operations without atomic read-modify-writes; this sums
+    // the live threads' counters and those of threads that have exited.
+    static std::pair<std::size_t, std::size_t> counts() {
+        std::lock_guard<std::mutex> lock(registry_mutex_);
+        std::size_t                 deallocations = retired_deallocations_.load(std::memory_order_relaxed);
+        std::size_t                 allocations   = retired_allocations_.load(std::memory_order_relaxed);
+        for (thread_cache* c = registry_; c; c = c->next_registered) {
+            deallocations += c->deallocations.load(std::memory_order_relaxed);
+            allocations += c->allocations.load(std::memory_order_relaxed);
+        }
+        return {allocations, deallocations};
+    }
+
+  private:
+    // Trivially destructible, so it stays usable while other thread-local
+    // objects are destroyed; cache_guard publishes it at thread exit. The
+    // counters are written only by the owning thread and read by counts().
+    struct thread_cache {
+        pool_block*              head;
+        std::size_t              count;
+        bool                     exited;
+        std::atomic<std::size_t> allocations;
+        std::atomic<std::size_t> deallocations;
+        thread_cache*            next_registered;
+    };
+
+    struct cache_guard {
+        thread_cache* c;
+
+        explicit cache_guard(thread_cache* cache) : c(cache) {
+            std::lock_guard<std::mutex> lock(registry_mutex_);
+            c->next_registered = registry_;
+            registry_          = c;
+        }
+
+        ~cache_guard() {
+            flush(*c, c->count);
+            std::lock_guard<std::mutex> lock(registry_mutex_);
+            thread_cache** link = &registry_;
+            while (*link != c)
+                link = &(*link)->next_registered;
+            *link = c->next_registered;
+            retired_allocations_.fetch_add(c->allocations.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            retired_deallocations_.fetch_add(c->deallocations.load(std::memory_order_relaxed),
+                                             std::memory_order_relaxed);
+            c->exited = true;
+        }
+    };
+
+    static thread_cache& cache() {
+        static thread_local thread_cache c{};
+        static thread_local cache_guard  guard(&c);
+        (void)guard;
+        return c;
+    }
+
+    // Increment a counter that only the calling thread writes.
+    static void bump(std::atomic<std::size_t>& counter) noexcept {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    static void refill(thread_cache& c) {
+        pool_block* batch = take();
+        if (!batch)
+            batch = new_slab();
+        std::size_t n = 0;
+        for (pool_block* b = batch; b; b = b->next)
+            ++n;
+        c.head  = batch;
+        c.count = n;
+    }
+
+    // Publish the first n blocks of c as a batch.
+    static void flush(thread_cache& c, std::size_t n) noexcept {
+        if (n == 0)
+            return;
+        pool_block* first = c.head;
+        pool_block* last  = first;
+        for (std::size_t i = 1; i < n; ++i)
+            last = last->next;
+        c.head     = last->next;
+        last->next = nullptr;
+        c.count -= n;
+        publish(first);
+    }
+
+    static void publish(pool_block* batch) noexcept {
+        for (auto& slot : slots_) {
+            pool_block* empty = nullptr;
+            if (slot.load(std::memory_order_relaxed) == nullptr &&
+                slot.compare_exchange_strong(empty, batch, std::memory_order_release, std::memory_order_relaxed))
+                return;
+        }
+        batch->next_batch = overflow_.load(std::memory_order_relaxed);
+        while (!overflow_.compare_exchange_weak(
+            batch->next_batch, batch, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+
+    static pool_block* take() noexcept {
+        for (auto& slot : slots_) {
+            if (slot.load(std::memory_order_relaxed) != nullptr) {
+                if (pool_block* batch = slot.exchange(nullptr, std::memory_order_acquire))
+                    return batch;
+            }
+        }
+        pool_block* batch = overflow_.exchange(nullptr, std::memory_order_acquire);
+        if (batch) {
+            for (pool_block* rest = batch->next_batch; rest;) {
+                pool_block* next = rest->next_batch;
+                publish(rest);
+                rest = next;
+            }
+        }
+        return batch;
+    }
+
+    // Allocate a slab, publish all but its first batch and return that one.
+    // An extra leading block links the slab into slabs_, which keeps it
+    // reachable for leak checkers.
+    static pool_block* new_slab() {
+        auto* bytes = static_cast<unsigned char*>(::operator new((slab_blocks + 1) * Size, std::align_val_t(Align)));
+        auto* slab  = ::new (static_cast<void*>(bytes)) pool_block{slabs_.load(std::memory_order_relaxed), nullptr};
+        while (!slabs_.compare_exchange_weak(slab->next, slab, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+        pool_block* result = nullptr;
+        for (std::size_t first = 1; first <= slab_blocks; first += batch_size) {
+            pool_block* batch = nullptr;
+            for (std::size_t i = first + batch_size; i-- > first;)
+                batch = ::new (static_cast<void*>(bytes + i * Size)) pool_block{batch, nullptr};
+            if (result)
+                publish(batch);
+            else
+                result = batch;
+        }
+        return result;
+    }
+
+    static inline std::atomic<pool_block*> slots_[shared_slots] = {};
+    static inline std::atomic<pool_block*> overflow_{nullptr};
+    static inline std::atomic<pool_block*> slabs_{nullptr};
+
+    static inline std::mutex               registry_mutex_;
+    static inline thread_cache*            registry_ = nullptr;
+    static inline std::atomic<std::size_t> retired_allocations_{0};
+    static inline std::atomic<std::size_t> retired_deallocations_{0};
+};
+
+} // namespace detail
+
+// indirect_pool_allocator: allocator for indirect<T, indirect_pool_allocator<T>>.
+//
+// indirect allocates exactly one T at a time, which this allocator serves
+// from a fixed-size pool with per-thread caches (see detail::fixed_pool)
+// instead of the general-purpose heap. Types with the same size and alignment
+// share a pool. Requests for more than one object go to std::allocator.
+//
+// The allocator is stateless and all instances compare equal, so it also
+// suits polymorphic, whose control blocks each get a pool of their own size.
+template <class T>
+class indirect_pool_allocator {
+    static constexpr std::size_t block_align = std::max(alignof(T), alignof(detail::pool_block));
+    static constexpr std::size_t block_size =
+        (std::max(sizeof(T), sizeof(detail::pool_block)) + block_align - 1) / block_align * block_align;
+
+    using pool = detail::fixed_pool<block_size, block_align>;
+
+  public:
+    using value_type                             = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using is_always_equal                        = std::true_type;
+
+    constexpr indirect_pool_allocator() noexcept = default;
+
+    template <class U>
+    constexpr indirect_pool_allocator(const indirect_pool_allocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        if (n == 1)
+            return static_cast<T*>(pool::allocate());
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        if (n == 1)
+            pool::deallocate(p);
+        else
+            std::allocator<T>().deallocate(p, n);
+    }
+
+    template <class U>
+    friend constexpr bool operator==(const indirect_pool_allocator&, const indirect_pool_allocator<U>&) noexcept {
+        return true;
+    }
+
+    template <class U>
+    friend constexpr bool operator!=(const indirect_pool_allocator&, const indirect_pool_allocator<U>&) noexcept {
+        return false;
+    }
+};
+
+} // namespace beman::indirect
+
+#endif // BEMAN_INDIRECT_POOL_ALLOCATOR_HPP
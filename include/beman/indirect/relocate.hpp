@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef BEMAN_INDIRECT_RELOCATE_HPP
+#define BEMAN_INDIRECT_RELOCATE_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace beman::indirect {
+
+// Trivial relocation, after P1144.
+//
+// A type is trivially relocatable when moving an object to new storage and
+// destroying the original can be replaced by copying its bytes and forgetting
+// the original. Trivially copyable types always qualify. Other types opt in by
+// specializing is_trivially_relocatable; indirect, polymorphic and
+// cow_indirect do so when their allocator and pointer type qualify.
+// small_polymorphic does not, as its inline object may point into itself.
+template <class T>
+struct is_trivially_relocatable : std::bool_constant<std::is_trivially_copyable_v<T>> {};
+
+template <class T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+template <class T>
+struct is_trivially_relocatable<std::allocator<T>> : std::true_type {};
+
+template <class T>
+struct is_trivially_relocatable<std::pmr::polymorphic_allocator<T>> : std::true_type {};
+
+// Move *src into the uninitialized storage at dst and end the lifetime of
+// *src. Returns dst.
+template <class T>
+T* relocate_at(T* src, T* dst) noexcept(is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible_v<T>) {
+    static_assert(is_trivially_relocatable_v<T> || std::is_move_constructible_v<T>);
+    if constexpr (is_trivially_relocatable_v<T>) {
+        std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), sizeof(T));
+        return dst;
+    } else {
+        T* result = ::new (static_cast<void*>(dst)) T(std::move(*src));
+        std::destroy_at(src);
+        return result;
+    }
+}
+
+// Relocate [first, last) into the uninitialized, non-overlapping storage
+// starting at d_first. Returns the end of the destination range. For trivially
+// relocatable T this is a single memcpy. Otherwise each element is
+// move-constructed and the sources are destroyed afterwards; if a move
+// constructor throws, the destination objects built so far are destroyed and
+// every source object is still alive.
+template <class T>
+T* uninitialized_relocate(T* first, T* last, T* d_first) noexcept(is_trivially_relocatable_v<T> ||
+                                                                   std::is_nothrow_move_constructible_v<T>) {
+    static_assert(is_trivially_relocatable_v<T> || std::is_move_constructible_v<T>);
+    if constexpr (is_trivially_relocatable_v<T>) {
+        const std::size_t n = static_cast<std::size_t>(last - first);
+        if (n != 0)
+            std::memcpy(static_cast<void*>(d_first), static_cast<const void*>(first), n * sizeof(T));
+        return d_first + n;
+    } else {
+        T* d_last = std::uninitialized_move(first, last, d_first);
+        std::destroy(first, last);
+        return d_last;
+    }
+}
+
+} // namespace beman::indirect
+
+#endif // BEMAN_INDIRECT_RELOCATE_HPP
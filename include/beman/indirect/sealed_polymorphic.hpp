@@ -0,0 +1,423 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef BEMAN_INDIRECT_SEALED_POLYMORPHIC_HPP
+#define BEMAN_INDIRECT_SEALED_POLYMORPHIC_HPP
+
+#include <beman/indirect/detail/config.hpp>
+#include <beman/indirect/polymorphic.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace beman::indirect {
+
+namespace detail {
+
+// Position of U in Us, or sizeof...(Us) if it does not occur.
+template <class U, class... Us>
+constexpr std::size_t sealed_index_of() noexcept {
+    constexpr bool matches[] = {std::is_same_v<U, Us>...};
+    for (std::size_t i = 0; i < sizeof...(Us); ++i) {
+        if (matches[i])
+            return i;
+    }
+    return sizeof...(Us);
+}
+
+template <class... Us>
+constexpr bool sealed_distinct() noexcept {
+    constexpr std::size_t first[] = {sealed_index_of<Us, Us...>()...};
+    for (std::size_t i = 0; i < sizeof...(Us); ++i) {
+        if (first[i] != i)
+            return false;
+    }
+    return true;
+}
+
+// One case of sealed_dispatch. Indices at or past N never occur; they reuse
+// alternative 0 so that every case has a body of the right type.
+template <std::size_t N, std::size_t I, class R, class F>
+R sealed_case(F& f) {
+    if constexpr (I < N)
+        return f(std::integral_constant<std::size_t, I>{});
+    else
+        return sealed_case<N, 0, R>(f);
+}
+
+// Calls f(std::integral_constant<std::size_t, index>{}), for index < N, from a
+// switch over the index, so that compilers emit a jump table and can inline
+// f's body into each case. Sixteen alternatives are handled per level.
+template <std::size_t N, std::size_t Base, class R, class F>
+R sealed_dispatch(std::size_t index, F& f) {
+    switch (index - Base) {
+    case 0:
+        return sealed_case<N, Base + 0, R>(f);
+    case 1:
+        return sealed_case<N, Base + 1, R>(f);
+    case 2:
+        return sealed_case<N, Base + 2, R>(f);
+    case 3:
+        return sealed_case<N, Base + 3, R>(f);
+    case 4:
+        return sealed_case<N, Base + 4, R>(f);
+    case 5:
+        return sealed_case<N, Base + 5, R>(f);
+    case 6:
+        return sealed_case<N, Base + 6, R>(f);
+    case 7:
+        return sealed_case<N, Base + 7, R>(f);
+    case 8:
+        return sealed_case<N, Base + 8, R>(f);
+    case 9:
+        return sealed_case<N, Base + 9, R>(f);
+    case 10:
+        return sealed_case<N, Base + 10, R>(f);
+    case 11:
+        return sealed_case<N, Base + 11, R>(f);
+    case 12:
+        return sealed_case<N, Base + 12, R>(f);
+    case 13:
+        return sealed_case<N, Base + 13, R>(f);
+    case 14:
+        return sealed_case<N, Base + 14, R>(f);
+    case 15:
+        return sealed_case<N, Base + 15, R>(f);
+    default:
+        break;
+    }
+    if constexpr (Base + 16 < N)
+        return sealed_dispatch<N, Base + 16, R>(index, f);
+    else
+        return sealed_case<N, 0, R>(f);
+}
+
+} // namespace detail
+
+// sealed_polymorphic: polymorphic over a closed set of derived types.
+//
+// Has the deep-copy semantics of polymorphic<T> and exposes the owned object
+// as a T, but the object is always one of Us... and lives inside the handle,
+// in storage sized for the largest of them, so nothing is ever allocated. A
+// default-constructed handle holds a value-initialized first alternative, as
+// std::variant does. Moving from a handle leaves it valueless, as with
+// polymorphic.
+//
+// visit(f) calls f with the owned object as its concrete type through a switch
+// over the alternative's index rather than a virtual call. Like
+// small_polymorphic, this type is not usable in constant expressions.
+template <class T, class... Us>
+class sealed_polymorphic {
+    static_assert(std::is_object_v<T>, "T must be an object type");
+    static_assert(!std::is_array_v<T>, "T must not be an array type");
+    static_assert(!std::is_const_v<T> && !std::is_volatile_v<T>, "T must not be cv-qualified");
+    static_assert(sizeof...(Us) > 0, "sealed_polymorphic needs at least one alternative");
+    static_assert((std::is_same_v<detail::remove_cvref_t<Us>, Us> && ...), "alternatives must not be cv-qualified");
+    static_assert((detail::derived_from_v<Us, T> && ...), "every alternative must be T or derived from T");
+    static_assert(detail::sealed_distinct<Us...>(), "alternatives must be distinct");
+    static_assert((std::is_copy_constructible_v<Us> && ...), "alternatives must be copy constructible");
+
+    template <std::size_t I>
+    using alternative = std::tuple_element_t<I, std::tuple<Us...>>;
+
+    template <class U>
+    static constexpr bool is_alternative_v = detail::sealed_index_of<U, Us...>() < sizeof...(Us);
+
+    static constexpr bool nothrow_move = (std::is_nothrow_move_constructible_v<Us> && ...);
+
+  public:
+    using value_type = T;
+
+    static constexpr std::size_t alternatives = sizeof...(Us);
+
+    // index() of a valueless handle.
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    template <class U>
+    static constexpr std::size_t index_of = detail::sealed_index_of<U, Us...>();
+
+    // constructors
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    sealed_polymorphic()
+        requires std::is_default_constructible_v<alternative<0>>
+#else
+    template <class U0 = alternative<0>, std::enable_if_t<std::is_default_constructible_v<U0>, int> = 0>
+    sealed_polymorphic()
+#endif
+    {
+        construct<0>();
+    }
+
+    sealed_polymorphic(const sealed_polymorphic& other) {
+        if (!other.valueless_after_move())
+            other.dispatch([&](auto i) { construct<i>(*other.get<i>()); });
+    }
+
+    sealed_polymorphic(sealed_polymorphic&& other) noexcept(nothrow_move) { take(other); }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U>
+        requires(!std::is_same_v<detail::remove_cvref_t<U>, sealed_polymorphic> &&
+                 is_alternative_v<detail::remove_cvref_t<U>> && std::is_constructible_v<detail::remove_cvref_t<U>, U>)
+#else
+    template <class U,
+              std::enable_if_t<!std::is_same_v<detail::remove_cvref_t<U>, sealed_polymorphic> &&
+                                   is_alternative_v<detail::remove_cvref_t<U>> &&
+                                   std::is_constructible_v<detail::remove_cvref_t<U>, U>,
+                               int> = 0>
+#endif
+    explicit sealed_polymorphic(U&& u) {
+        construct<index_of<detail::remove_cvref_t<U>>>(std::forward<U>(u));
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U, class... Ts>
+        requires(is_alternative_v<U> && std::is_constructible_v<U, Ts...>)
+#else
+    template <class U,
+              class... Ts,
+              std::enable_if_t<is_alternative_v<U> && std::is_constructible_v<U, Ts...>, int> = 0>
+#endif
+    explicit sealed_polymorphic(std::in_place_type_t<U>, Ts&&... ts) {
+        construct<index_of<U>>(std::forward<Ts>(ts)...);
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U, class I, class... Ts>
+        requires(is_alternative_v<U> && std::is_constructible_v<U, std::initializer_list<I>&, Ts...>)
+#else
+    template <class U,
+              class I,
+              class... Ts,
+              std::enable_if_t<is_alternative_v<U> && std::is_constructible_v<U, std::initializer_list<I>&, Ts...>,
+                               int> = 0>
+#endif
+    explicit sealed_polymorphic(std::in_place_type_t<U>, std::initializer_list<I> ilist, Ts&&... ts) {
+        construct<index_of<U>>(ilist, std::forward<Ts>(ts)...);
+    }
+
+    // destructor
+
+    ~sealed_polymorphic() { reset(); }
+
+    // assignment
+
+    // Assigns in place when both handles hold the same alternative and its copy
+    // assignment cannot throw. Otherwise copies other first, so a throwing copy
+    // leaves *this unchanged; a throwing move of that copy into *this leaves
+    // *this valueless.
+    sealed_polymorphic& operator=(const sealed_polymorphic& other) {
+        if (std::addressof(other) == this)
+            return *this;
+        if (other.valueless_after_move()) {
+            reset();
+            return *this;
+        }
+        if (!valueless_after_move() && index_ == other.index_) {
+            bool assigned = other.dispatch([&](auto i) {
+                using U = alternative<i>;
+                if constexpr (std::is_nothrow_copy_assignable_v<U>) {
+                    *get<i>() = *other.get<i>();
+                    return true;
+                } else {
+                    return false;
+                }
+            });
+            if (assigned)
+                return *this;
+        }
+        sealed_polymorphic tmp(other);
+        reset();
+        take(tmp);
+        return *this;
+    }
+
+    sealed_polymorphic& operator=(sealed_polymorphic&& other) noexcept(nothrow_move) {
+        if (std::addressof(other) == this)
+            return *this;
+        reset();
+        take(other);
+        return *this;
+    }
+
+    // Replaces the owned object with a U constructed from ts. The old object
+    // is destroyed first: if constructing U throws, *this is left valueless.
+    // ts must not refer to the current object.
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U, class... Ts>
+        requires(is_alternative_v<U> && std::is_constructible_v<U, Ts...>)
+#else
+    template <class U,
+              class... Ts,
+              std::enable_if_t<is_alternative_v<U> && std::is_constructible_v<U, Ts...>, int> = 0>
+#endif
+    U& emplace(Ts&&... ts) {
+        reset();
+        construct<index_of<U>>(std::forward<Ts>(ts)...);
+        return *get<index_of<U>>();
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U, class I, class... Ts>
+        requires(is_alternative_v<U> && std::is_constructible_v<U, std::initializer_list<I>&, Ts...>)
+#else
+    template <class U,
+              class I,
+              class... Ts,
+              std::enable_if_t<is_alternative_v<U> && std::is_constructible_v<U, std::initializer_list<I>&, Ts...>,
+                               int> = 0>
+#endif
+    U& emplace(std::initializer_list<I> ilist, Ts&&... ts) {
+        reset();
+        construct<index_of<U>>(ilist, std::forward<Ts>(ts)...);
+        return *get<index_of<U>>();
+    }
+
+    // observers
+
+    const T& operator*() const noexcept {
+        assert(!valueless_after_move());
+        return *p_;
+    }
+
+    T& operator*() noexcept {
+        assert(!valueless_after_move());
+        return *p_;
+    }
+
+    const T* operator->() const noexcept {
+        assert(!valueless_after_move());
+        return p_;
+    }
+
+    T* operator->() noexcept {
+        assert(!valueless_after_move());
+        return p_;
+    }
+
+    bool valueless_after_move() const noexcept { return p_ == nullptr; }
+
+    // Position of the owned object's type in Us..., or npos if valueless.
+    std::size_t index() const noexcept { return p_ ? index_ : npos; }
+
+    polymorphic_type_id type_id() const noexcept {
+        static constexpr polymorphic_type_id ids[] = {polymorphic_type_id::of<Us>()...};
+        return p_ ? ids[index_] : polymorphic_type_id();
+    }
+
+    template <class U>
+    bool holds() const noexcept {
+        static_assert(detail::derived_from_v<U, T>, "U must be T or derived from T");
+        return p_ && index_ == index_of<U>;
+    }
+
+    template <class U>
+    U* get_if() noexcept {
+        if constexpr (is_alternative_v<U>)
+            return holds<U>() ? get<index_of<U>>() : nullptr;
+        else
+            return nullptr;
+    }
+
+    template <class U>
+    const U* get_if() const noexcept {
+        return const_cast<sealed_polymorphic&>(*this).template get_if<U>();
+    }
+
+    // Returns f(u), where u is the owned object as its concrete type U. f must
+    // return the same type for every alternative. *this must not be valueless.
+    template <class F>
+    decltype(auto) visit(F&& f) {
+        return visit_impl<sealed_polymorphic&>(*this, f);
+    }
+
+    template <class F>
+    decltype(auto) visit(F&& f) const {
+        return visit_impl<const sealed_polymorphic&>(*this, f);
+    }
+
+    // swap
+
+    void swap(sealed_polymorphic& other) noexcept(nothrow_move) {
+        if (std::addressof(other) == this)
+            return;
+        sealed_polymorphic tmp(std::move(other));
+        other.take(*this);
+        take(tmp);
+    }
+
+    friend void swap(sealed_polymorphic& lhs, sealed_polymorphic& rhs) noexcept(noexcept(lhs.swap(rhs))) {
+        lhs.swap(rhs);
+    }
+
+  private:
+    template <std::size_t I>
+    alternative<I>* get() noexcept {
+        return std::launder(reinterpret_cast<alternative<I>*>(buf_));
+    }
+
+    template <std::size_t I>
+    const alternative<I>* get() const noexcept {
+        return std::launder(reinterpret_cast<const alternative<I>*>(buf_));
+    }
+
+    // Calls f(std::integral_constant<std::size_t, index_>{}). *this must not be
+    // valueless.
+    template <class F>
+    decltype(auto) dispatch(F&& f) const {
+        using R = decltype(f(std::integral_constant<std::size_t, 0>{}));
+        return detail::sealed_dispatch<alternatives, 0, R>(index_, f);
+    }
+
+    template <class Self, class F>
+    static decltype(auto) visit_impl(Self self, F& f) {
+        using R = decltype(std::forward<F>(f)(*self.template get<0>()));
+        static_assert((std::is_same_v<R, decltype(std::forward<F>(f)(*self.template get<index_of<Us>>()))> && ...),
+                      "visit requires the same result type for every alternative");
+        assert(!self.valueless_after_move());
+        return self.dispatch([&](auto i) -> R { return std::forward<F>(f)(*self.template get<i>()); });
+    }
+
+    template <std::size_t I, class... Args>
+    void construct(Args&&... args) {
+        alternative<I>* u = detail::construct_at_impl(get<I>(), std::forward<Args>(args)...);
+        p_                = u;
+        index_            = static_cast<index_type>(I);
+    }
+
+    // Move-construct other's object into *this, which must be valueless, and
+    // leave other valueless.
+    void take(sealed_polymorphic& other) noexcept(nothrow_move) {
+        if (other.valueless_after_move())
+            return;
+        other.dispatch([&](auto i) { construct<i>(std::move(*other.get<i>())); });
+        other.reset();
+    }
+
+    void reset() noexcept {
+        if (valueless_after_move())
+            return;
+        dispatch([&](auto i) { std::destroy_at(get<i>()); });
+        p_ = nullptr;
+    }
+
+    using index_type = std::conditional_t<(sizeof...(Us) <= 255), unsigned char, std::size_t>;
+
+    // p_ points at the T subobject of the alternative in buf_, so that
+    // dereferencing needs no dispatch; it is null exactly when the handle is
+    // valueless.
+    T*         p_     = nullptr;
+    index_type index_ = 0;
+    alignas(Us...) unsigned char buf_[std::max({sizeof(Us)...})];
+};
+
+} // namespace beman::indirect
+
+#endif // BEMAN_INDIRECT_SEALED_POLYMORPHIC_HPP
@@ -0,0 +1,447 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#ifndef BEMAN_INDIRECT_SMALL_POLYMORPHIC_HPP
+#define BEMAN_INDIRECT_SMALL_POLYMORPHIC_HPP
+
+#include <beman/indirect/detail/config.hpp>
+#include <beman/indirect/polymorphic.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+namespace beman::indirect {
+
+namespace detail {
+
+// True when a U can live in an InlineSize-byte buffer of a small_polymorphic.
+// U must be nothrow move constructible so that moving and swapping handles
+// stay noexcept even though they move the object itself.
+template <class U, std::size_t InlineSize>
+inline constexpr bool fits_inline_v = sizeof(U) <= InlineSize && alignof(U) <= alignof(std::max_align_t) &&
+                                      std::is_nothrow_move_constructible_v<U>;
+
+// Handle-local dispatch table for an object stored in a small_polymorphic's
+// buffer, the counterpart of control_block_ops for heap objects.
+template <class T, class Allocator>
+struct inline_ops {
+    // Construct a copy of *src at dst, using alloc for uses-allocator construction.
+    T* (*copy)(const void* src, void* dst, const Allocator& alloc);
+    // Construct at dst from std::move(*src), using alloc for uses-allocator construction.
+    T* (*move)(void* src, void* dst, const Allocator& alloc);
+    // Move *src to dst and destroy *src. src and dst share an allocator.
+    T* (*relocate)(void* src, void* dst, Allocator& alloc) noexcept;
+    void (*destroy)(void* obj, Allocator& alloc) noexcept;
+};
+
+template <class T, class U, class Allocator>
+struct inline_model {
+    using alloc_traits = std::allocator_traits<Allocator>;
+
+    template <class... Args>
+    static T* construct(void* dst, const Allocator& alloc, Args&&... args) {
+        Allocator a(alloc);
+        U*        u = static_cast<U*>(dst);
+        alloc_traits::construct(a, u, std::forward<Args>(args)...);
+        return u;
+    }
+
+    static T* copy(const void* src, void* dst, const Allocator& alloc) {
+        return construct(dst, alloc, *static_cast<const U*>(src));
+    }
+
+    static T* move(void* src, void* dst, const Allocator& alloc) {
+        return construct(dst, alloc, std::move(*static_cast<U*>(src)));
+    }
+
+    static T* relocate(void* src, void* dst, Allocator& alloc) noexcept {
+        U* s = static_cast<U*>(src);
+        U* d = construct_at_impl(static_cast<U*>(dst), std::move(*s));
+        alloc_traits::destroy(alloc, s);
+        return d;
+    }
+
+    static void destroy(void* obj, Allocator& alloc) noexcept { alloc_traits::destroy(alloc, static_cast<U*>(obj)); }
+
+    static constexpr inline_ops<T, Allocator> ops = {&copy, &move, &relocate, &destroy};
+};
+
+} // namespace detail
+
+// small_polymorphic: polymorphic with a small-buffer optimization.
+//
+// Has the interface and deep-copy semantics of polymorphic<T, Allocator>, but
+// constructs the owned U inside the handle when detail::fits_inline_v<U,
+// InlineSize> holds. Other types fall back to a heap-allocated
+// direct_control_block, exactly as polymorphic does. Inline storage relies on
+// placement into a byte buffer, so unlike polymorphic this type is not usable
+// in constant expressions.
+template <class T, std::size_t InlineSize, class Allocator = std::allocator<T>>
+class small_polymorphic {
+    static_assert(std::is_object_v<T>, "T must be an object type");
+    static_assert(!std::is_array_v<T>, "T must not be an array type");
+    static_assert(!std::is_const_v<T> && !std::is_volatile_v<T>, "T must not be cv-qualified");
+    static_assert(std::is_same_v<T, typename std::allocator_traits<Allocator>::value_type>,
+                  "Allocator::value_type must be T");
+    static_assert(InlineSize > 0, "InlineSize must be non-zero; use polymorphic for heap-only storage");
+
+    using alloc_traits = std::allocator_traits<Allocator>;
+    using cb_type      = detail::control_block<T, Allocator>;
+    using ops_type     = detail::inline_ops<T, Allocator>;
+
+  public:
+    using value_type     = T;
+    using allocator_type = Allocator;
+    using pointer        = typename alloc_traits::pointer;
+    using const_pointer  = typename alloc_traits::const_pointer;
+
+    static constexpr std::size_t inline_size = InlineSize;
+
+    // constructors
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    explicit small_polymorphic()
+        requires std::is_default_constructible_v<Allocator>
+#else
+    template <class Alloc_ = Allocator, std::enable_if_t<std::is_default_constructible_v<Alloc_>, int> = 0>
+    explicit small_polymorphic()
+#endif
+    {
+        static_assert(std::is_default_constructible_v<T>);
+        static_assert(std::is_copy_constructible_v<T>);
+        emplace_value<T>();
+    }
+
+    explicit small_polymorphic(std::allocator_arg_t, const Allocator& a) : alloc_(a) {
+        static_assert(std::is_default_constructible_v<T>);
+        static_assert(std::is_copy_constructible_v<T>);
+        emplace_value<T>();
+    }
+
+    small_polymorphic(const small_polymorphic& other)
+        : alloc_(alloc_traits::select_on_container_copy_construction(other.alloc_)) {
+        copy_from(other);
+    }
+
+    small_polymorphic(std::allocator_arg_t, const Allocator& a, const small_polymorphic& other) : alloc_(a) {
+        copy_from(other);
+    }
+
+    small_polymorphic(small_polymorphic&& other) noexcept : alloc_(std::move(other.alloc_)) { steal(other); }
+
+    small_polymorphic(std::allocator_arg_t,
+                      const Allocator&    a,
+                      small_polymorphic&& other) noexcept(alloc_traits::is_always_equal::value)
+        : alloc_(a) {
+        if (other.valueless_after_move()) {
+            // *this is valueless
+        } else if constexpr (alloc_traits::is_always_equal::value) {
+            steal(other);
+        } else {
+            if (alloc_ == other.alloc_) {
+                steal(other);
+            } else {
+                if (other.ops_) {
+                    p_   = other.ops_->move(other.buf_, buf_, alloc_);
+                    ops_ = other.ops_;
+                } else {
+                    cb_ = other.cb_->move_clone(alloc_, p_);
+                }
+                other.reset();
+            }
+        }
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U = T>
+        requires(!std::is_same_v<detail::remove_cvref_t<U>, small_polymorphic> &&
+                 detail::derived_from_v<detail::remove_cvref_t<U>, T> &&
+                 std::is_constructible_v<detail::remove_cvref_t<U>, U> &&
+                 std::is_copy_constructible_v<detail::remove_cvref_t<U>> &&
+                 !detail::is_in_place_type_v<detail::remove_cvref_t<U>> && std::is_default_constructible_v<Allocator>)
+#else
+    template <class U               = T,
+              std::enable_if_t<!std::is_same_v<detail::remove_cvref_t<U>, small_polymorphic> &&
+                                   detail::derived_from_v<detail::remove_cvref_t<U>, T> &&
+                                   std::is_constructible_v<detail::remove_cvref_t<U>, U> &&
+                                   std::is_copy_constructible_v<detail::remove_cvref_t<U>> &&
+                                   !detail::is_in_place_type_v<detail::remove_cvref_t<U>> &&
+                                   std::is_default_constructible_v<Allocator>,
+                               int> = 0>
+#endif
+    explicit small_polymorphic(U&& u) {
+        emplace_value<detail::remove_cvref_t<U>>(std::forward<U>(u));
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U = T>
+        requires(!std::is_same_v<detail::remove_cvref_t<U>, small_polymorphic> &&
+                 detail::derived_from_v<detail::remove_cvref_t<U>, T> &&
+                 std::is_constructible_v<detail::remove_cvref_t<U>, U> &&
+                 std::is_copy_constructible_v<detail::remove_cvref_t<U>> &&
+                 !detail::is_in_place_type_v<detail::remove_cvref_t<U>>)
+#else
+    template <class U               = T,
+              std::enable_if_t<!std::is_same_v<detail::remove_cvref_t<U>, small_polymorphic> &&
+                                   detail::derived_from_v<detail::remove_cvref_t<U>, T> &&
+                                   std::is_constructible_v<detail::remove_cvref_t<U>, U> &&
+                                   std::is_copy_constructible_v<detail::remove_cvref_t<U>> &&
+                                   !detail::is_in_place_type_v<detail::remove_cvref_t<U>>,
+                               int> = 0>
+#endif
+    explicit small_polymorphic(std::allocator_arg_t, const Allocator& a, U&& u) : alloc_(a) {
+        emplace_value<detail::remove_cvref_t<U>>(std::forward<U>(u));
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U, class... Ts>
+        requires(std::is_same_v<detail::remove_cvref_t<U>, U> && detail::derived_from_v<U, T> &&
+                 std::is_constructible_v<U, Ts...> && std::is_copy_constructible_v<U> &&
+                 std::is_default_constructible_v<Allocator>)
+#else
+    template <class U,
+              class... Ts,
+              std::enable_if_t<std::is_same_v<detail::remove_cvref_t<U>, U> && detail::derived_from_v<U, T> &&
+                                   std::is_constructible_v<U, Ts...> && std::is_copy_constructible_v<U> &&
+                                   std::is_default_constructible_v<Allocator>,
+                               int> = 0>
+#endif
+    explicit small_polymorphic(std::in_place_type_t<U>, Ts&&... ts) {
+        emplace_value<U>(std::forward<Ts>(ts)...);
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U, class... Ts>
+        requires(std::is_same_v<detail::remove_cvref_t<U>, U> && detail::derived_from_v<U, T> &&
+                 std::is_constructible_v<U, Ts...> && std::is_copy_constructible_v<U>)
+#else
+    template <class U,
+              class... Ts,
+              std::enable_if_t<std::is_same_v<detail::remove_cvref_t<U>, U> && detail::derived_from_v<U, T> &&
+                                   std::is_constructible_v<U, Ts...> && std::is_copy_constructible_v<U>,
+                               int> = 0>
+#endif
+    explicit small_polymorphic(std::allocator_arg_t, const Allocator& a, std::in_place_type_t<U>, Ts&&... ts)
+        : alloc_(a) {
+        emplace_value<U>(std::forward<Ts>(ts)...);
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U, class I, class... Us>
+        requires(std::is_same_v<detail::remove_cvref_t<U>, U> && detail::derived_from_v<U, T> &&
+                 std::is_constructible_v<U, std::initializer_list<I>&, Us...> && std::is_copy_constructible_v<U> &&
+                 std::is_default_constructible_v<Allocator>)
+#else
+    template <class U,
+              class I,
+              class... Us,
+              std::enable_if_t<std::is_same_v<detail::remove_cvref_t<U>, U> && detail::derived_from_v<U, T> &&
+                                   std::is_constructible_v<U, std::initializer_list<I>&, Us...> &&
+                                   std::is_copy_constructible_v<U> && std::is_default_constructible_v<Allocator>,
+                               int> = 0>
+#endif
+    explicit small_polymorphic(std::in_place_type_t<U>, std::initializer_list<I> ilist, Us&&... us) {
+        emplace_value<U>(ilist, std::forward<Us>(us)...);
+    }
+
+#if BEMAN_INDIRECT_USE_CONCEPTS
+    template <class U, class I, class... Us>
+        requires(std::is_same_v<detail::remove_cvref_t<U>, U> && detail::derived_from_v<U, T> &&
+                 std::is_constructible_v<U, std::initializer_list<I>&, Us...> && std::is_copy_constructible_v<U>)
+#else
+    template <class U,
+              class I,
+              class... Us,
+              std::enable_if_t<std::is_same_v<detail::remove_cvref_t<U>, U> && detail::derived_from_v<U, T> &&
+                                   std::is_constructible_v<U, std::initializer_list<I>&, Us...> &&
+                                   std::is_copy_constructible_v<U>,
+                               int> = 0>
+#endif
+    explicit small_polymorphic(
+        std::allocator_arg_t, const Allocator& a, std::in_place_type_t<U>, std::initializer_list<I> ilist, Us&&... us)
+        : alloc_(a) {
+        emplace_value<U>(ilist, std::forward<Us>(us)...);
+    }
+
+    // destructor
+
+    ~small_polymorphic() {
+        static_assert(detail::is_complete_v<T>);
+        reset();
+    }
+
+    // assignment
+
+    small_polymorphic& operator=(const small_polymorphic& other) {
+        static_assert(detail::is_complete_v<T>);
+        if (std::addressof(other) == this)
+            return *this;
+
+        constexpr bool pocca = alloc_traits::propagate_on_container_copy_assignment::value;
+
+        // Copy first for the strong exception guarantee; handing the copy over is noexcept.
+        small_polymorphic tmp(std::allocator_arg, pocca ? other.alloc_ : alloc_, other);
+        reset();
+        if constexpr (pocca) {
+            alloc_ = other.alloc_;
+        }
+        steal(tmp);
+        return *this;
+    }
+
+    small_polymorphic&
+    operator=(small_polymorphic&& other) noexcept(alloc_traits::propagate_on_container_move_assignment::value ||
+                                                  alloc_traits::is_always_equal::value) {
+        if (std::addressof(other) == this)
+            return *this;
+
+        constexpr bool pocma = alloc_traits::propagate_on_container_move_assignment::value;
+
+        if (other.valueless_after_move()) {
+            reset();
+        } else if (pocma || alloc_ == other.alloc_) {
+            reset();
+            if constexpr (pocma) {
+                alloc_ = other.alloc_;
+            }
+            steal(other);
+        } else {
+            small_polymorphic tmp(std::allocator_arg, alloc_, std::move(other));
+            reset();
+            steal(tmp);
+        }
+
+        if constexpr (pocma) {
+            alloc_ = other.alloc_;
+        }
+        return *this;
+    }
+
+    // observers
+
+    const T& operator*() const noexcept {
+        assert(!valueless_after_move());
+        return *p_;
+    }
+
+    T& operator*() noexcept {
+        assert(!valueless_after_move());
+        return *p_;
+    }
+
+    const_pointer operator->() const noexcept {
+        assert(!valueless_after_move());
+        return std::pointer_traits<const_pointer>::pointer_to(*p_);
+    }
+
+    pointer operator->() noexcept {
+        assert(!valueless_after_move());
+        return std::pointer_traits<pointer>::pointer_to(*p_);
+    }
+
+    bool valueless_after_move() const noexcept { return p_ == nullptr; }
+
+    // True when the owned object lives inside the handle rather than on the heap.
+    bool is_inline() const noexcept { return ops_ != nullptr; }
+
+    allocator_type get_allocator() const noexcept { return alloc_; }
+
+    // swap
+
+    void swap(small_polymorphic& other) noexcept(alloc_traits::propagate_on_container_swap::value ||
+                                                 alloc_traits::is_always_equal::value) {
+        // Precondition: allocators must be equal when they don't propagate on swap.
+        assert(alloc_traits::propagate_on_container_swap::value || alloc_ == other.alloc_);
+        if (std::addressof(other) == this)
+            return;
+        // Inline objects cannot simply exchange pointers, so go through a temporary.
+        small_polymorphic tmp(std::move(other));
+        if constexpr (alloc_traits::propagate_on_container_swap::value) {
+            using std::swap;
+            swap(alloc_, other.alloc_);
+        }
+        other.steal(*this);
+        steal(tmp);
+    }
+
+    friend void swap(small_polymorphic& lhs, small_polymorphic& rhs) noexcept(noexcept(lhs.swap(rhs))) {
+        lhs.swap(rhs);
+    }
+
+  private:
+    template <class U, class... Args>
+    void emplace_value(Args&&... args) {
+        if constexpr (detail::fits_inline_v<U, InlineSize>) {
+            using model = detail::inline_model<T, U, Allocator>;
+
+            p_   = model::construct(buf_, alloc_, std::forward<Args>(args)...);
+            ops_ = &model::ops;
+        } else {
+            cb_ = detail::make_control_block<T, U>(alloc_, p_, std::forward<Args>(args)...);
+        }
+    }
+
+    void copy_from(const small_polymorphic& other) {
+        if (other.valueless_after_move())
+            return;
+        if (other.ops_) {
+            p_   = other.ops_->copy(other.buf_, buf_, alloc_);
+            ops_ = other.ops_;
+        } else {
+            cb_ = other.cb_->clone(alloc_, p_);
+        }
+    }
+
+    // Take over other's object, leaving other valueless. *this must be valueless
+    // and its allocator must be able to destroy what other owns.
+    void steal(small_polymorphic& other) noexcept {
+        if (other.valueless_after_move())
+            return;
+        if (other.ops_) {
+            p_         = other.ops_->relocate(other.buf_, buf_, alloc_);
+            ops_       = other.ops_;
+            other.ops_ = nullptr;
+        } else {
+            cb_ = other.cb_;
+            p_  = other.p_;
+        }
+        other.p_ = nullptr;
+    }
+
+    void reset() noexcept {
+        if (valueless_after_move())
+            return;
+        if (ops_) {
+            ops_->destroy(buf_, alloc_);
+            ops_ = nullptr;
+        } else {
+            cb_->destroy(alloc_);
+        }
+        p_ = nullptr;
+    }
+
+    // The object is inline when ops_ is set and on the heap (owned by cb_)
+    // otherwise; p_ is null exactly when the handle is valueless.
+    BEMAN_INDIRECT_NO_UNIQUE_ADDRESS Allocator alloc_ = Allocator();
+    const ops_type*                            ops_   = nullptr;
+    T*                                         p_     = nullptr;
+    union {
+        cb_type* cb_;
+        alignas(std::max_align_t) unsigned char buf_[InlineSize];
+    };
+};
+
+} // namespace beman::indirect
+
+namespace beman::indirect::pmr {
+
+template <class T, std::size_t InlineSize>
+using small_polymorphic = beman::indirect::small_polymorphic<T, InlineSize, std::pmr::polymorphic_allocator<T>>;
+
+} // namespace beman::indirect::pmr
+
+#endif // BEMAN_INDIRECT_SMALL_POLYMORPHIC_HPP
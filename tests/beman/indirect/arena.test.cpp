@@ -0,0 +1,203 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <beman/indirect/arena.hpp>
+
+#include <beman/indirect/indirect.hpp>
+#include <beman/indirect/polymorphic.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace {
+
+using beman::indirect::arena_allocator;
+using beman::indirect::indirect;
+using beman::indirect::is_arena_allocator_v;
+using beman::indirect::is_arena_discardable_v;
+using beman::indirect::polymorphic;
+
+// Counts destructor calls; not arena-discardable.
+struct Tracked {
+    static inline int destroyed = 0;
+    int               value;
+    explicit Tracked(int v = 0) : value(v) {}
+    Tracked(const Tracked&) = default;
+    ~Tracked() { ++destroyed; }
+};
+
+// Binary tree node whose storage lives entirely in the arena.
+struct Node {
+    static inline int destroyed = 0;
+    using child                 = std::optional<indirect<Node, arena_allocator<Node>>>;
+
+    int   value;
+    child left;
+    child right;
+
+    explicit Node(int v) : value(v) {}
+    ~Node() { ++destroyed; }
+};
+
+struct Shape {
+    virtual ~Shape()               = default;
+    virtual int sides() const      = 0;
+    Shape()                        = default;
+    Shape(const Shape&)            = default;
+    Shape& operator=(const Shape&) = default;
+};
+
+struct Square : Shape {
+    int sides() const override { return 4; }
+};
+
+struct TrackedShape : Shape {
+    static inline int destroyed = 0;
+    int               sides() const override { return 0; }
+    ~TrackedShape() override { ++destroyed; }
+};
+
+} // namespace
+
+// Node and Shape hold nothing outside the arena; specializing for Shape
+// vouches for every type derived from it.
+template <>
+struct beman::indirect::is_arena_discardable<Node> : std::true_type {};
+
+template <>
+struct beman::indirect::is_arena_discardable<Shape> : std::true_type {};
+
+namespace {
+
+indirect<Node, arena_allocator<Node>> build(arena_allocator<Node> alloc, int depth, int& next) {
+    indirect<Node, arena_allocator<Node>> node(std::allocator_arg, alloc, next++);
+    if (depth > 0) {
+        node->left.emplace(build(alloc, depth - 1, next));
+        node->right.emplace(build(alloc, depth - 1, next));
+    }
+    return node;
+}
+
+int sum(const Node& n) {
+    return n.value + (n.left ? sum(**n.left) : 0) + (n.right ? sum(**n.right) : 0);
+}
+
+// --- Traits ---
+
+TEST(ArenaTest, Traits) {
+    static_assert(is_arena_allocator_v<arena_allocator<int>>);
+    static_assert(!is_arena_allocator_v<std::allocator<int>>);
+    static_assert(!is_arena_allocator_v<std::pmr::polymorphic_allocator<int>>);
+    static_assert(is_arena_discardable_v<int>);
+    static_assert(!is_arena_discardable_v<std::string>);
+    static_assert(is_arena_discardable_v<indirect<int, arena_allocator<int>>>);
+    static_assert(!is_arena_discardable_v<indirect<int>>);
+    static_assert(!is_arena_discardable_v<indirect<Tracked, arena_allocator<Tracked>>>);
+    static_assert(is_arena_discardable_v<polymorphic<Shape, arena_allocator<Shape>>>);
+}
+
+// --- arena_allocator ---
+
+TEST(ArenaTest, AllocatesFromResource) {
+    alignas(std::max_align_t) unsigned char buffer[256];
+    std::pmr::monotonic_buffer_resource     arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+
+    indirect<int, arena_allocator<int>> a(std::allocator_arg, &arena, 42);
+    const auto*                         p = reinterpret_cast<const unsigned char*>(&*a);
+    EXPECT_GE(p, buffer);
+    EXPECT_LT(p, buffer + sizeof(buffer));
+    EXPECT_EQ(*a, 42);
+}
+
+TEST(ArenaTest, EqualityComparesResources) {
+    std::pmr::monotonic_buffer_resource r1;
+    std::pmr::monotonic_buffer_resource r2;
+    arena_allocator<int>                a1(&r1);
+    arena_allocator<long>               a2(a1);
+    EXPECT_TRUE(a1 == a2);
+    EXPECT_FALSE(a1 != a2);
+    EXPECT_TRUE(a1 != arena_allocator<int>(&r2));
+}
+
+// --- indirect ---
+
+TEST(ArenaTest, IndirectSkipsDestructorOfDiscardableType) {
+    std::pmr::monotonic_buffer_resource arena;
+    Node::destroyed = 0;
+    {
+        indirect<Node, arena_allocator<Node>> n(std::allocator_arg, &arena, 1);
+        indirect<Node, arena_allocator<Node>> m(std::allocator_arg, &arena, 2);
+        n = std::move(m);
+        EXPECT_EQ(n->value, 2);
+    }
+    EXPECT_EQ(Node::destroyed, 0);
+}
+
+TEST(ArenaTest, IndirectDestroysNonDiscardableType) {
+    std::pmr::monotonic_buffer_resource arena;
+    Tracked::destroyed = 0;
+    {
+        indirect<Tracked, arena_allocator<Tracked>> t(std::allocator_arg, &arena, 1);
+        t.emplace(2);
+        EXPECT_EQ(Tracked::destroyed, 1);
+    }
+    EXPECT_EQ(Tracked::destroyed, 2);
+}
+
+TEST(ArenaTest, TreeReleasedWithArena) {
+    std::pmr::monotonic_buffer_resource arena;
+    Node::destroyed = 0;
+
+    int  next = 0;
+    auto root = build(&arena, 8, next);
+    EXPECT_EQ(sum(*root), next * (next - 1) / 2);
+
+    auto copy = root;
+    EXPECT_EQ(sum(*copy), sum(*root));
+
+    // Release every node at once; the handles must not touch the freed memory
+    // when they go out of scope.
+    arena.release();
+    EXPECT_EQ(Node::destroyed, 0);
+}
+
+// --- polymorphic ---
+
+TEST(ArenaTest, PolymorphicSkipsDestructorOfDiscardableBase) {
+    std::pmr::monotonic_buffer_resource arena;
+    TrackedShape::destroyed = 0;
+    {
+        polymorphic<Shape, arena_allocator<Shape>> s(std::allocator_arg, &arena, std::in_place_type<TrackedShape>);
+        polymorphic<Shape, arena_allocator<Shape>> t(s);
+        t.emplace<Square>();
+        EXPECT_EQ(t->sides(), 4);
+        arena.release();
+    }
+    EXPECT_EQ(TrackedShape::destroyed, 0);
+}
+
+TEST(ArenaTest, PolymorphicDestroysNonDiscardableDerived) {
+    struct Base {
+        virtual ~Base() = default;
+    };
+    struct Derived : Base {
+        Tracked t;
+    };
+
+    std::pmr::monotonic_buffer_resource arena;
+    Tracked::destroyed = 0;
+    {
+        polymorphic<Base, arena_allocator<Base>> p(std::allocator_arg, &arena, std::in_place_type<Derived>);
+        p.emplace<Derived>();
+        EXPECT_EQ(Tracked::destroyed, 1);
+    }
+    EXPECT_EQ(Tracked::destroyed, 2);
+}
+
+} // namespace
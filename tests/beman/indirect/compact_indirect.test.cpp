@@ -0,0 +1,200 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <beman/indirect/compact_indirect.hpp>
+
+#include <beman/indirect/counting_allocator.hpp>
+#include <beman/indirect/indirect.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using beman::indirect::counting_resource;
+using beman::indirect::pmr::compact_indirect;
+
+static_assert(sizeof(compact_indirect<int>) == sizeof(void*));
+static_assert(sizeof(beman::indirect::pmr::indirect<int>) == 2 * sizeof(void*));
+static_assert(beman::indirect::is_trivially_relocatable_v<compact_indirect<std::pmr::string>>);
+
+// --- Construction ---
+
+TEST(CompactIndirectTest, DefaultResource) {
+    compact_indirect<int> a;
+    EXPECT_EQ(*a, 0);
+    EXPECT_EQ(a.get_allocator().resource(), std::pmr::get_default_resource());
+
+    compact_indirect<int> b(42);
+    EXPECT_EQ(*b, 42);
+}
+
+TEST(CompactIndirectTest, AllocatesFromResource) {
+    counting_resource<> resource;
+    {
+        compact_indirect<int> a(std::allocator_arg, &resource, 42);
+        EXPECT_EQ(*a, 42);
+        EXPECT_EQ(a.get_allocator().resource(), &resource);
+        EXPECT_EQ(resource.stats().allocations(), 1u);
+        // The resource pointer is stored in front of the value.
+        EXPECT_GE(resource.stats().bytes_live(), sizeof(void*) + sizeof(int));
+    }
+    EXPECT_EQ(resource.stats().deallocations(), 1u);
+    EXPECT_EQ(resource.stats().bytes_live(), 0u);
+}
+
+TEST(CompactIndirectTest, InPlace) {
+    counting_resource<>                resource;
+    compact_indirect<std::vector<int>> a(std::in_place, 3u, 7);
+    EXPECT_EQ(a->size(), 3u);
+
+    compact_indirect<std::vector<int>> b(std::allocator_arg, &resource, std::in_place, {1, 2, 3});
+    EXPECT_EQ((*b)[2], 3);
+    EXPECT_EQ(b.get_allocator().resource(), &resource);
+}
+
+TEST(CompactIndirectTest, UsesAllocatorConstruction) {
+    counting_resource<>                resource;
+    compact_indirect<std::pmr::string> s(std::allocator_arg, &resource, "a string too long for the small buffer");
+    EXPECT_EQ(s->get_allocator().resource(), &resource);
+    EXPECT_EQ(resource.stats().allocations(), 2u);
+}
+
+TEST(CompactIndirectTest, OverAlignedValue) {
+    struct alignas(64) Wide {
+        int v = 0;
+    };
+    counting_resource<>    resource;
+    compact_indirect<Wide> a(std::allocator_arg, &resource);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(a.operator->()) % 64, 0u);
+}
+
+// --- Copy and move ---
+
+TEST(CompactIndirectTest, CopyUsesDefaultResource) {
+    counting_resource<>   resource;
+    compact_indirect<int> a(std::allocator_arg, &resource, 1);
+
+    compact_indirect<int> b(a);
+    EXPECT_EQ(*b, 1);
+    EXPECT_EQ(b.get_allocator().resource(), std::pmr::get_default_resource());
+
+    compact_indirect<int> c(std::allocator_arg, &resource, a);
+    EXPECT_EQ(*c, 1);
+    EXPECT_EQ(c.get_allocator().resource(), &resource);
+    EXPECT_EQ(resource.stats().allocations(), 2u);
+}
+
+TEST(CompactIndirectTest, MovedFromKeepsResource) {
+    counting_resource<>   resource;
+    compact_indirect<int> a(std::allocator_arg, &resource, 1);
+    compact_indirect<int> b(std::move(a));
+    EXPECT_TRUE(a.valueless_after_move());
+    EXPECT_EQ(a.get_allocator().resource(), &resource);
+    EXPECT_EQ(b.get_allocator().resource(), &resource);
+    EXPECT_EQ(resource.stats().allocations(), 1u);
+
+    // A valueless handle allocates from its resource again.
+    a = 5;
+    EXPECT_EQ(*a, 5);
+    EXPECT_EQ(resource.stats().allocations(), 2u);
+}
+
+TEST(CompactIndirectTest, AllocatorMoveBetweenResources) {
+    counting_resource<>   r1;
+    counting_resource<>   r2;
+    compact_indirect<int> a(std::allocator_arg, &r1, 1);
+
+    compact_indirect<int> b(std::allocator_arg, &r2, std::move(a));
+    EXPECT_EQ(*b, 1);
+    EXPECT_EQ(b.get_allocator().resource(), &r2);
+    EXPECT_TRUE(a.valueless_after_move());
+    EXPECT_EQ(a.get_allocator().resource(), &r1);
+    EXPECT_EQ(r1.stats().bytes_live(), 0u);
+
+    compact_indirect<int> c(std::allocator_arg, &r2, std::move(b));
+    EXPECT_EQ(*c, 1);
+    EXPECT_EQ(r2.stats().allocations(), 1u);
+}
+
+TEST(CompactIndirectTest, Assignment) {
+    counting_resource<>   r1;
+    counting_resource<>   r2;
+    compact_indirect<int> a(std::allocator_arg, &r1, 1);
+    compact_indirect<int> b(std::allocator_arg, &r2, 2);
+
+    // Copy assignment reuses the value and keeps the target's resource.
+    a = b;
+    EXPECT_EQ(*a, 2);
+    EXPECT_EQ(a.get_allocator().resource(), &r1);
+    EXPECT_EQ(r1.stats().allocations(), 1u);
+
+    // Move assignment between different resources moves the value across.
+    b = 3;
+    a = std::move(b);
+    EXPECT_EQ(*a, 3);
+    EXPECT_TRUE(b.valueless_after_move());
+    EXPECT_EQ(a.get_allocator().resource(), &r1);
+    EXPECT_EQ(r2.stats().bytes_live(), 0u);
+
+    // With the same resource it takes over the block.
+    compact_indirect<int> c(std::allocator_arg, &r1, 4);
+    a = std::move(c);
+    EXPECT_EQ(*a, 4);
+    EXPECT_EQ(r1.stats().allocations(), 3u);
+
+    // Assigning a valueless handle makes the target valueless.
+    a = std::move(c);
+    EXPECT_TRUE(a.valueless_after_move());
+    EXPECT_EQ(r1.stats().bytes_live(), 0u);
+}
+
+TEST(CompactIndirectTest, Swap) {
+    counting_resource<>   resource;
+    compact_indirect<int> a(std::allocator_arg, &resource, 1);
+    compact_indirect<int> b(std::allocator_arg, &resource, 2);
+    swap(a, b);
+    EXPECT_EQ(*a, 2);
+    EXPECT_EQ(*b, 1);
+
+    compact_indirect<int> c(std::move(b));
+    a.swap(b);
+    EXPECT_TRUE(a.valueless_after_move());
+    EXPECT_EQ(*b, 2);
+    EXPECT_EQ(a.get_allocator().resource(), &resource);
+}
+
+// --- Comparison and hashing ---
+
+TEST(CompactIndirectTest, Comparison) {
+    compact_indirect<int> a(1);
+    compact_indirect<int> b(2);
+    compact_indirect<int> c(1);
+    EXPECT_TRUE(a == c);
+    EXPECT_TRUE(a != b);
+    EXPECT_TRUE(a < b);
+    EXPECT_TRUE(b >= a);
+    EXPECT_TRUE(a == 1);
+    EXPECT_TRUE(a < 2);
+
+    compact_indirect<int> d(std::move(c));
+    EXPECT_TRUE(c < a);
+    EXPECT_FALSE(c == 1);
+}
+
+TEST(CompactIndirectTest, Hash) {
+    compact_indirect<int> a(7);
+    EXPECT_EQ(std::hash<compact_indirect<int>>{}(a), std::hash<int>{}(7));
+
+    std::unordered_set<compact_indirect<std::string>> set;
+    set.insert(compact_indirect<std::string>("x"));
+    EXPECT_EQ(set.count(compact_indirect<std::string>("x")), 1u);
+}
+
+} // namespace
@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <beman/indirect/compact_polymorphic.hpp>
+
+#include <beman/indirect/counting_allocator.hpp>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+namespace {
+
+using beman::indirect::counting_resource;
+using beman::indirect::pmr::compact_polymorphic;
+
+struct Base {
+    virtual ~Base()              = default;
+    virtual int value() const    = 0;
+    Base()                       = default;
+    Base(const Base&)            = default;
+    Base& operator=(const Base&) = default;
+};
+
+struct Derived : Base {
+    int v;
+    explicit Derived(int x) : v(x) {}
+    int value() const override { return v; }
+};
+
+// Base is not the first base of Tagged, so the object is not at the start of
+// its storage.
+struct Tag {
+    long tag = 99;
+};
+
+struct Tagged : Tag, Base {
+    int v;
+    explicit Tagged(int x) : v(x) {}
+    int value() const override { return v + static_cast<int>(tag); }
+};
+
+struct Concrete {
+    int v = 5;
+};
+
+static_assert(sizeof(compact_polymorphic<Base>) == sizeof(void*));
+static_assert(beman::indirect::is_trivially_relocatable_v<compact_polymorphic<Base>>);
+
+TEST(CompactPolymorphicTest, DefaultConstructsT) {
+    compact_polymorphic<Concrete> a;
+    EXPECT_EQ(a->v, 5);
+    EXPECT_EQ(a.get_allocator().resource(), std::pmr::get_default_resource());
+}
+
+TEST(CompactPolymorphicTest, AllocatesFromResource) {
+    counting_resource<> resource;
+    {
+        compact_polymorphic<Base> a(std::allocator_arg, &resource, std::in_place_type<Derived>, 3);
+        EXPECT_EQ(a->value(), 3);
+        EXPECT_EQ(a.get_allocator().resource(), &resource);
+        EXPECT_EQ(resource.stats().allocations(), 1u);
+
+        compact_polymorphic<Base> b(std::allocator_arg, &resource, Tagged(1));
+        EXPECT_EQ(b->value(), 100);
+    }
+    EXPECT_EQ(resource.stats().deallocations(), 2u);
+    EXPECT_EQ(resource.stats().bytes_live(), 0u);
+}
+
+TEST(CompactPolymorphicTest, CopyClonesDynamicType) {
+    counting_resource<>       resource;
+    compact_polymorphic<Base> a(std::in_place_type<Tagged>, 1);
+
+    compact_polymorphic<Base> b(a);
+    EXPECT_EQ(b->value(), 100);
+    EXPECT_NE(&*a, &*b);
+    EXPECT_EQ(b.get_allocator().resource(), std::pmr::get_default_resource());
+
+    compact_polymorphic<Base> c(std::allocator_arg, &resource, a);
+    EXPECT_EQ(c->value(), 100);
+    EXPECT_EQ(c.get_allocator().resource(), &resource);
+    EXPECT_NE(dynamic_cast<const Tagged*>(&*c), nullptr);
+}
+
+TEST(CompactPolymorphicTest, MovedFromKeepsResource) {
+    counting_resource<>       resource;
+    compact_polymorphic<Base> a(std::allocator_arg, &resource, Derived(1));
+    const Base*               object = &*a;
+
+    compact_polymorphic<Base> b(std::move(a));
+    EXPECT_EQ(&*b, object);
+    EXPECT_TRUE(a.valueless_after_move());
+    EXPECT_EQ(a.get_allocator().resource(), &resource);
+
+    // A valueless handle allocates copies from its resource again.
+    a = b;
+    EXPECT_EQ(a->value(), 1);
+    EXPECT_EQ(resource.stats().allocations(), 2u);
+}
+
+TEST(CompactPolymorphicTest, MoveBetweenResources) {
+    counting_resource<>       r1;
+    counting_resource<>       r2;
+    compact_polymorphic<Base> a(std::allocator_arg, &r1, Derived(1));
+
+    compact_polymorphic<Base> b(std::allocator_arg, &r2, std::move(a));
+    EXPECT_EQ(b->value(), 1);
+    EXPECT_EQ(b.get_allocator().resource(), &r2);
+    EXPECT_TRUE(a.valueless_after_move());
+    EXPECT_EQ(r1.stats().bytes_live(), 0u);
+
+    compact_polymorphic<Base> c(std::allocator_arg, &r1, Derived(2));
+    c = std::move(b);
+    EXPECT_EQ(c->value(), 1);
+    EXPECT_EQ(c.get_allocator().resource(), &r1);
+    EXPECT_EQ(r2.stats().bytes_live(), 0u);
+
+    compact_polymorphic<Base> d(std::allocator_arg, &r1, Derived(3));
+    c = std::move(d);
+    EXPECT_EQ(c->value(), 3);
+    EXPECT_EQ(r1.stats().allocations(), 4u);
+}
+
+TEST(CompactPolymorphicTest, Swap) {
+    compact_polymorphic<Base> a(Derived(1));
+    compact_polymorphic<Base> b(Tagged(1));
+    swap(a, b);
+    EXPECT_EQ(a->value(), 100);
+    EXPECT_EQ(b->value(), 1);
+}
+
+} // namespace
@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <beman/indirect/compressed_indirect.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using beman::indirect::compressed_indirect;
+using beman::indirect::offset_allocator;
+using beman::indirect::offset_arena;
+using beman::indirect::offset_ptr;
+
+using arena = offset_arena<struct test_tag>;
+
+template <class T>
+using link = compressed_indirect<T, arena>;
+
+static_assert(sizeof(offset_ptr<int, arena>) == 4);
+static_assert(std::is_same_v<link<int>::pointer, offset_ptr<int, arena>>);
+static_assert(std::is_same_v<link<int>::const_pointer, offset_ptr<const int, arena>>);
+#if BEMAN_INDIRECT_USE_NO_UNIQUE_ADDRESS
+static_assert(sizeof(link<int>) == 4);
+#endif
+static_assert(beman::indirect::is_trivially_relocatable_v<link<std::string>>);
+static_assert(beman::indirect::is_arena_allocator_v<offset_allocator<int, arena>>);
+
+struct Big {
+    char bytes[128];
+};
+
+// Counts destructor calls.
+struct Tracked {
+    static inline int destroyed = 0;
+    int               v;
+    explicit Tracked(int x) : v(x) {}
+    Tracked(const Tracked&) = default;
+    ~Tracked() { ++destroyed; }
+};
+
+// A tree whose child links are compressed.
+struct Node {
+    int                     value;
+    std::vector<link<Node>> children;
+
+    friend bool operator==(const Node& lhs, const Node& rhs) {
+        return lhs.value == rhs.value && lhs.children == rhs.children;
+    }
+    friend bool operator!=(const Node& lhs, const Node& rhs) { return !(lhs == rhs); }
+};
+
+class CompressedIndirectTest : public ::testing::Test {
+  protected:
+    void SetUp() override { arena::reserve(1 << 20); }
+    void TearDown() override { arena::release(); }
+
+    static bool in_arena(const void* p) {
+        const auto* b = static_cast<const std::byte*>(p);
+        return b > arena::base() && b < arena::base() + arena::capacity();
+    }
+};
+
+// --- Pointer ---
+
+TEST_F(CompressedIndirectTest, OffsetPointer) {
+    offset_ptr<int, arena> null;
+    EXPECT_FALSE(null);
+    EXPECT_TRUE(null == nullptr);
+    EXPECT_EQ(null.get(), nullptr);
+
+    int*                   raw = static_cast<int*>(arena::allocate(sizeof(int), alignof(int)));
+    offset_ptr<int, arena> p(raw);
+    EXPECT_TRUE(p);
+    EXPECT_EQ(p.get(), raw);
+    EXPECT_TRUE(p == decltype(p)::pointer_to(*raw));
+    EXPECT_NE(p.offset(), 0u);
+
+    offset_ptr<const int, arena> c = p;
+    offset_ptr<void, arena>      v = p;
+    EXPECT_EQ(c.get(), raw);
+    EXPECT_EQ(v.get(), raw);
+}
+
+// --- Value semantics ---
+
+TEST_F(CompressedIndirectTest, AllocatesInArena) {
+    link<std::string> a(std::in_place, "hello");
+    EXPECT_EQ(*a, "hello");
+    EXPECT_TRUE(in_arena(a.operator->().get()));
+    EXPECT_EQ(a->size(), 5u);
+}
+
+TEST_F(CompressedIndirectTest, CopyIsDeep) {
+    link<std::string> a(std::in_place, "hello");
+    link<std::string> b = a;
+    EXPECT_EQ(*b, "hello");
+    EXPECT_NE(a.operator->(), b.operator->());
+
+    *b += " world";
+    EXPECT_EQ(*a, "hello");
+    EXPECT_NE(a, b);
+
+    a = b;
+    EXPECT_EQ(a, b);
+}
+
+TEST_F(CompressedIndirectTest, MoveLeavesSourceValueless) {
+    link<std::string> a(std::in_place, "hello");
+    auto              p = a.operator->();
+    link<std::string> b = std::move(a);
+    EXPECT_TRUE(a.valueless_after_move());
+    EXPECT_EQ(b.operator->(), p);
+
+    a = std::move(b);
+    EXPECT_EQ(*a, "hello");
+    EXPECT_TRUE(b.valueless_after_move());
+
+    swap(a, b);
+    EXPECT_TRUE(a.valueless_after_move());
+    EXPECT_EQ(*b, "hello");
+}
+
+TEST_F(CompressedIndirectTest, RecursiveTree) {
+    Node root{1, {}};
+    root.children.emplace_back(std::in_place, Node{2, {}});
+    root.children.emplace_back(std::in_place, Node{3, {}});
+    root.children[1]->children.emplace_back(std::in_place, Node{4, {}});
+
+    Node copy = root;
+    EXPECT_EQ(copy, root);
+    copy.children[1]->children[0]->value = 5;
+    EXPECT_NE(copy, root);
+    EXPECT_EQ(root.children[1]->children[0]->value, 4);
+}
+
+// --- Arena ---
+
+TEST_F(CompressedIndirectTest, DestructorsRunForNonDiscardableTypes) {
+    Tracked::destroyed = 0;
+    {
+        link<Tracked> a(std::in_place, 1);
+        link<Tracked> b = a;
+    }
+    EXPECT_EQ(Tracked::destroyed, 2);
+}
+
+TEST_F(CompressedIndirectTest, ExhaustionThrows) {
+    arena::release();
+    arena::reserve(64);
+    link<std::uint64_t> a(std::in_place, 1);
+    EXPECT_THROW(link<Big>(), std::bad_alloc);
+    EXPECT_EQ(*a, 1u);
+}
+
+TEST(CompressedIndirectArenaTest, ReserveRejectsOversizedRegions) {
+    if constexpr (sizeof(std::size_t) > 4) {
+        EXPECT_THROW(arena::reserve(arena::max_capacity + 1), std::length_error);
+    }
+    EXPECT_EQ(arena::base(), nullptr);
+    EXPECT_THROW(arena::allocate(1, 1), std::bad_alloc);
+}
+
+} // namespace
@@ -0,0 +1,238 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <beman/indirect/counting_allocator.hpp>
+
+#include <beman/indirect/indirect.hpp>
+#include <beman/indirect/polymorphic.hpp>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+using beman::indirect::allocation_stats;
+using beman::indirect::counting_allocator;
+using beman::indirect::counting_resource;
+using beman::indirect::local_counter;
+
+struct Base {
+    virtual ~Base()              = default;
+    virtual int value() const    = 0;
+    Base()                       = default;
+    Base(const Base&)            = default;
+    Base& operator=(const Base&) = default;
+};
+
+struct Derived : Base {
+    int                  v;
+    std::array<char, 40> padding{};
+    explicit Derived(int x) : v(x) {}
+    int value() const override { return v; }
+};
+
+// --- Counting ---
+
+TEST(CountingAllocatorTest, CountsIndirect) {
+    allocation_stats<> stats;
+    using alloc_type = counting_allocator<double>;
+    {
+        beman::indirect::indirect<double, alloc_type> a(std::allocator_arg, alloc_type(stats), 1.0);
+        EXPECT_EQ(stats.allocations(), 1u);
+        EXPECT_EQ(stats.deallocations(), 0u);
+        EXPECT_EQ(stats.bytes_live(), sizeof(double));
+
+        auto b = a;
+        EXPECT_EQ(stats.allocations(), 2u);
+        EXPECT_EQ(stats.bytes_live(), 2 * sizeof(double));
+    }
+    EXPECT_EQ(stats.deallocations(), 2u);
+    EXPECT_EQ(stats.bytes_live(), 0u);
+    EXPECT_EQ(stats.peak_bytes(), 2 * sizeof(double));
+}
+
+TEST(CountingAllocatorTest, RebindsThroughPolymorphic) {
+    allocation_stats<> stats;
+    using alloc_type = counting_allocator<Base>;
+    {
+        beman::indirect::polymorphic<Base, alloc_type> p(
+            std::allocator_arg, alloc_type(stats), std::in_place_type<Derived>, 7);
+        EXPECT_EQ(p->value(), 7);
+        EXPECT_EQ(stats.allocations(), 1u);
+        // The control block is counted, object and all.
+        EXPECT_GE(stats.bytes_live(), sizeof(Derived));
+
+        auto q = p;
+        EXPECT_EQ(stats.allocations(), 2u);
+    }
+    EXPECT_EQ(stats.deallocations(), 2u);
+    EXPECT_EQ(stats.bytes_live(), 0u);
+}
+
+TEST(CountingAllocatorTest, RebindKeepsStats) {
+    allocation_stats<>      stats;
+    counting_allocator<int> a(stats);
+
+    using rebound = std::allocator_traits<counting_allocator<int>>::rebind_alloc<Derived>;
+    static_assert(std::is_same_v<rebound, counting_allocator<Derived, std::allocator<Derived>>>);
+
+    rebound b(a);
+    EXPECT_EQ(&b.stats(), &stats);
+    Derived* p = b.allocate(3);
+    EXPECT_EQ(stats.bytes_live(), 3 * sizeof(Derived));
+    b.deallocate(p, 3);
+    EXPECT_EQ(counting_allocator<int>(b), a);
+}
+
+TEST(CountingAllocatorTest, SizeHistogram) {
+    using stats_type = allocation_stats<>;
+    static_assert(stats_type::size_bucket_of(0) == 0);
+    static_assert(stats_type::size_bucket_of(1) == 0);
+    static_assert(stats_type::size_bucket_of(2) == 1);
+    static_assert(stats_type::size_bucket_of(3) == 1);
+    static_assert(stats_type::size_bucket_of(64) == 6);
+    static_assert(stats_type::size_bucket_of(~std::size_t(0)) == stats_type::size_buckets - 1);
+
+    stats_type               stats;
+    counting_allocator<char> a(stats);
+    std::vector<char*>       blocks;
+    const std::array<int, 4> sizes = {8, 12, 15, 100};
+    for (int n : sizes)
+        blocks.push_back(a.allocate(n));
+    EXPECT_EQ(stats.size_histogram(3), 3u);
+    EXPECT_EQ(stats.size_histogram(6), 1u);
+    EXPECT_EQ(stats.size_histogram(4), 0u);
+    for (std::size_t i = 0; i < blocks.size(); ++i)
+        a.deallocate(blocks[i], sizes[i]);
+    EXPECT_EQ(stats.bytes_live(), 0u);
+    EXPECT_EQ(stats.peak_bytes(), 135u);
+}
+
+TEST(CountingAllocatorTest, ResetKeepsLiveBytes) {
+    allocation_stats<>      stats;
+    counting_allocator<int> a(stats);
+    int*                    p = a.allocate(4);
+    int*                    q = a.allocate(4);
+    a.deallocate(q, 4);
+    EXPECT_EQ(stats.peak_bytes(), 8 * sizeof(int));
+
+    stats.reset();
+    EXPECT_EQ(stats.allocations(), 0u);
+    EXPECT_EQ(stats.deallocations(), 0u);
+    EXPECT_EQ(stats.size_histogram(allocation_stats<>::size_bucket_of(4 * sizeof(int))), 0u);
+    EXPECT_EQ(stats.bytes_live(), 4 * sizeof(int));
+    EXPECT_EQ(stats.peak_bytes(), 4 * sizeof(int));
+
+    a.deallocate(p, 4);
+    EXPECT_EQ(stats.bytes_live(), 0u);
+    EXPECT_EQ(stats.deallocations(), 1u);
+}
+
+// --- Allocator requirements ---
+
+TEST(CountingAllocatorTest, Equality) {
+    allocation_stats<>      s1;
+    allocation_stats<>      s2;
+    counting_allocator<int> a(s1);
+    counting_allocator<int> b(s1);
+    counting_allocator<int> c(s2);
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, c);
+}
+
+TEST(CountingAllocatorTest, ForwardsInnerPropagationTraits) {
+    using pmr_alloc = counting_allocator<int, std::pmr::polymorphic_allocator<int>>;
+    using std_alloc = counting_allocator<int>;
+    static_assert(!std::allocator_traits<pmr_alloc>::propagate_on_container_move_assignment::value);
+    static_assert(std::allocator_traits<std_alloc>::propagate_on_container_move_assignment::value);
+    static_assert(!std::allocator_traits<std_alloc>::is_always_equal::value);
+}
+
+TEST(CountingAllocatorTest, PmrInner) {
+    std::array<std::byte, 1024>         buffer{};
+    std::pmr::monotonic_buffer_resource resource(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+
+    allocation_stats<> stats;
+    using alloc_type = counting_allocator<int, std::pmr::polymorphic_allocator<int>>;
+    std::vector<int, alloc_type> v(alloc_type(stats, &resource));
+    v.reserve(16);
+    v.push_back(1);
+    const auto* p = reinterpret_cast<const std::byte*>(v.data());
+    EXPECT_GE(p, buffer.data());
+    EXPECT_LT(p, buffer.data() + buffer.size());
+    EXPECT_EQ(stats.bytes_live(), 16 * sizeof(int));
+}
+
+// --- Counter policies ---
+
+TEST(CountingAllocatorTest, LocalCounter) {
+    allocation_stats<local_counter> stats;
+    using alloc_type = counting_allocator<int, std::allocator<int>, local_counter>;
+    {
+        beman::indirect::indirect<int, alloc_type> a(std::allocator_arg, alloc_type(stats), 3);
+        EXPECT_EQ(stats.bytes_live(), sizeof(int));
+    }
+    EXPECT_EQ(stats.allocations(), 1u);
+    EXPECT_EQ(stats.bytes_live(), 0u);
+}
+
+TEST(CountingAllocatorTest, RelaxedCounterAcrossThreads) {
+    constexpr int      threads    = 4;
+    constexpr int      per_thread = 1000;
+    allocation_stats<> stats;
+    {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&] {
+                counting_allocator<int> a(stats);
+                for (int i = 0; i < per_thread; ++i)
+                    a.deallocate(a.allocate(1), 1);
+            });
+        }
+        for (auto& w : workers)
+            w.join();
+    }
+    EXPECT_EQ(stats.allocations(), std::size_t(threads * per_thread));
+    EXPECT_EQ(stats.deallocations(), std::size_t(threads * per_thread));
+    EXPECT_EQ(stats.bytes_live(), 0u);
+    EXPECT_GE(stats.peak_bytes(), sizeof(int));
+    EXPECT_LE(stats.peak_bytes(), threads * sizeof(int));
+}
+
+// --- counting_resource ---
+
+TEST(CountingResourceTest, CountsPmrPolymorphic) {
+    counting_resource<> resource;
+    {
+        beman::indirect::pmr::polymorphic<Base> p(std::allocator_arg, &resource, std::in_place_type<Derived>, 1);
+        beman::indirect::pmr::indirect<int>     i(std::allocator_arg, &resource, 2);
+        EXPECT_EQ(resource.stats().allocations(), 2u);
+        EXPECT_GE(resource.stats().bytes_live(), sizeof(Derived) + sizeof(int));
+    }
+    EXPECT_EQ(resource.stats().deallocations(), 2u);
+    EXPECT_EQ(resource.stats().bytes_live(), 0u);
+}
+
+TEST(CountingResourceTest, ForwardsToUpstream) {
+    std::array<std::byte, 256>          buffer{};
+    std::pmr::monotonic_buffer_resource upstream(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+    counting_resource<local_counter>    resource(&upstream);
+    EXPECT_EQ(resource.upstream_resource(), &upstream);
+
+    void* p = resource.allocate(32, 16);
+    EXPECT_GE(static_cast<std::byte*>(p), buffer.data());
+    EXPECT_LT(static_cast<std::byte*>(p), buffer.data() + buffer.size());
+    EXPECT_EQ(resource.stats().size_histogram(5), 1u);
+    resource.deallocate(p, 32, 16);
+    EXPECT_EQ(resource.stats().bytes_live(), 0u);
+    EXPECT_TRUE(resource.is_equal(resource));
+    EXPECT_FALSE(resource.is_equal(upstream));
+}
+
+} // namespace
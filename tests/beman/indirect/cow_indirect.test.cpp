@@ -0,0 +1,291 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <beman/indirect/cow_indirect.hpp>
+
+#include "test_helpers.hpp"
+
+#include <gtest/gtest.h>
+
+#include <beman/indirect/detail/config.hpp>
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using beman::indirect::cow_indirect;
+using beman::indirect::local_refcount;
+
+// --- Construction ---
+
+TEST(CowIndirectTest, DefaultConstruction) {
+    cow_indirect<int> i;
+    EXPECT_FALSE(i.valueless_after_move());
+    EXPECT_EQ(*std::as_const(i), 0);
+    EXPECT_EQ(i.use_count(), 1u);
+}
+
+TEST(CowIndirectTest, ForwardingConstruction) {
+    cow_indirect<std::string> s(std::string("hello"));
+    EXPECT_EQ(*std::as_const(s), "hello");
+}
+
+TEST(CowIndirectTest, InPlaceConstruction) {
+    cow_indirect<std::string> s(std::in_place, 3, 'x');
+    EXPECT_EQ(*std::as_const(s), "xxx");
+}
+
+TEST(CowIndirectTest, InPlaceConstructionInitializerList) {
+    cow_indirect<std::vector<int>> v(std::in_place, {1, 2, 3});
+    EXPECT_EQ(std::as_const(v)->size(), 3u);
+}
+
+TEST(CowIndirectTest, DeductionGuide) {
+    cow_indirect i(42);
+    static_assert(std::is_same_v<decltype(i), cow_indirect<int>>);
+    EXPECT_EQ(*std::as_const(i), 42);
+}
+
+// --- Sharing ---
+
+TEST(CowIndirectTest, CopySharesValue) {
+    cow_indirect<std::string> a(std::string("hello"));
+    cow_indirect<std::string> b(a);
+    EXPECT_EQ(&*std::as_const(a), &*std::as_const(b));
+    EXPECT_EQ(a.use_count(), 2u);
+    EXPECT_EQ(b.use_count(), 2u);
+}
+
+TEST(CowIndirectTest, MutableAccessDetaches) {
+    cow_indirect<std::string> a(std::string("hello"));
+    cow_indirect<std::string> b(a);
+    *b += " world";
+    EXPECT_EQ(*std::as_const(a), "hello");
+    EXPECT_EQ(*std::as_const(b), "hello world");
+    EXPECT_NE(&*std::as_const(a), &*std::as_const(b));
+    EXPECT_EQ(a.use_count(), 1u);
+    EXPECT_EQ(b.use_count(), 1u);
+}
+
+TEST(CowIndirectTest, MutableAccessOnSoleOwnerDoesNotCopy) {
+    cow_indirect<std::string> a(std::string("hello"));
+    const std::string*        addr = &*std::as_const(a);
+    a->append("!");
+    EXPECT_EQ(&*std::as_const(a), addr);
+    EXPECT_EQ(*std::as_const(a), "hello!");
+}
+
+TEST(CowIndirectTest, ConstAccessDoesNotDetach) {
+    cow_indirect<std::string>       a(std::string("hello"));
+    const cow_indirect<std::string> b(a);
+    EXPECT_EQ(b->size(), 5u);
+    EXPECT_EQ(*b, "hello");
+    EXPECT_EQ(a.use_count(), 2u);
+}
+
+TEST(CowIndirectTest, RvalueDereferenceDetaches) {
+    cow_indirect<std::string> a(std::string("hello"));
+    cow_indirect<std::string> b(a);
+    std::string               s = *std::move(b);
+    EXPECT_EQ(s, "hello");
+    EXPECT_EQ(*std::as_const(a), "hello");
+}
+
+// --- Copy/Move ---
+
+TEST(CowIndirectTest, CopyAssignmentShares) {
+    cow_indirect<int> a(1);
+    cow_indirect<int> b(2);
+    b = a;
+    EXPECT_EQ(*std::as_const(b), 1);
+    EXPECT_EQ(a.use_count(), 2u);
+}
+
+TEST(CowIndirectTest, SelfCopyAssignment) {
+    cow_indirect<int> a(1);
+    auto&             ref = a;
+    a                     = ref;
+    EXPECT_EQ(*std::as_const(a), 1);
+    EXPECT_EQ(a.use_count(), 1u);
+}
+
+TEST(CowIndirectTest, MoveConstruction) {
+    cow_indirect<int> a(42);
+    const int*        addr = &*std::as_const(a);
+    cow_indirect<int> b(std::move(a));
+    EXPECT_TRUE(a.valueless_after_move());
+    EXPECT_EQ(&*std::as_const(b), addr);
+    EXPECT_EQ(a.use_count(), 0u);
+}
+
+TEST(CowIndirectTest, MoveAssignment) {
+    cow_indirect<int> a(1);
+    cow_indirect<int> b(a);
+    cow_indirect<int> c(2);
+    c = std::move(b);
+    EXPECT_TRUE(b.valueless_after_move());
+    EXPECT_EQ(*std::as_const(c), 1);
+    EXPECT_EQ(a.use_count(), 2u);
+}
+
+TEST(CowIndirectTest, ForwardingAssignmentToSharedLeavesOthersAlone) {
+    cow_indirect<std::string> a(std::string("hello"));
+    cow_indirect<std::string> b(a);
+    b = std::string("bye");
+    EXPECT_EQ(*std::as_const(a), "hello");
+    EXPECT_EQ(*std::as_const(b), "bye");
+}
+
+TEST(CowIndirectTest, ForwardingAssignmentToValueless) {
+    cow_indirect<int> a(1);
+    cow_indirect<int> b(std::move(a));
+    a = 5;
+    EXPECT_EQ(*std::as_const(a), 5);
+}
+
+TEST(CowIndirectTest, Swap) {
+    cow_indirect<int> a(1);
+    cow_indirect<int> b(2);
+    swap(a, b);
+    EXPECT_EQ(*std::as_const(a), 2);
+    EXPECT_EQ(*std::as_const(b), 1);
+}
+
+// --- Comparisons and hash ---
+
+TEST(CowIndirectTest, Equality) {
+    cow_indirect<int> a(1);
+    cow_indirect<int> b(1);
+    cow_indirect<int> c(2);
+    EXPECT_TRUE(a == b);
+    EXPECT_FALSE(a == c);
+    EXPECT_TRUE(a != c);
+    EXPECT_TRUE(a == 1);
+    EXPECT_TRUE(a < c);
+    EXPECT_EQ(a.use_count(), 1u);
+}
+
+TEST(CowIndirectTest, EqualityValueless) {
+    cow_indirect<int> a(1);
+    cow_indirect<int> b(std::move(a));
+    cow_indirect<int> c(2);
+    cow_indirect<int> d(std::move(c));
+    EXPECT_TRUE(a == c);
+    EXPECT_FALSE(a == b);
+    EXPECT_TRUE(a < b);
+}
+
+TEST(CowIndirectTest, Hash) {
+    cow_indirect<int> a(42);
+    EXPECT_EQ(std::hash<cow_indirect<int>>{}(a), std::hash<int>{}(42));
+    std::unordered_set<cow_indirect<int>> set;
+    set.insert(a);
+    EXPECT_EQ(set.count(cow_indirect<int>(42)), 1u);
+}
+
+// --- Allocation tracking ---
+
+TEST(CowIndirectTest, CountAllocationsForCopy) {
+    unsigned alloc_counter   = 0;
+    unsigned dealloc_counter = 0;
+    {
+        test::TrackingAllocator<int>                    alloc(&alloc_counter, &dealloc_counter);
+        cow_indirect<int, test::TrackingAllocator<int>> a(std::allocator_arg, alloc, 42);
+        std::vector<cow_indirect<int, test::TrackingAllocator<int>>> copies(8, a);
+        EXPECT_EQ(alloc_counter, 1u);
+        EXPECT_EQ(a.use_count(), 9u);
+        *copies[0] = 7;
+        EXPECT_EQ(alloc_counter, 2u);
+        EXPECT_EQ(*std::as_const(a), 42);
+    }
+    EXPECT_EQ(dealloc_counter, 2u);
+}
+
+TEST(CowIndirectTest, NonEqualAllocatorCopyIsDeep) {
+    unsigned alloc_counter   = 0;
+    unsigned dealloc_counter = 0;
+    {
+        test::NonEqualTrackingAllocator<int>                    alloc(&alloc_counter, &dealloc_counter);
+        cow_indirect<int, test::NonEqualTrackingAllocator<int>> a(std::allocator_arg, alloc, 42);
+        cow_indirect<int, test::NonEqualTrackingAllocator<int>> b(a);
+        EXPECT_EQ(alloc_counter, 2u);
+        EXPECT_EQ(a.use_count(), 1u);
+        EXPECT_EQ(*std::as_const(b), 42);
+    }
+    EXPECT_EQ(dealloc_counter, 2u);
+}
+
+TEST(CowIndirectTest, ConstructorExceptionCleansUpAllocation) {
+    unsigned alloc_counter   = 0;
+    unsigned dealloc_counter = 0;
+    using alloc_type         = test::TrackingAllocator<test::ThrowsOnConstruction>;
+    auto construct           = [&]() {
+        return cow_indirect<test::ThrowsOnConstruction, alloc_type>(std::allocator_arg,
+                                                                    alloc_type(&alloc_counter, &dealloc_counter));
+    };
+    EXPECT_THROW(construct(), test::ThrowsOnConstruction::Exception);
+    EXPECT_EQ(alloc_counter, 1u);
+    EXPECT_EQ(dealloc_counter, 1u);
+}
+
+TEST(CowIndirectTest, DetachExceptionKeepsSharedValue) {
+    cow_indirect<test::ThrowsOnCopy> a(std::in_place, 42);
+    cow_indirect<test::ThrowsOnCopy> b(a);
+    EXPECT_THROW((*b).value = 1, test::ThrowsOnCopy::Exception);
+    EXPECT_EQ(std::as_const(b)->value, 42);
+    EXPECT_EQ(a.use_count(), 2u);
+}
+
+// --- Refcount policies ---
+
+TEST(CowIndirectTest, LocalRefcountPolicy) {
+    cow_indirect<std::string, std::allocator<std::string>, local_refcount> a(std::string("hello"));
+    auto                                                                   b = a;
+    EXPECT_EQ(a.use_count(), 2u);
+    *b = "bye";
+    EXPECT_EQ(*std::as_const(a), "hello");
+    EXPECT_EQ(a.use_count(), 1u);
+}
+
+TEST(CowIndirectTest, AtomicRefcountAcrossThreads) {
+    const cow_indirect<std::vector<int>> shared(std::in_place, 1000u, 1);
+    std::array<std::thread, 4>           threads;
+    for (auto& t : threads) {
+        t = std::thread([&shared] {
+            for (int i = 0; i < 1000; ++i) {
+                cow_indirect<std::vector<int>> copy(shared);
+                if (i % 10 == 0)
+                    (*copy)[0] = i;
+            }
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+    EXPECT_EQ(shared.use_count(), 1u);
+    EXPECT_EQ((*shared)[0], 1);
+}
+
+// --- PMR ---
+
+TEST(CowIndirectTest, PmrSharesWithinResource) {
+    std::array<std::byte, 1024>          buffer{};
+    std::pmr::monotonic_buffer_resource  resource(buffer.data(), buffer.size());
+    std::pmr::polymorphic_allocator<int> alloc(&resource);
+
+    beman::indirect::pmr::cow_indirect<int> a(std::allocator_arg, alloc, 42);
+    beman::indirect::pmr::cow_indirect<int> b(std::allocator_arg, alloc, a);
+    EXPECT_EQ(a.use_count(), 2u);
+    // Plain copy selects the default resource, which cannot free a's block.
+    beman::indirect::pmr::cow_indirect<int> c(a);
+    EXPECT_EQ(c.use_count(), 1u);
+    EXPECT_EQ(*std::as_const(c), 42);
+}
+
+} // namespace
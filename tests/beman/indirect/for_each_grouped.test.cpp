@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <beman/indirect/for_each_grouped.hpp>
+
+#include <beman/indirect/polymorphic.hpp>
+#include <beman/indirect/sealed_polymorphic.hpp>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using beman::indirect::for_each_grouped;
+using beman::indirect::polymorphic;
+
+// Test hierarchy
+struct Shape {
+    virtual ~Shape()                 = default;
+    virtual double      area() const = 0;
+    virtual std::string name() const = 0;
+    Shape()                          = default;
+    Shape(const Shape&)              = default;
+    Shape(Shape&&)                   = default;
+    Shape& operator=(const Shape&)   = default;
+    Shape& operator=(Shape&&)        = default;
+};
+
+struct Circle final : Shape {
+    double r_;
+    explicit Circle(double r = 1) : r_(r) {}
+    double      area() const override { return 3 * r_ * r_; }
+    std::string name() const override { return "Circle" + std::to_string(static_cast<int>(r_)); }
+};
+
+struct Square final : Shape {
+    double side_;
+    explicit Square(double side = 1) : side_(side) {}
+    double      area() const override { return side_ * side_; }
+    std::string name() const override { return "Square" + std::to_string(static_cast<int>(side_)); }
+};
+
+struct Triangle final : Shape {
+    double      area() const override { return 1; }
+    std::string name() const override { return "Triangle"; }
+};
+
+std::vector<polymorphic<Shape>> mixed() {
+    std::vector<polymorphic<Shape>> v;
+    v.emplace_back(Circle(1));
+    v.emplace_back(Square(1));
+    v.emplace_back(Triangle());
+    v.emplace_back(Circle(2));
+    v.emplace_back(Square(2));
+    return v;
+}
+
+// Records each call as the static type f received and the object's name.
+struct Recorder {
+    std::vector<std::string>* calls;
+
+    void operator()(Circle& c) const { calls->push_back("Circle& " + c.name()); }
+    void operator()(Square& s) const { calls->push_back("Square& " + s.name()); }
+    void operator()(Shape& s) const { calls->push_back("Shape& " + s.name()); }
+};
+
+// --- Grouping ---
+
+TEST(ForEachGroupedTest, GroupsByTypeInBucketOrder) {
+    auto                     v = mixed();
+    std::vector<std::string> calls;
+    for_each_grouped<Square, Circle>(v, Recorder{&calls});
+    EXPECT_EQ(calls,
+              (std::vector<std::string>{"Square& Square1",
+                                        "Square& Square2",
+                                        "Circle& Circle1",
+                                        "Circle& Circle2",
+                                        "Shape& Triangle"}));
+}
+
+TEST(ForEachGroupedTest, NoTypesFallsBackToBase) {
+    auto                     v = mixed();
+    std::vector<std::string> calls;
+    for_each_grouped<>(v, Recorder{&calls});
+    ASSERT_EQ(calls.size(), v.size());
+    EXPECT_EQ(calls[0], "Shape& Circle1");
+    EXPECT_EQ(calls[2], "Shape& Triangle");
+}
+
+TEST(ForEachGroupedTest, MatchesExactTypeOnly) {
+    struct Base {
+        virtual ~Base() = default;
+    };
+    struct Middle : Base {};
+    struct Leaf : Middle {};
+
+    std::vector<polymorphic<Base>> v;
+    v.emplace_back(Middle());
+    v.emplace_back(Leaf());
+
+    int middles = 0;
+    int others  = 0;
+    for_each_grouped<Middle>(v, [&](auto& obj) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(obj)>, Middle>)
+            ++middles;
+        else
+            ++others;
+    });
+    EXPECT_EQ(middles, 1);
+    EXPECT_EQ(others, 1);
+}
+
+TEST(ForEachGroupedTest, SkipsValueless) {
+    auto v   = mixed();
+    auto tmp = std::move(v[0]);
+    int  n   = 0;
+    for_each_grouped<Circle>(v, [&](const auto&) { ++n; });
+    EXPECT_EQ(n, 4);
+}
+
+// --- Mutation and constness ---
+
+TEST(ForEachGroupedTest, MutatesThroughStaticType) {
+    auto v = mixed();
+    for_each_grouped<Circle, Square>(v, [](auto& obj) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(obj)>, Circle>)
+            obj.r_ *= 10;
+    });
+    EXPECT_EQ(v[0]->area(), 300);
+    EXPECT_EQ(v[3]->area(), 1200);
+}
+
+TEST(ForEachGroupedTest, ConstRange) {
+    const auto v     = mixed();
+    double     total = 0;
+    for_each_grouped<Circle, Square>(v, [&](const auto& obj) {
+        static_assert(std::is_const_v<std::remove_reference_t<decltype(obj)>>);
+        total += obj.area();
+    });
+    EXPECT_EQ(total, 3 + 1 + 1 + 12 + 4);
+}
+
+TEST(ForEachGroupedTest, ReturnsFunction) {
+    struct Counter {
+        int  n = 0;
+        void operator()(const Shape&) { ++n; }
+    };
+    auto v = mixed();
+    EXPECT_EQ(for_each_grouped<Circle>(v, Counter{}).n, 5);
+}
+
+// --- Other handles ---
+
+TEST(ForEachGroupedTest, SealedPolymorphic) {
+    using sealed = beman::indirect::sealed_polymorphic<Shape, Circle, Square, Triangle>;
+    std::vector<sealed> v;
+    v.emplace_back(Circle(1));
+    v.emplace_back(Square(2));
+    v.emplace_back(Circle(3));
+
+    std::vector<std::string> calls;
+    for_each_grouped<Circle>(v, Recorder{&calls});
+    EXPECT_EQ(calls, (std::vector<std::string>{"Circle& Circle1", "Circle& Circle3", "Shape& Square2"}));
+}
+
+} // namespace
@@ -0,0 +1,246 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <beman/indirect/hashed_indirect.hpp>
+
+#include "test_helpers.hpp"
+
+#include <gtest/gtest.h>
+
+#include <beman/indirect/detail/config.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using beman::indirect::hashed_indirect;
+
+// Hash that counts its invocations so tests can tell cached from computed hashes.
+struct CountingHash {
+    static inline int calls = 0;
+    std::size_t       operator()(const std::string& s) const noexcept {
+        ++calls;
+        return std::hash<std::string>{}(s);
+    }
+};
+
+// Hash that maps every value to one bucket, so equal hashes do not imply equal values.
+struct ConstantHash {
+    std::size_t operator()(const std::string&) const noexcept { return 7; }
+};
+
+// String wrapper that counts equality comparisons.
+struct CountingEq {
+    static inline int calls = 0;
+    std::string       s;
+    CountingEq(const char* c) : s(c) {}
+    friend bool operator==(const CountingEq& lhs, const CountingEq& rhs) {
+        ++calls;
+        return lhs.s == rhs.s;
+    }
+    friend bool operator!=(const CountingEq& lhs, const CountingEq& rhs) { return !(lhs == rhs); }
+    friend bool operator<(const CountingEq& lhs, const CountingEq& rhs) { return lhs.s < rhs.s; }
+};
+
+struct CountingEqHash {
+    std::size_t operator()(const CountingEq& v) const noexcept { return std::hash<std::string>{}(v.s); }
+};
+
+using counted = hashed_indirect<std::string, std::allocator<std::string>, CountingHash>;
+
+// --- Construction ---
+
+TEST(HashedIndirectTest, DefaultConstruction) {
+    hashed_indirect<int> h;
+    EXPECT_EQ(*std::as_const(h), 0);
+    EXPECT_TRUE(h.hash_is_cached());
+    EXPECT_EQ(h.hash(), std::hash<int>{}(0));
+}
+
+TEST(HashedIndirectTest, ForwardingConstruction) {
+    hashed_indirect<std::string> h(std::string("hello"));
+    EXPECT_EQ(*h, "hello");
+    EXPECT_EQ(h.hash(), std::hash<std::string>{}("hello"));
+}
+
+TEST(HashedIndirectTest, InPlaceConstruction) {
+    hashed_indirect<std::string> h(std::in_place, 3, 'x');
+    EXPECT_EQ(*h, "xxx");
+}
+
+TEST(HashedIndirectTest, AllocatorExtendedConstruction) {
+    using handle = hashed_indirect<std::string, test::TrackingAllocator<std::string>>;
+
+    unsigned                             alloc_counter   = 0;
+    unsigned                             dealloc_counter = 0;
+    test::TrackingAllocator<std::string> alloc(&alloc_counter, &dealloc_counter);
+    handle                               h(std::allocator_arg, alloc, "hello");
+    EXPECT_EQ(alloc_counter, 1u);
+    EXPECT_EQ(*std::as_const(h), "hello");
+}
+
+TEST(HashedIndirectTest, DeductionGuide) {
+    hashed_indirect h(42);
+    static_assert(std::is_same_v<decltype(h), hashed_indirect<int>>);
+    EXPECT_EQ(*h, 42);
+}
+
+// --- Hash caching ---
+
+TEST(HashedIndirectTest, HashIsComputedOnce) {
+    CountingHash::calls = 0;
+    counted h(std::string("hello"));
+    EXPECT_EQ(CountingHash::calls, 1);
+    for (int i = 0; i < 10; ++i)
+        EXPECT_EQ(h.hash(), std::hash<std::string>{}("hello"));
+    EXPECT_EQ(std::hash<counted>{}(h), std::hash<std::string>{}("hello"));
+    EXPECT_EQ(CountingHash::calls, 1);
+}
+
+TEST(HashedIndirectTest, CopyKeepsCachedHash) {
+    CountingHash::calls = 0;
+    counted a(std::string("hello"));
+    counted b(a);
+    counted c(std::move(a));
+    EXPECT_TRUE(b.hash_is_cached());
+    EXPECT_TRUE(c.hash_is_cached());
+    EXPECT_EQ(CountingHash::calls, 1);
+}
+
+TEST(HashedIndirectTest, MutableAccessInvalidates) {
+    counted h(std::string("hello"));
+    *h += " world";
+    EXPECT_FALSE(h.hash_is_cached());
+    EXPECT_EQ(h.hash(), std::hash<std::string>{}("hello world"));
+    h->append("!");
+    EXPECT_EQ(h.hash(), std::hash<std::string>{}("hello world!"));
+}
+
+TEST(HashedIndirectTest, ConstAccessKeepsCache) {
+    const counted h(std::string("hello"));
+    EXPECT_EQ(h->size(), 5u);
+    EXPECT_EQ(*h, "hello");
+    EXPECT_TRUE(h.hash_is_cached());
+}
+
+TEST(HashedIndirectTest, UpdateHashRefreshesCache) {
+    CountingHash::calls = 0;
+    counted h(std::string("a"));
+    *h                  = "b";
+    CountingHash::calls = 0;
+    h.update_hash();
+    EXPECT_TRUE(h.hash_is_cached());
+    EXPECT_EQ(h.hash(), std::hash<std::string>{}("b"));
+    EXPECT_EQ(CountingHash::calls, 1);
+}
+
+TEST(HashedIndirectTest, AssignmentRecomputes) {
+    counted h(std::string("a"));
+    *h = "stale";
+    h  = std::string("b");
+    EXPECT_TRUE(h.hash_is_cached());
+    EXPECT_EQ(h.hash(), std::hash<std::string>{}("b"));
+}
+
+TEST(HashedIndirectTest, EmplaceRecomputes) {
+    counted      h(std::string("a"));
+    std::string& r = h.emplace(2, 'z');
+    EXPECT_EQ(r, "zz");
+    EXPECT_TRUE(h.hash_is_cached());
+    EXPECT_EQ(h.hash(), std::hash<std::string>{}("zz"));
+}
+
+TEST(HashedIndirectTest, HashValueless) {
+    hashed_indirect<int> a(1);
+    hashed_indirect<int> b(std::move(a));
+    EXPECT_TRUE(a.valueless_after_move());
+    EXPECT_FALSE(a.hash_is_cached());
+    EXPECT_EQ(a.hash(), static_cast<std::size_t>(-1));
+}
+
+// --- Comparisons ---
+
+TEST(HashedIndirectTest, EqualityShortCircuitsOnHash) {
+    using handle      = hashed_indirect<CountingEq, std::allocator<CountingEq>, CountingEqHash>;
+    CountingEq::calls = 0;
+    handle a(std::in_place, "alpha");
+    handle b(std::in_place, "beta");
+    handle c(std::in_place, "alpha");
+    EXPECT_FALSE(a == b);
+    EXPECT_EQ(CountingEq::calls, 0);
+    EXPECT_TRUE(a == c);
+    EXPECT_EQ(CountingEq::calls, 1);
+}
+
+TEST(HashedIndirectTest, EqualityWithCollidingHashes) {
+    using handle = hashed_indirect<std::string, std::allocator<std::string>, ConstantHash>;
+    handle a(std::string("alpha"));
+    handle b(std::string("beta"));
+    EXPECT_FALSE(a == b);
+    EXPECT_TRUE(a != b);
+}
+
+TEST(HashedIndirectTest, EqualityWithStaleHash) {
+    hashed_indirect<std::string> a(std::string("alpha"));
+    hashed_indirect<std::string> b(std::string("beta"));
+    *b = "alpha";
+    EXPECT_TRUE(a == b);
+}
+
+TEST(HashedIndirectTest, EqualityValueless) {
+    hashed_indirect<int> a(1);
+    hashed_indirect<int> b(std::move(a));
+    hashed_indirect<int> c(2);
+    hashed_indirect<int> d(std::move(c));
+    EXPECT_TRUE(a == c);
+    EXPECT_FALSE(a == b);
+}
+
+TEST(HashedIndirectTest, Ordering) {
+    hashed_indirect<int> a(1);
+    hashed_indirect<int> b(2);
+    EXPECT_TRUE(a < b);
+    EXPECT_TRUE(b > a);
+    EXPECT_TRUE(a <= a);
+    EXPECT_TRUE(a == 1);
+    EXPECT_TRUE(a != 2);
+}
+
+TEST(HashedIndirectTest, Swap) {
+    hashed_indirect<std::string> a(std::string("a"));
+    hashed_indirect<std::string> b(std::string("b"));
+    swap(a, b);
+    EXPECT_EQ(*a, "b");
+    EXPECT_EQ(a.hash(), std::hash<std::string>{}("b"));
+    EXPECT_EQ(*b, "a");
+}
+
+// --- Container integration ---
+
+TEST(HashedIndirectTest, UnorderedMapRehashDoesNotRecompute) {
+    CountingHash::calls = 0;
+    std::unordered_map<counted, int> m;
+    for (int i = 0; i < 100; ++i)
+        m.emplace(counted(std::to_string(i)), i);
+    const int after_insert = CountingHash::calls;
+    m.rehash(1024);
+    EXPECT_EQ(CountingHash::calls, after_insert);
+    EXPECT_EQ(m.at(counted(std::string("42"))), 42);
+}
+
+TEST(HashedIndirectTest, UnorderedSet) {
+    std::unordered_set<hashed_indirect<std::string>> s;
+    s.emplace(std::string("a"));
+    s.emplace(std::string("b"));
+    s.emplace(std::string("a"));
+    EXPECT_EQ(s.size(), 2u);
+    EXPECT_EQ(s.count(hashed_indirect<std::string>(std::string("b"))), 1u);
+}
+
+} // namespace
@@ -567,6 +567,60 @@ TEST(IndirectTest, CopyConstructionExceptionSafety) {
     EXPECT_EQ(dealloc_counter, 1u); // failed copy allocation cleaned up
 }
 
+// --- Emplace ---
+
+TEST(IndirectTest, EmplaceReusesAllocation) {
+    indirect<std::string> i("hello");
+    auto*                 addr = &*i;
+    std::string&          r    = i.emplace(3, 'x');
+    EXPECT_EQ(*i, "xxx");
+    EXPECT_EQ(&r, addr);
+    EXPECT_EQ(&*i, addr);
+}
+
+TEST(IndirectTest, EmplaceInitializerList) {
+    indirect<std::vector<int>> i(std::in_place, 10u, 0);
+    i.emplace({1, 2, 3});
+    EXPECT_EQ(*i, (std::vector<int>{1, 2, 3}));
+}
+
+TEST(IndirectTest, EmplaceIntoValueless) {
+    indirect<int> a(1);
+    indirect<int> b(std::move(a));
+    EXPECT_TRUE(a.valueless_after_move());
+    a.emplace(42);
+    EXPECT_FALSE(a.valueless_after_move());
+    EXPECT_EQ(*a, 42);
+}
+
+TEST(IndirectTest, CountAllocationsForEmplace) {
+    unsigned alloc_counter   = 0;
+    unsigned dealloc_counter = 0;
+    {
+        test::TrackingAllocator<int>                alloc(&alloc_counter, &dealloc_counter);
+        indirect<int, test::TrackingAllocator<int>> i(std::allocator_arg, alloc, 42);
+        EXPECT_EQ(alloc_counter, 1u);
+        i.emplace(7);
+        EXPECT_EQ(alloc_counter, 1u);
+        EXPECT_EQ(dealloc_counter, 0u);
+        EXPECT_EQ(*i, 7);
+    }
+    EXPECT_EQ(dealloc_counter, 1u);
+}
+
+TEST(IndirectTest, EmplaceExceptionLeavesValueless) {
+    unsigned                                    alloc_counter   = 0;
+    unsigned                                    dealloc_counter = 0;
+    test::TrackingAllocator<test::ThrowsOnCopy> alloc(&alloc_counter, &dealloc_counter);
+    indirect<test::ThrowsOnCopy, test::TrackingAllocator<test::ThrowsOnCopy>> i(
+        std::allocator_arg, alloc, test::ThrowsOnCopy(42));
+    const test::ThrowsOnCopy src(7);
+    EXPECT_THROW(i.emplace(src), test::ThrowsOnCopy::Exception);
+    EXPECT_TRUE(i.valueless_after_move());
+    EXPECT_EQ(alloc_counter, 1u);
+    EXPECT_EQ(dealloc_counter, 1u);
+}
+
 // --- Non-equal allocator tests ---
 
 TEST(IndirectTest, MoveConstructionWithNonEqualAllocator) {
@@ -0,0 +1,224 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <beman/indirect/indirect_variant.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using beman::indirect::indirect_variant;
+
+struct null_t {
+    friend bool operator==(null_t, null_t) { return true; }
+    friend bool operator!=(null_t, null_t) { return false; }
+    friend bool operator<(null_t, null_t) { return false; }
+};
+
+// A recursive value whose handle is a single word.
+struct json {
+    using array_t  = std::vector<json>;
+    using object_t = std::map<std::string, json>;
+
+    indirect_variant<null_t, bool, double, std::string, array_t, object_t> data;
+
+    friend bool operator==(const json& lhs, const json& rhs) { return lhs.data == rhs.data; }
+    friend bool operator!=(const json& lhs, const json& rhs) { return !(lhs == rhs); }
+};
+
+using json_data = decltype(json::data);
+
+static_assert(sizeof(json) == sizeof(void*));
+static_assert(json_data::stored_inline<null_t>);
+static_assert(json_data::stored_inline<bool>);
+static_assert(!json_data::stored_inline<double>);
+static_assert(!json_data::stored_inline<std::string>);
+static_assert(indirect_variant<int, std::string>::stored_inline<int>);
+static_assert(beman::indirect::is_trivially_relocatable_v<json_data>);
+
+// Throws on copy once armed.
+struct Fragile {
+    static inline bool armed = false;
+    int                v;
+    explicit Fragile(int x) : v(x) {}
+    Fragile(const Fragile& other) : v(other.v) {
+        if (armed)
+            throw std::runtime_error("copy");
+    }
+    Fragile& operator=(const Fragile&) = default;
+};
+
+// --- Construction ---
+
+TEST(IndirectVariantTest, DefaultConstructsFirstAlternative) {
+    indirect_variant<int, std::string> v;
+    EXPECT_EQ(v.index(), 0u);
+    EXPECT_TRUE(v.holds<int>());
+    EXPECT_EQ(v.get<int>(), 0);
+}
+
+TEST(IndirectVariantTest, InlineAlternatives) {
+    indirect_variant<std::string, bool, char, std::int16_t, std::int32_t, float> v(std::int32_t(-123456));
+    EXPECT_EQ(v.get<std::int32_t>(), -123456);
+    static_assert(std::is_same_v<decltype(v.get<std::int32_t>()), std::int32_t>);
+
+    v = -1.5f;
+    EXPECT_EQ(v.get<float>(), -1.5f);
+    v = std::int16_t(-2);
+    EXPECT_EQ(v.get<std::int16_t>(), -2);
+    v = 'x';
+    EXPECT_EQ(v.get<char>(), 'x');
+    v = true;
+    EXPECT_TRUE(v.get<bool>());
+    EXPECT_EQ(v.index(), 1u);
+}
+
+TEST(IndirectVariantTest, BoxedAlternatives) {
+    indirect_variant<int, std::string, std::vector<int>> v(std::in_place_type<std::vector<int>>, {1, 2, 3});
+    ASSERT_TRUE(v.holds<std::vector<int>>());
+    EXPECT_EQ(v.get<std::vector<int>>().size(), 3u);
+    static_assert(std::is_same_v<decltype(v.get<std::vector<int>>()), std::vector<int>&>);
+
+    v.get<std::vector<int>>().push_back(4);
+    EXPECT_EQ(v.get_if<std::vector<int>>()->size(), 4u);
+    EXPECT_EQ(v.get_if<std::string>(), nullptr);
+    EXPECT_EQ(v.get_if<double>(), nullptr);
+
+    v.emplace<std::string>(3u, 'a');
+    EXPECT_EQ(v.get<std::string>(), "aaa");
+}
+
+TEST(IndirectVariantTest, OverAlignedBox) {
+    struct alignas(64) Wide {
+        int v;
+    };
+    indirect_variant<int, Wide> v(std::in_place_type<Wide>, Wide{9});
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(v.get_if<Wide>()) % 64, 0u);
+    EXPECT_EQ(v.get<Wide>().v, 9);
+}
+
+// --- Copy, move and assignment ---
+
+TEST(IndirectVariantTest, CopyIsDeep) {
+    indirect_variant<int, std::string> a(std::string("hello"));
+    indirect_variant<int, std::string> b(a);
+    EXPECT_EQ(b.get<std::string>(), "hello");
+    EXPECT_NE(a.get_if<std::string>(), b.get_if<std::string>());
+
+    indirect_variant<int, std::string> c(7);
+    c = a;
+    EXPECT_EQ(c.get<std::string>(), "hello");
+    c = indirect_variant<int, std::string>(8);
+    EXPECT_EQ(c.get<int>(), 8);
+}
+
+TEST(IndirectVariantTest, MoveLeavesSourceValueless) {
+    indirect_variant<int, std::string> a(std::string("hello"));
+    const std::string*                 p = a.get_if<std::string>();
+    indirect_variant<int, std::string> b(std::move(a));
+    EXPECT_EQ(b.get_if<std::string>(), p);
+    EXPECT_TRUE(a.valueless_after_move());
+    EXPECT_EQ(a.index(), (indirect_variant<int, std::string>::npos));
+
+    a = std::move(b);
+    EXPECT_EQ(a.get_if<std::string>(), p);
+    EXPECT_TRUE(b.valueless_after_move());
+
+    b = a;
+    EXPECT_EQ(b.get<std::string>(), "hello");
+}
+
+TEST(IndirectVariantTest, AssignSameBoxedAlternativeInPlace) {
+    indirect_variant<int, std::string> a(std::string("first"));
+    const std::string*                 p = a.get_if<std::string>();
+    a = std::string("second");
+    EXPECT_EQ(a.get_if<std::string>(), p);
+    EXPECT_EQ(a.get<std::string>(), "second");
+}
+
+TEST(IndirectVariantTest, FailedCopyLeavesTargetUnchanged) {
+    indirect_variant<int, Fragile> a(std::in_place_type<Fragile>, 1);
+    indirect_variant<int, Fragile> b(2);
+    Fragile::armed = true;
+    EXPECT_THROW(b = a, std::runtime_error);
+    EXPECT_THROW(b.emplace<Fragile>(a.get<Fragile>()), std::runtime_error);
+    Fragile::armed = false;
+    EXPECT_EQ(b.get<int>(), 2);
+}
+
+TEST(IndirectVariantTest, Swap) {
+    indirect_variant<int, std::string> a(1);
+    indirect_variant<int, std::string> b(std::string("two"));
+    swap(a, b);
+    EXPECT_EQ(a.get<std::string>(), "two");
+    EXPECT_EQ(b.get<int>(), 1);
+}
+
+// --- Visitation and comparison ---
+
+TEST(IndirectVariantTest, Visit) {
+    auto describe = [](const auto& value) -> std::string {
+        using V = std::decay_t<decltype(value)>;
+        if constexpr (std::is_same_v<V, int>)
+            return "int " + std::to_string(value);
+        else
+            return "string " + value;
+    };
+    const indirect_variant<int, std::string> a(3);
+    const indirect_variant<int, std::string> b(std::string("x"));
+    EXPECT_EQ(a.visit(describe), "int 3");
+    EXPECT_EQ(b.visit(describe), "string x");
+
+    indirect_variant<int, std::string> c(std::string("y"));
+    c.visit([](auto& value) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(value)>, std::string>)
+            value += "z";
+    });
+    EXPECT_EQ(c.get<std::string>(), "yz");
+}
+
+TEST(IndirectVariantTest, Comparison) {
+    using V = indirect_variant<int, std::string>;
+    V one(1);
+    V two(2);
+    V str(std::string("a"));
+    EXPECT_TRUE(one == V(1));
+    EXPECT_TRUE(one != two);
+    EXPECT_TRUE(one < two);
+    EXPECT_TRUE(two < str);
+    EXPECT_FALSE(str == V(std::string("b")));
+
+    V empty(std::move(two));
+    V other(std::move(one));
+    EXPECT_TRUE(two == one);
+    EXPECT_TRUE(two < str);
+    EXPECT_FALSE(str < two);
+}
+
+TEST(IndirectVariantTest, RecursiveValue) {
+    json leaf{json_data(2.5)};
+    json array{json_data(json::array_t{leaf, json{json_data(true)}, json{}})};
+    json root{json_data(std::in_place_type<json::object_t>)};
+    root.data.get<json::object_t>().emplace("items", array);
+    root.data.get<json::object_t>().emplace("name", json{json_data(std::string("doc"))});
+
+    json copy = root;
+    EXPECT_EQ(copy, root);
+    const json::array_t& items = copy.data.get<json::object_t>().at("items").data.get<json::array_t>();
+    ASSERT_EQ(items.size(), 3u);
+    EXPECT_EQ(items[0].data.get<double>(), 2.5);
+    EXPECT_TRUE(items[1].data.get<bool>());
+    EXPECT_TRUE(items[2].data.holds<null_t>());
+
+    copy.data.get<json::object_t>().at("name") = json{json_data(false)};
+    EXPECT_NE(copy, root);
+}
+
+} // namespace
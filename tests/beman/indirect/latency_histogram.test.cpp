@@ -0,0 +1,173 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <beman/indirect/latency_histogram.hpp>
+
+#include <beman/indirect/indirect.hpp>
+#include <beman/indirect/polymorphic.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using beman::indirect::latency_histogram;
+using beman::indirect::latency_histogram_of;
+using beman::indirect::latency_op;
+
+struct Base {
+    virtual ~Base()              = default;
+    virtual int value() const    = 0;
+    Base()                       = default;
+    Base(const Base&)            = default;
+    Base& operator=(const Base&) = default;
+};
+
+struct Derived : Base {
+    int v;
+    explicit Derived(int x) : v(x) {}
+    int value() const override { return v; }
+};
+
+// --- Buckets ---
+
+TEST(LatencyHistogramTest, BucketBounds) {
+    static_assert(latency_histogram::bucket_of(0) == 0);
+    static_assert(latency_histogram::bucket_of(7) == 7);
+    static_assert(latency_histogram::bucket_of(8) == 8);
+    static_assert(latency_histogram::bucket_of(15) == 15);
+    static_assert(latency_histogram::bucket_of(16) == 16);
+    static_assert(latency_histogram::bucket_of(17) == 16);
+    static_assert(latency_histogram::bucket_of(18) == 17);
+    static_assert(latency_histogram::bucket_of(~std::uint64_t(0)) == latency_histogram::buckets - 1);
+
+    for (std::size_t b = 0; b + 1 < latency_histogram::buckets; ++b) {
+        ASSERT_EQ(latency_histogram::bucket_of(latency_histogram::bucket_lower(b)), b);
+        ASSERT_EQ(latency_histogram::bucket_of(latency_histogram::bucket_upper(b)), b);
+        ASSERT_EQ(latency_histogram::bucket_upper(b) + 1, latency_histogram::bucket_lower(b + 1));
+    }
+}
+
+TEST(LatencyHistogramTest, RelativeErrorIsBounded) {
+    for (std::size_t b = latency_histogram::sub_buckets; b + 1 < latency_histogram::buckets; ++b) {
+        const std::uint64_t lower = latency_histogram::bucket_lower(b);
+        const std::uint64_t width = latency_histogram::bucket_upper(b) - lower + 1;
+        ASSERT_LE(width * 8, lower);
+    }
+}
+
+// --- Recording ---
+
+TEST(LatencyHistogramTest, EmptyHistogram) {
+    latency_histogram h;
+    EXPECT_EQ(h.count(), 0u);
+    EXPECT_EQ(h.max(), 0u);
+    EXPECT_EQ(h.percentile(99), 0u);
+}
+
+TEST(LatencyHistogramTest, Percentiles) {
+    latency_histogram h;
+    for (std::uint64_t i = 1; i <= 1000; ++i)
+        h.record(i);
+    EXPECT_EQ(h.count(), 1000u);
+    EXPECT_EQ(h.total(), 500500u);
+    EXPECT_EQ(h.max(), 1000u);
+
+    const std::uint64_t p50 = h.percentile(50);
+    EXPECT_GE(p50, 500u);
+    EXPECT_LE(p50, 500u + 500u / 8);
+    const std::uint64_t p99 = h.percentile(99);
+    EXPECT_GE(p99, 990u);
+    EXPECT_LE(p99, 1000u);
+    EXPECT_EQ(h.percentile(100), 1000u);
+    EXPECT_EQ(h.percentile(0), 1u);
+}
+
+TEST(LatencyHistogramTest, TailIsVisible) {
+    latency_histogram h;
+    for (int i = 0; i < 9990; ++i)
+        h.record(100);
+    for (int i = 0; i < 10; ++i)
+        h.record(1000000);
+    EXPECT_LT(h.percentile(99), 200u);
+    EXPECT_GE(h.percentile(99.95), 1000000u * 7 / 8);
+}
+
+TEST(LatencyHistogramTest, Reset) {
+    latency_histogram h;
+    h.record(42);
+    h.reset();
+    EXPECT_EQ(h.count(), 0u);
+    EXPECT_EQ(h.total(), 0u);
+    EXPECT_EQ(h.max(), 0u);
+}
+
+TEST(LatencyHistogramTest, ConcurrentRecording) {
+    constexpr int     threads    = 4;
+    constexpr int     per_thread = 10000;
+    latency_histogram h;
+    {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&h, t] {
+                for (int i = 0; i < per_thread; ++i)
+                    h.record(static_cast<std::uint64_t>(t * 100 + i % 100));
+            });
+        }
+        for (auto& w : workers)
+            w.join();
+    }
+    EXPECT_EQ(h.count(), std::uint64_t(threads * per_thread));
+    EXPECT_EQ(h.max(), std::uint64_t((threads - 1) * 100 + 99));
+}
+
+// --- Hooks ---
+
+std::uint64_t recorded(latency_op op) { return latency_histogram_of(op).count(); }
+
+TEST(LatencyHooksTest, IndirectConstructAndDestroy) {
+    const std::uint64_t constructs = recorded(latency_op::indirect_construct);
+    const std::uint64_t destroys   = recorded(latency_op::indirect_destroy);
+    {
+        beman::indirect::indirect<int> a(1);
+        auto                           b = a;
+    }
+#if BEMAN_INDIRECT_USE_LATENCY_HOOKS
+    EXPECT_EQ(recorded(latency_op::indirect_construct), constructs + 2);
+    EXPECT_EQ(recorded(latency_op::indirect_destroy), destroys + 2);
+#else
+    EXPECT_EQ(recorded(latency_op::indirect_construct), constructs);
+    EXPECT_EQ(recorded(latency_op::indirect_destroy), destroys);
+#endif
+}
+
+TEST(LatencyHooksTest, PolymorphicOperations) {
+    const std::uint64_t constructs  = recorded(latency_op::polymorphic_construct);
+    const std::uint64_t clones      = recorded(latency_op::polymorphic_clone);
+    const std::uint64_t move_clones = recorded(latency_op::polymorphic_move_clone);
+    const std::uint64_t destroys    = recorded(latency_op::polymorphic_destroy);
+    {
+        beman::indirect::polymorphic<Base> a(std::in_place_type<Derived>, 1);
+        auto                               b = a;
+        // Moving between unequal allocators would move_clone; with
+        // std::allocator a move only transfers ownership.
+        auto c = std::move(b);
+        EXPECT_EQ(c->value(), 1);
+    }
+#if BEMAN_INDIRECT_USE_LATENCY_HOOKS
+    EXPECT_EQ(recorded(latency_op::polymorphic_construct), constructs + 1);
+    EXPECT_EQ(recorded(latency_op::polymorphic_clone), clones + 1);
+    EXPECT_EQ(recorded(latency_op::polymorphic_move_clone), move_clones);
+    EXPECT_EQ(recorded(latency_op::polymorphic_destroy), destroys + 2);
+#else
+    EXPECT_EQ(recorded(latency_op::polymorphic_construct), constructs);
+    EXPECT_EQ(recorded(latency_op::polymorphic_clone), clones);
+    EXPECT_EQ(recorded(latency_op::polymorphic_move_clone), move_clones);
+    EXPECT_EQ(recorded(latency_op::polymorphic_destroy), destroys);
+#endif
+}
+
+} // namespace
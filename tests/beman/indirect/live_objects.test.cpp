@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <beman/indirect/live_objects.hpp>
+
+#include <beman/indirect/polymorphic.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using beman::indirect::live_objects_of;
+using beman::indirect::live_objects_snapshot;
+using beman::indirect::polymorphic;
+using beman::indirect::polymorphic_type_id;
+
+struct Base {
+    virtual ~Base()              = default;
+    virtual int value() const    = 0;
+    Base()                       = default;
+    Base(const Base&)            = default;
+    Base& operator=(const Base&) = default;
+};
+
+// Each test uses types of its own, since the registry is process-wide.
+template <int N, std::size_t Size = 8>
+struct Derived : Base {
+    std::array<char, Size> payload{};
+    int                    value() const override { return N; }
+};
+
+#if BEMAN_INDIRECT_USE_LIVE_OBJECT_REGISTRY
+
+TEST(LiveObjectsTest, CountsConstructionAndDestruction) {
+    using D = Derived<1>;
+    EXPECT_EQ(live_objects_of<D>().objects, 0u);
+    {
+        polymorphic<Base> a(std::in_place_type<D>);
+        EXPECT_EQ(live_objects_of<D>().objects, 1u);
+        const std::size_t block = live_objects_of<D>().bytes;
+        EXPECT_GE(block, sizeof(D));
+
+        polymorphic<Base> b(a);
+        EXPECT_EQ(live_objects_of<D>().objects, 2u);
+        EXPECT_EQ(live_objects_of<D>().bytes, 2 * block);
+    }
+    EXPECT_EQ(live_objects_of<D>().objects, 0u);
+    EXPECT_EQ(live_objects_of<D>().bytes, 0u);
+}
+
+TEST(LiveObjectsTest, MoveTransfersOwnership) {
+    using D = Derived<2>;
+    polymorphic<Base> a(std::in_place_type<D>);
+    polymorphic<Base> b(std::move(a));
+    EXPECT_EQ(live_objects_of<D>().objects, 1u);
+}
+
+TEST(LiveObjectsTest, AssignmentReplacesType) {
+    using D = Derived<3>;
+    using E = Derived<4, 16>;
+    polymorphic<Base> a(std::in_place_type<D>);
+    polymorphic<Base> b(std::in_place_type<E>);
+    a = b;
+    EXPECT_EQ(live_objects_of<D>().objects, 0u);
+    EXPECT_EQ(live_objects_of<E>().objects, 2u);
+    a.emplace<D>();
+    EXPECT_EQ(live_objects_of<D>().objects, 1u);
+    EXPECT_EQ(live_objects_of<E>().objects, 1u);
+}
+
+TEST(LiveObjectsTest, CountsAcrossAllocators) {
+    using D = Derived<5>;
+    std::pmr::unsynchronized_pool_resource resource;
+    beman::indirect::pmr::polymorphic<Base> a(std::allocator_arg, &resource, std::in_place_type<D>);
+    polymorphic<Base>                       b(std::in_place_type<D>);
+    EXPECT_EQ(live_objects_of<D>().objects, 2u);
+}
+
+TEST(LiveObjectsTest, SnapshotListsTypes) {
+    using D = Derived<6>;
+    polymorphic<Base> a(std::in_place_type<D>);
+
+    const auto snapshot = live_objects_snapshot();
+    const auto is_d     = [](const auto& s) { return s.type == polymorphic_type_id::of<D>(); };
+    const auto it       = std::find_if(snapshot.begin(), snapshot.end(), is_d);
+    ASSERT_NE(it, snapshot.end());
+    EXPECT_EQ(it->type, a.type_id());
+    EXPECT_EQ(it->objects, 1u);
+    EXPECT_NE(it->name.find("Derived<6"), std::string_view::npos) << it->name;
+}
+
+TEST(LiveObjectsTest, DestroyedOnAnotherThread) {
+    using D = Derived<7>;
+    std::vector<polymorphic<Base>> v;
+    std::thread([&] {
+        for (int i = 0; i < 100; ++i)
+            v.emplace_back(std::in_place_type<D>);
+    }).join();
+    EXPECT_EQ(live_objects_of<D>().objects, 100u);
+    v.clear();
+    EXPECT_EQ(live_objects_of<D>().objects, 0u);
+    EXPECT_EQ(live_objects_of<D>().bytes, 0u);
+}
+
+#else
+
+TEST(LiveObjectsTest, DisabledCountsNothing) {
+    using D = Derived<1>;
+    polymorphic<Base> a(std::in_place_type<D>);
+    EXPECT_EQ(live_objects_of<D>().objects, 0u);
+}
+
+#endif // BEMAN_INDIRECT_USE_LIVE_OBJECT_REGISTRY
+
+} // namespace
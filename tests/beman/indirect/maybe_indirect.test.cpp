@@ -0,0 +1,206 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <beman/indirect/maybe_indirect.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using beman::indirect::indirect;
+using beman::indirect::maybe_indirect;
+
+// A recursive type: the member's type is incomplete where it is declared.
+struct Node {
+    int                                 value;
+    std::optional<maybe_indirect<Node>> next;
+};
+
+// Small, but its move constructor may throw.
+struct ThrowingMove {
+    int v = 0;
+    ThrowingMove() = default;
+    explicit ThrowingMove(int x) : v(x) {}
+    ThrowingMove(const ThrowingMove&) = default;
+    ThrowingMove(ThrowingMove&& other) noexcept(false) : v(other.v) {}
+};
+
+// Throws from its constructor on request.
+struct Fragile {
+    int v;
+    explicit Fragile(int x) : v(x) {
+        if (x < 0)
+            throw std::runtime_error("negative");
+    }
+};
+
+static_assert(maybe_indirect<int>::stored_inline);
+static_assert(maybe_indirect<double>::stored_inline);
+static_assert(sizeof(maybe_indirect<std::int32_t>) == sizeof(std::int32_t));
+static_assert(!maybe_indirect<std::string>::stored_inline);
+static_assert(sizeof(maybe_indirect<std::string>) == sizeof(indirect<std::string>));
+static_assert(maybe_indirect<std::string, sizeof(std::string)>::stored_inline);
+static_assert(!maybe_indirect<Node>::stored_inline);
+static_assert(!maybe_indirect<ThrowingMove>::stored_inline);
+static_assert(beman::indirect::is_trivially_relocatable_v<maybe_indirect<int>>);
+static_assert(beman::indirect::is_trivially_relocatable_v<maybe_indirect<std::string>>);
+static_assert(beman::indirect::is_arena_discardable_v<maybe_indirect<int>>);
+static_assert(std::is_nothrow_move_constructible_v<maybe_indirect<int>>);
+static_assert(std::is_nothrow_move_constructible_v<maybe_indirect<std::string>>);
+static_assert(!std::is_convertible_v<int, maybe_indirect<int>>);
+
+// --- Construction ---
+
+TEST(MaybeIndirectTest, DefaultConstructsValue) {
+    maybe_indirect<int> a;
+    EXPECT_EQ(*a, 0);
+    maybe_indirect<std::string> b;
+    EXPECT_EQ(*b, "");
+    EXPECT_FALSE(b.valueless_after_move());
+}
+
+TEST(MaybeIndirectTest, InlineConstruction) {
+    maybe_indirect<int> a(42);
+    EXPECT_EQ(*a, 42);
+    EXPECT_EQ(static_cast<const void*>(a.operator->()), static_cast<const void*>(&a));
+
+    maybe_indirect<std::pair<int, int>> b(std::in_place, 1, 2);
+    EXPECT_EQ(b->second, 2);
+}
+
+TEST(MaybeIndirectTest, BoxedConstruction) {
+    maybe_indirect<std::string> a(std::in_place, 3u, 'x');
+    EXPECT_EQ(*a, "xxx");
+    EXPECT_NE(static_cast<const void*>(a.operator->()), static_cast<const void*>(&a));
+
+    maybe_indirect<std::vector<int>> b(std::in_place, {1, 2, 3});
+    EXPECT_EQ(b->size(), 3u);
+}
+
+TEST(MaybeIndirectTest, DeductionGuide) {
+    maybe_indirect a(7);
+    static_assert(std::is_same_v<decltype(a), maybe_indirect<int>>);
+    EXPECT_EQ(*a, 7);
+}
+
+// --- Copy, move and assignment ---
+
+TEST(MaybeIndirectTest, CopyIsDeep) {
+    maybe_indirect<std::string> a(std::string("hello"));
+    maybe_indirect<std::string> b = a;
+    *b += " world";
+    EXPECT_EQ(*a, "hello");
+    EXPECT_EQ(*b, "hello world");
+
+    a = b;
+    EXPECT_EQ(*a, "hello world");
+    EXPECT_NE(a.operator->(), b.operator->());
+}
+
+TEST(MaybeIndirectTest, MoveFromBoxedLeavesValueless) {
+    maybe_indirect<std::string> a(std::string("hello"));
+    maybe_indirect<std::string> b = std::move(a);
+    EXPECT_TRUE(a.valueless_after_move());
+    EXPECT_EQ(*b, "hello");
+}
+
+TEST(MaybeIndirectTest, MoveFromInlineKeepsValue) {
+    maybe_indirect<int> a(5);
+    maybe_indirect<int> b = std::move(a);
+    EXPECT_FALSE(a.valueless_after_move());
+    EXPECT_EQ(*b, 5);
+}
+
+TEST(MaybeIndirectTest, AssignFromValue) {
+    maybe_indirect<int> a(1);
+    a = 2;
+    EXPECT_EQ(*a, 2);
+
+    maybe_indirect<std::string> b(std::string("a"));
+    b = "b";
+    EXPECT_EQ(*b, "b");
+}
+
+TEST(MaybeIndirectTest, Emplace) {
+    maybe_indirect<std::pair<int, int>> a;
+    EXPECT_EQ(a.emplace(3, 4).first, 3);
+    EXPECT_EQ(a->second, 4);
+
+    maybe_indirect<std::vector<int>> b;
+    b.emplace({5, 6});
+    EXPECT_EQ(b->size(), 2u);
+}
+
+TEST(MaybeIndirectTest, FailedInlineEmplaceKeepsValue) {
+    static_assert(maybe_indirect<Fragile>::stored_inline);
+    maybe_indirect<Fragile> a(std::in_place, 1);
+    EXPECT_THROW(a.emplace(-1), std::runtime_error);
+    EXPECT_EQ(a->v, 1);
+}
+
+TEST(MaybeIndirectTest, Swap) {
+    maybe_indirect<int> a(1);
+    maybe_indirect<int> b(2);
+    swap(a, b);
+    EXPECT_EQ(*a, 2);
+    EXPECT_EQ(*b, 1);
+
+    maybe_indirect<std::string> c(std::string("c"));
+    maybe_indirect<std::string> d(std::string("d"));
+    c.swap(d);
+    EXPECT_EQ(*c, "d");
+    EXPECT_EQ(*d, "c");
+}
+
+// --- Comparison and hashing ---
+
+TEST(MaybeIndirectTest, Comparison) {
+    maybe_indirect<int> one(1);
+    maybe_indirect<int> two(2);
+    EXPECT_TRUE(one == maybe_indirect<int>(1));
+    EXPECT_TRUE(one != two);
+    EXPECT_TRUE(one < two);
+    EXPECT_TRUE(two >= one);
+    EXPECT_TRUE(one == 1);
+    EXPECT_TRUE(1 == one);
+    EXPECT_TRUE(one < 2);
+    EXPECT_TRUE(0 < one);
+
+    maybe_indirect<std::string> a(std::string("a"));
+    maybe_indirect<std::string> b(std::string("b"));
+    EXPECT_TRUE(a < b);
+    EXPECT_TRUE(a == std::string("a"));
+
+    maybe_indirect<std::string> moved = std::move(b);
+    EXPECT_TRUE(b < a);
+    EXPECT_FALSE(b == std::string(""));
+}
+
+TEST(MaybeIndirectTest, Hash) {
+    EXPECT_EQ(std::hash<maybe_indirect<int>>{}(maybe_indirect<int>(3)), std::hash<int>{}(3));
+    maybe_indirect<std::string> a(std::string("x"));
+    EXPECT_EQ(std::hash<maybe_indirect<std::string>>{}(a), std::hash<std::string>{}("x"));
+    maybe_indirect<std::string> b = std::move(a);
+    EXPECT_EQ(std::hash<maybe_indirect<std::string>>{}(a), static_cast<std::size_t>(-1));
+}
+
+// --- Recursion ---
+
+TEST(MaybeIndirectTest, RecursiveType) {
+    Node root{1, maybe_indirect<Node>(Node{2, std::nullopt})};
+    Node copy = root;
+    (*copy.next)->value = 3;
+    EXPECT_EQ((*root.next)->value, 2);
+    EXPECT_EQ((*copy.next)->value, 3);
+    EXPECT_FALSE((*root.next)->next.has_value());
+}
+
+} // namespace
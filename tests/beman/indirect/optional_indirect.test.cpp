@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <beman/indirect/optional_indirect.hpp>
+
+#include <beman/indirect/counting_allocator.hpp>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using beman::indirect::counting_resource;
+using beman::indirect::indirect;
+using beman::indirect::optional_indirect;
+
+static_assert(sizeof(optional_indirect<int>) == sizeof(indirect<int>));
+static_assert(sizeof(optional_indirect<int>) < sizeof(std::optional<indirect<int>>));
+static_assert(sizeof(beman::indirect::pmr::optional_indirect<int>) == sizeof(beman::indirect::pmr::indirect<int>));
+static_assert(beman::indirect::is_trivially_relocatable_v<optional_indirect<std::string>>);
+static_assert(std::is_nothrow_default_constructible_v<optional_indirect<std::string>>);
+
+// --- Construction ---
+
+TEST(OptionalIndirectTest, EmptyByDefault) {
+    optional_indirect<int> a;
+    EXPECT_FALSE(a.has_value());
+    EXPECT_FALSE(a);
+    EXPECT_TRUE(a == std::nullopt);
+
+    optional_indirect<int> b = std::nullopt;
+    EXPECT_FALSE(b.has_value());
+}
+
+TEST(OptionalIndirectTest, EmptyDoesNotAllocate) {
+    counting_resource<> resource;
+    {
+        beman::indirect::pmr::optional_indirect<std::string> a(std::allocator_arg, &resource);
+        auto                                                 b = a;
+        auto                                                 c = std::move(a);
+        EXPECT_FALSE(b.has_value());
+        EXPECT_FALSE(c.has_value());
+        EXPECT_EQ(a.get_allocator().resource(), &resource);
+    }
+    EXPECT_EQ(resource.stats().allocations(), 0u);
+}
+
+TEST(OptionalIndirectTest, EngagedConstruction) {
+    optional_indirect<int> a(42);
+    EXPECT_TRUE(a.has_value());
+    EXPECT_EQ(*a, 42);
+
+    optional_indirect<std::vector<int>> b(std::in_place, {1, 2, 3});
+    EXPECT_EQ(b->size(), 3u);
+
+    optional_indirect<std::string> c(std::in_place, 3u, 'x');
+    EXPECT_EQ(*c, "xxx");
+
+    optional_indirect d(std::string("deduced"));
+    static_assert(std::is_same_v<decltype(d), optional_indirect<std::string>>);
+}
+
+TEST(OptionalIndirectTest, FromIndirect) {
+    indirect<int>          i(7);
+    const int*             p = i.operator->();
+    optional_indirect<int> a(std::move(i));
+    EXPECT_EQ(a.operator->(), p);
+    EXPECT_TRUE(i.valueless_after_move());
+
+    indirect<int> back = std::move(a).as_indirect();
+    EXPECT_EQ(back.operator->(), p);
+    EXPECT_FALSE(a.has_value());
+}
+
+// --- Copy, move and assignment ---
+
+TEST(OptionalIndirectTest, CopyIsDeep) {
+    optional_indirect<std::string> a(std::string("value"));
+    optional_indirect<std::string> b(a);
+    EXPECT_EQ(*b, "value");
+    EXPECT_NE(a.operator->(), b.operator->());
+
+    optional_indirect<std::string> empty;
+    b = empty;
+    EXPECT_FALSE(b.has_value());
+    b = a;
+    EXPECT_EQ(*b, "value");
+}
+
+TEST(OptionalIndirectTest, MoveLeavesSourceEmpty) {
+    optional_indirect<int> a(1);
+    optional_indirect<int> b(std::move(a));
+    EXPECT_FALSE(a.has_value());
+    EXPECT_EQ(*b, 1);
+}
+
+TEST(OptionalIndirectTest, AssignValueAndNullopt) {
+    counting_resource<>                          resource;
+    beman::indirect::pmr::optional_indirect<int> a(std::allocator_arg, &resource);
+    a = 3;
+    EXPECT_EQ(*a, 3);
+    EXPECT_EQ(resource.stats().allocations(), 1u);
+
+    // Assigning to an engaged handle reuses its allocation.
+    a = 4;
+    EXPECT_EQ(*a, 4);
+    EXPECT_EQ(resource.stats().allocations(), 1u);
+
+    a = std::nullopt;
+    EXPECT_FALSE(a);
+    EXPECT_EQ(resource.stats().bytes_live(), 0u);
+    EXPECT_EQ(a.get_allocator().resource(), &resource);
+}
+
+TEST(OptionalIndirectTest, EmplaceAndReset) {
+    optional_indirect<std::string> a;
+    EXPECT_EQ(a.emplace(2u, 'y'), "yy");
+    EXPECT_TRUE(a.has_value());
+    a.reset();
+    EXPECT_FALSE(a.has_value());
+    a.reset();
+    EXPECT_FALSE(a.has_value());
+}
+
+// --- Observers ---
+
+TEST(OptionalIndirectTest, ValueAndValueOr) {
+    optional_indirect<int> a;
+    EXPECT_THROW((void)a.value(), std::bad_optional_access);
+    EXPECT_EQ(a.value_or(5), 5);
+
+    a = 6;
+    EXPECT_EQ(a.value(), 6);
+    EXPECT_EQ(a.value_or(5), 6);
+    EXPECT_EQ(std::move(a).value_or(5), 6);
+}
+
+// --- Comparison, hashing and swap ---
+
+TEST(OptionalIndirectTest, Comparison) {
+    optional_indirect<int> empty;
+    optional_indirect<int> one(1);
+    optional_indirect<int> two(2);
+    EXPECT_TRUE(empty == optional_indirect<int>());
+    EXPECT_TRUE(empty < one);
+    EXPECT_TRUE(one < two);
+    EXPECT_TRUE(one != two);
+    EXPECT_TRUE(one == 1);
+    EXPECT_FALSE(empty == 0);
+    EXPECT_TRUE(std::nullopt == empty);
+    EXPECT_TRUE(one != std::nullopt);
+}
+
+TEST(OptionalIndirectTest, Hash) {
+    std::unordered_set<optional_indirect<std::string>> set;
+    set.insert(optional_indirect<std::string>(std::string("a")));
+    set.insert(optional_indirect<std::string>());
+    EXPECT_EQ(set.count(optional_indirect<std::string>(std::string("a"))), 1u);
+    EXPECT_EQ(set.count(optional_indirect<std::string>()), 1u);
+}
+
+TEST(OptionalIndirectTest, Swap) {
+    optional_indirect<int> a(1);
+    optional_indirect<int> b;
+    swap(a, b);
+    EXPECT_FALSE(a.has_value());
+    EXPECT_EQ(*b, 1);
+}
+
+#if __cplusplus >= 202002L && BEMAN_INDIRECT_USE_CONSTEXPR_DESTRUCTOR
+static_assert([] {
+    optional_indirect<int> a;
+    if (a.has_value())
+        return false;
+    a = 3;
+    optional_indirect<int> b(a);
+    a.reset();
+    return *b == 3 && !a.has_value();
+}());
+#endif
+
+} // namespace
@@ -148,6 +148,14 @@ TEST(PolymorphicTest, MoveConstruction) {
     EXPECT_TRUE(p.valueless_after_move());
 }
 
+TEST(PolymorphicTest, MoveConstructionKeepsObjectAddress) {
+    polymorphic<Base> p(Derived(42));
+    const Base*       addr = &*p;
+    polymorphic<Base> q(std::move(p));
+    EXPECT_EQ(&*q, addr);
+    EXPECT_EQ(q.operator->(), addr);
+}
+
 TEST(PolymorphicTest, CopyAssignment) {
     polymorphic<Base> p(Derived(42));
     polymorphic<Base> q(Derived2("hello"));
@@ -157,6 +165,42 @@ TEST(PolymorphicTest, CopyAssignment) {
     EXPECT_EQ((*p).value(), 42); // original unaffected
 }
 
+TEST(PolymorphicTest, CopyAssignmentSameTypeKeepsObjectAddress) {
+    polymorphic<Base> p(Derived(42));
+    polymorphic<Base> q(Derived(7));
+    const Base*       addr = &*q;
+    q                      = p;
+    EXPECT_EQ(&*q, addr);
+    EXPECT_EQ((*q).value(), 42);
+    EXPECT_NE(&*p, &*q);
+}
+
+TEST(PolymorphicTest, CopyAssignmentSameTypeThrowingCopyAssign) {
+    // std::string copy-assignment may throw, so the value is copied into a
+    // temporary and moved into the existing object.
+    polymorphic<Base> p(Derived2("source"));
+    polymorphic<Base> q(Derived2("target"));
+    const Base*       addr = &*q;
+    q                      = p;
+    EXPECT_EQ(&*q, addr);
+    EXPECT_EQ((*q).name(), "Derived2:source");
+}
+
+struct DerivedThrowsOnCopy : Base {
+    test::ThrowsOnCopy t_;
+    explicit DerivedThrowsOnCopy(int x) : t_(x) {}
+    int         value() const override { return t_.value; }
+    std::string name() const override { return "DerivedThrowsOnCopy"; }
+};
+
+TEST(PolymorphicTest, CopyAssignmentSameTypeStrongGuarantee) {
+    polymorphic<Base> p(std::in_place_type<DerivedThrowsOnCopy>, 42);
+    polymorphic<Base> q(std::in_place_type<DerivedThrowsOnCopy>, 7);
+    EXPECT_THROW(q = p, test::ThrowsOnCopy::Exception);
+    EXPECT_EQ((*q).value(), 7);
+    EXPECT_EQ((*p).value(), 42);
+}
+
 TEST(PolymorphicTest, MoveAssignment) {
     polymorphic<Base> p(Derived(42));
     polymorphic<Base> q(Derived2("hello"));
@@ -528,9 +572,33 @@ TEST(PolymorphicTest, CountAllocationsForCopyAssignment) {
         polymorphic<AllocBase, test::TrackingAllocator<AllocBase>> q(std::allocator_arg, alloc, AllocDerived(0));
         EXPECT_EQ(alloc_counter, 2u);
         q = p;
-        // Copy assignment: clone new + destroy old
+        // Copy assignment between equal dynamic types reuses q's block
+        EXPECT_EQ(alloc_counter, 2u);
+        EXPECT_EQ(dealloc_counter, 0u);
+        EXPECT_EQ((*q).val(), 42);
+    }
+    EXPECT_EQ(dealloc_counter, 2u);
+}
+
+struct AllocDerived2 : AllocBase {
+    long y_;
+    explicit AllocDerived2(long y = 0) : y_(y) {}
+    int val() const override { return static_cast<int>(y_); }
+};
+
+TEST(PolymorphicTest, CountAllocationsForCopyAssignmentOfDifferentType) {
+    unsigned alloc_counter   = 0;
+    unsigned dealloc_counter = 0;
+    {
+        test::TrackingAllocator<AllocBase>                         alloc(&alloc_counter, &dealloc_counter);
+        polymorphic<AllocBase, test::TrackingAllocator<AllocBase>> p(std::allocator_arg, alloc, AllocDerived(42));
+        polymorphic<AllocBase, test::TrackingAllocator<AllocBase>> q(std::allocator_arg, alloc, AllocDerived2(0));
+        EXPECT_EQ(alloc_counter, 2u);
+        q = p;
+        // Copy assignment between different dynamic types: clone new + destroy old
         EXPECT_EQ(alloc_counter, 3u);
         EXPECT_EQ(dealloc_counter, 1u);
+        EXPECT_EQ((*q).val(), 42);
     }
     EXPECT_EQ(dealloc_counter, 3u);
 }
@@ -553,6 +621,158 @@ TEST(PolymorphicTest, CountAllocationsForMoveAssignment) {
 
 // --- Non-equal allocator tests ---
 
+// --- Emplace ---
+
+TEST(PolymorphicTest, EmplaceSameLayoutReusesBlock) {
+    polymorphic<Base> p(Derived(1));
+    const Base*       addr = &*p;
+    Derived&          d    = p.emplace<Derived>(5);
+    EXPECT_EQ(&d, addr);
+    EXPECT_EQ(&*p, addr);
+    EXPECT_EQ((*p).value(), 5);
+}
+
+TEST(PolymorphicTest, EmplaceChangesDynamicType) {
+    polymorphic<Base> p(Derived(1));
+    p.emplace<Derived2>("hello");
+    EXPECT_EQ((*p).name(), "Derived2:hello");
+    polymorphic<Base> q(p);
+    EXPECT_EQ((*q).name(), "Derived2:hello");
+}
+
+TEST(PolymorphicTest, EmplaceInitializerList) {
+    polymorphic<SimpleBase> p(SimpleDerived(1));
+    p.emplace<WithInitList>({1, 2, 3}, 4);
+    EXPECT_EQ((*p).value(), 4);
+}
+
+TEST(PolymorphicTest, EmplaceIntoValueless) {
+    polymorphic<Base> p(Derived(1));
+    polymorphic<Base> q(std::move(p));
+    EXPECT_TRUE(p.valueless_after_move());
+    p.emplace<Derived>(42);
+    EXPECT_FALSE(p.valueless_after_move());
+    EXPECT_EQ((*p).value(), 42);
+}
+
+struct AllocDerivedLarge : AllocBase {
+    long data_[8] = {};
+    explicit AllocDerivedLarge(long x = 0) { data_[0] = x; }
+    int val() const override { return static_cast<int>(data_[0]); }
+};
+
+TEST(PolymorphicTest, CountAllocationsForEmplaceSameLayout) {
+    unsigned alloc_counter   = 0;
+    unsigned dealloc_counter = 0;
+    {
+        test::TrackingAllocator<AllocBase>                         alloc(&alloc_counter, &dealloc_counter);
+        polymorphic<AllocBase, test::TrackingAllocator<AllocBase>> p(std::allocator_arg, alloc, AllocDerived(1));
+        static_assert(sizeof(AllocDerived2) == sizeof(AllocDerived));
+        p.emplace<AllocDerived2>(7);
+        // Same block layout: the allocation is reused
+        EXPECT_EQ(alloc_counter, 1u);
+        EXPECT_EQ(dealloc_counter, 0u);
+        EXPECT_EQ((*p).val(), 7);
+    }
+    EXPECT_EQ(dealloc_counter, 1u);
+}
+
+TEST(PolymorphicTest, CountAllocationsForEmplaceDifferentLayout) {
+    unsigned alloc_counter   = 0;
+    unsigned dealloc_counter = 0;
+    {
+        test::TrackingAllocator<AllocBase>                         alloc(&alloc_counter, &dealloc_counter);
+        polymorphic<AllocBase, test::TrackingAllocator<AllocBase>> p(std::allocator_arg, alloc, AllocDerived(1));
+        p.emplace<AllocDerivedLarge>(7);
+        // Larger block: allocate new + destroy old
+        EXPECT_EQ(alloc_counter, 2u);
+        EXPECT_EQ(dealloc_counter, 1u);
+        EXPECT_EQ((*p).val(), 7);
+    }
+    EXPECT_EQ(dealloc_counter, 2u);
+}
+
+struct DerivedThrowsOnConstruction : Base {
+    test::ThrowsOnConstruction t_;
+    int                        value() const override { return 0; }
+    std::string                name() const override { return "DerivedThrowsOnConstruction"; }
+};
+
+struct LargeDerivedThrowsOnConstruction : DerivedThrowsOnConstruction {
+    long pad_[8] = {};
+};
+
+TEST(PolymorphicTest, EmplaceExceptionWithReusedBlockLeavesValueless) {
+    polymorphic<Base> p(Derived(1));
+    static_assert(sizeof(DerivedThrowsOnConstruction) == sizeof(Derived));
+    EXPECT_THROW(p.emplace<DerivedThrowsOnConstruction>(), test::ThrowsOnConstruction::Exception);
+    EXPECT_TRUE(p.valueless_after_move());
+}
+
+TEST(PolymorphicTest, EmplaceExceptionWithNewBlockIsStrong) {
+    polymorphic<Base> p(Derived(1));
+    EXPECT_THROW(p.emplace<LargeDerivedThrowsOnConstruction>(), test::ThrowsOnConstruction::Exception);
+    ASSERT_FALSE(p.valueless_after_move());
+    EXPECT_EQ((*p).value(), 1);
+}
+
+// --- Dynamic type queries ---
+
+struct MoreDerived : Derived {
+    explicit MoreDerived(int x = 0) : Derived(x) {}
+    std::string name() const override { return "MoreDerived"; }
+};
+
+TEST(PolymorphicTest, TypeIdNamesDynamicType) {
+    using beman::indirect::polymorphic_type_id;
+    polymorphic<Base> p(Derived(1));
+    polymorphic<Base> q(std::in_place_type<Derived2>, "x");
+    polymorphic<Base> r(p);
+    EXPECT_EQ(p.type_id(), polymorphic_type_id::of<Derived>());
+    EXPECT_EQ(q.type_id(), polymorphic_type_id::of<Derived2>());
+    EXPECT_EQ(p.type_id(), r.type_id());
+    EXPECT_NE(p.type_id(), q.type_id());
+
+    q.emplace<Derived>(2);
+    EXPECT_EQ(q.type_id(), p.type_id());
+
+    polymorphic<Base> s(std::move(p));
+    EXPECT_EQ(p.type_id(), polymorphic_type_id());
+    EXPECT_EQ(s.type_id(), polymorphic_type_id::of<Derived>());
+}
+
+TEST(PolymorphicTest, TypeIdAsMapKey) {
+    using beman::indirect::polymorphic_type_id;
+    std::unordered_map<polymorphic_type_id, std::string> names{{polymorphic_type_id::of<Derived>(), "Derived"},
+                                                               {polymorphic_type_id::of<Derived2>(), "Derived2"}};
+    polymorphic<Base> p(std::in_place_type<Derived2>, "x");
+    EXPECT_EQ(names.at(p.type_id()), "Derived2");
+}
+
+TEST(PolymorphicTest, HoldsMatchesExactType) {
+    polymorphic<Base> p(MoreDerived(3));
+    EXPECT_TRUE(p.holds<MoreDerived>());
+    EXPECT_FALSE(p.holds<Derived>());
+    EXPECT_FALSE(p.holds<Derived2>());
+
+    polymorphic<Base> q(std::move(p));
+    EXPECT_FALSE(p.holds<MoreDerived>());
+}
+
+TEST(PolymorphicTest, GetIf) {
+    polymorphic<Base> p(Derived(4));
+    Derived*          d = p.get_if<Derived>();
+    ASSERT_NE(d, nullptr);
+    EXPECT_EQ(d, &*p);
+    d->x_ = 5;
+    EXPECT_EQ((*p).value(), 5);
+    EXPECT_EQ(p.get_if<Derived2>(), nullptr);
+
+    const polymorphic<Base>& cp = p;
+    EXPECT_EQ(cp.get_if<Derived>(), d);
+    EXPECT_EQ(cp.get_if<MoreDerived>(), nullptr);
+}
+
 TEST(PolymorphicTest, MoveConstructionWithNonEqualAllocator) {
     unsigned alloc_counter1   = 0;
     unsigned dealloc_counter1 = 0;
@@ -828,6 +1048,13 @@ static_assert([] {
     return p.valueless_after_move() && (*q).value() == 1;
 }());
 
+// Dynamic type queries
+static_assert([] {
+    polymorphic<cx::Base> p(std::in_place_type<cx::Derived>, 8);
+    return p.holds<cx::Derived>() && p.get_if<cx::Derived>()->x_ == 8 &&
+           p.type_id() == beman::indirect::polymorphic_type_id::of<cx::Derived>();
+}());
+
 // swap
 static_assert([] {
     polymorphic<cx::Base> p(std::in_place_type<cx::Derived>, 1);
@@ -923,4 +1150,43 @@ static_assert([] {
 
 #endif // constexpr tests
 
+// Control blocks dispatch through a table of function pointers rather than
+// virtual functions, so types without virtual members are usable in constant
+// expressions wherever constexpr destructors are.
+
+#if __cplusplus >= 202002L && BEMAN_INDIRECT_USE_CONSTEXPR_DESTRUCTOR
+
+namespace cx_plain {
+
+struct Point {
+    int x;
+    int y;
+};
+
+} // namespace cx_plain
+
+static_assert([] {
+    polymorphic<cx_plain::Point> p(cx_plain::Point{1, 2});
+    polymorphic<cx_plain::Point> q(p);
+    polymorphic<cx_plain::Point> r(std::move(p));
+    return q->x == 1 && r->y == 2 && p.valueless_after_move();
+}());
+
+// Same-type copy assignment and emplace reuse the existing block.
+static_assert([] {
+    polymorphic<cx_plain::Point> p(cx_plain::Point{1, 2});
+    polymorphic<cx_plain::Point> q(cx_plain::Point{3, 4});
+    q = p;
+    q.emplace<cx_plain::Point>(cx_plain::Point{5, 6});
+    return q->x == 5 && p->x == 1;
+}());
+
+static_assert([] {
+    polymorphic<cx_plain::Point> p(cx_plain::Point{1, 2});
+    return p.holds<cx_plain::Point>() && p.get_if<cx_plain::Point>()->y == 2 &&
+           p.type_id() == beman::indirect::polymorphic_type_id::of<cx_plain::Point>();
+}());
+
+#endif // constexpr tests without virtual functions
+
 } // namespace
@@ -0,0 +1,267 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <beman/indirect/polymorphic_collection.hpp>
+
+#include "test_helpers.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using beman::indirect::polymorphic_collection;
+
+// Test hierarchy
+struct Shape {
+    virtual ~Shape()                 = default;
+    virtual double      area() const = 0;
+    virtual std::string name() const = 0;
+    Shape()                          = default;
+    Shape(const Shape&)              = default;
+    Shape(Shape&&)                   = default;
+    Shape& operator=(const Shape&)   = default;
+    Shape& operator=(Shape&&)        = default;
+};
+
+struct Circle : Shape {
+    double r_;
+    explicit Circle(double r = 1) : r_(r) {}
+    double      area() const override { return 3 * r_ * r_; }
+    std::string name() const override { return "Circle"; }
+};
+
+struct Square final : Shape {
+    double side_;
+    explicit Square(double side = 1) : side_(side) {}
+    double      area() const override { return side_ * side_; }
+    std::string name() const override { return "Square"; }
+};
+
+// Copyable but not assignable, so erasing has to rebuild its segment.
+struct Named : Shape {
+    const std::string name_;
+    explicit Named(std::string name) : name_(std::move(name)) {}
+    double      area() const override { return 0; }
+    std::string name() const override { return name_; }
+};
+
+std::vector<std::string> names(const polymorphic_collection<Shape>& c) {
+    std::vector<std::string> result;
+    c.for_each([&](const Shape& s) { result.push_back(s.name()); });
+    return result;
+}
+
+// --- Insertion and iteration ---
+
+TEST(PolymorphicCollectionTest, DefaultIsEmpty) {
+    polymorphic_collection<Shape> c;
+    EXPECT_TRUE(c.empty());
+    EXPECT_EQ(c.size(), 0u);
+    EXPECT_EQ(c.size<Circle>(), 0u);
+    c.for_each([](Shape&) { ADD_FAILURE(); });
+}
+
+TEST(PolymorphicCollectionTest, IterationGroupsByType) {
+    polymorphic_collection<Shape> c;
+    c.insert(Circle(1));
+    c.insert(Square(2));
+    c.emplace<Circle>(3);
+    c.insert(Square(4));
+
+    EXPECT_EQ(c.size(), 4u);
+    EXPECT_EQ(c.size<Circle>(), 2u);
+    EXPECT_EQ(c.size<Square>(), 2u);
+    EXPECT_EQ(names(c), (std::vector<std::string>{"Circle", "Circle", "Square", "Square"}));
+
+    std::vector<double> areas;
+    c.for_each([&](const Shape& s) { areas.push_back(s.area()); });
+    EXPECT_EQ(areas, (std::vector<double>{3, 27, 4, 16}));
+}
+
+TEST(PolymorphicCollectionTest, SegmentIsContiguous) {
+    polymorphic_collection<Shape> c;
+    for (int i = 0; i < 100; ++i) {
+        c.emplace<Circle>(i);
+        c.emplace<Square>(i);
+    }
+    const Circle* prev = nullptr;
+    c.for_each<Circle>([&](const Circle& circle) {
+        if (prev) {
+            EXPECT_EQ(&circle, prev + 1);
+        }
+        prev = &circle;
+    });
+}
+
+TEST(PolymorphicCollectionTest, ForEachMutates) {
+    polymorphic_collection<Shape> c;
+    c.emplace<Circle>(1);
+    c.emplace<Square>(1);
+    c.for_each<Square>([](Square& s) { s.side_ = 5; });
+    double total = 0;
+    c.for_each([&](Shape& s) { total += s.area(); });
+    EXPECT_EQ(total, 3 + 25);
+}
+
+TEST(PolymorphicCollectionTest, ForEachOfAbsentType) {
+    polymorphic_collection<Shape> c;
+    c.emplace<Circle>(1);
+    int calls = 0;
+    c.for_each<Square>([&](const Square&) { ++calls; });
+    EXPECT_EQ(calls, 0);
+}
+
+// --- Erase ---
+
+TEST(PolymorphicCollectionTest, EraseIfAcrossSegments) {
+    polymorphic_collection<Shape> c;
+    for (int i = 1; i <= 4; ++i) {
+        c.emplace<Circle>(i);
+        c.emplace<Square>(i);
+    }
+    EXPECT_EQ(c.erase_if([](const Shape& s) { return s.area() > 10; }), 4u);
+    EXPECT_EQ(c.size<Circle>(), 1u);
+    EXPECT_EQ(c.size<Square>(), 3u);
+
+    std::vector<double> sides;
+    c.for_each<Square>([&](const Square& s) { sides.push_back(s.side_); });
+    EXPECT_EQ(sides, (std::vector<double>{1, 2, 3}));
+}
+
+TEST(PolymorphicCollectionTest, EraseIfOneSegment) {
+    polymorphic_collection<Shape> c;
+    for (int i = 1; i <= 4; ++i) {
+        c.emplace<Circle>(i);
+        c.emplace<Square>(i);
+    }
+    EXPECT_EQ(c.erase_if<Circle>([](const Circle& s) { return s.r_ != 2; }), 3u);
+    EXPECT_EQ(c.size<Circle>(), 1u);
+    EXPECT_EQ(c.size<Square>(), 4u);
+    EXPECT_EQ(c.erase_if<Named>([](const Named&) { return true; }), 0u);
+}
+
+TEST(PolymorphicCollectionTest, EraseNonAssignableType) {
+    polymorphic_collection<Shape> c;
+    c.emplace<Named>("a");
+    c.emplace<Named>("b");
+    c.emplace<Named>("c");
+    EXPECT_EQ(c.erase_if([](const Shape& s) { return s.name() == "b"; }), 1u);
+    EXPECT_EQ(names(c), (std::vector<std::string>{"a", "c"}));
+}
+
+TEST(PolymorphicCollectionTest, Clear) {
+    polymorphic_collection<Shape> c;
+    c.emplace<Circle>(1);
+    c.emplace<Square>(1);
+    c.clear();
+    EXPECT_TRUE(c.empty());
+    c.emplace<Square>(2);
+    EXPECT_EQ(names(c), (std::vector<std::string>{"Square"}));
+}
+
+// --- Copy and move ---
+
+TEST(PolymorphicCollectionTest, CopyIsDeep) {
+    polymorphic_collection<Shape> c;
+    c.emplace<Circle>(1);
+    c.emplace<Square>(2);
+    c.emplace<Named>("n");
+
+    polymorphic_collection<Shape> d(c);
+    c.for_each<Square>([](Square& s) { s.side_ = 10; });
+    EXPECT_EQ(names(d), names(c));
+    d.for_each<Square>([](const Square& s) { EXPECT_EQ(s.side_, 2); });
+}
+
+TEST(PolymorphicCollectionTest, CopyAllocatesOncePerSegment) {
+    using alloc_type         = test::TrackingAllocator<Shape>;
+    unsigned alloc_counter   = 0;
+    unsigned dealloc_counter = 0;
+    polymorphic_collection<Shape, alloc_type> c(std::allocator_arg, alloc_type(&alloc_counter, &dealloc_counter));
+    for (int i = 0; i < 100; ++i) {
+        c.emplace<Circle>(i);
+        c.emplace<Square>(i);
+    }
+    {
+        alloc_counter = 0;
+        polymorphic_collection<Shape, alloc_type> d(c);
+        // One allocation for each segment and one for its elements.
+        EXPECT_EQ(alloc_counter, 4u);
+        EXPECT_EQ(d.size(), 200u);
+        dealloc_counter = 0;
+    }
+    EXPECT_EQ(dealloc_counter, 4u);
+}
+
+TEST(PolymorphicCollectionTest, CopyAssignment) {
+    polymorphic_collection<Shape> c;
+    c.emplace<Circle>(1);
+    polymorphic_collection<Shape> d;
+    d.emplace<Square>(1);
+    d = c;
+    EXPECT_EQ(names(d), (std::vector<std::string>{"Circle"}));
+    d = d;
+    EXPECT_EQ(d.size(), 1u);
+}
+
+TEST(PolymorphicCollectionTest, MoveLeavesSourceEmpty) {
+    polymorphic_collection<Shape> c;
+    c.emplace<Circle>(1);
+    polymorphic_collection<Shape> d(std::move(c));
+    EXPECT_TRUE(c.empty());
+    EXPECT_EQ(d.size(), 1u);
+
+    polymorphic_collection<Shape> e;
+    e.emplace<Square>(1);
+    e = std::move(d);
+    EXPECT_TRUE(d.empty());
+    EXPECT_EQ(names(e), (std::vector<std::string>{"Circle"}));
+}
+
+TEST(PolymorphicCollectionTest, MoveAssignmentWithNonEqualAllocator) {
+    using alloc_type         = test::NonEqualTrackingAllocator<Shape>;
+    unsigned alloc_counter   = 0;
+    unsigned dealloc_counter = 0;
+    polymorphic_collection<Shape, alloc_type> c(std::allocator_arg, alloc_type(&alloc_counter, &dealloc_counter));
+    polymorphic_collection<Shape, alloc_type> d(std::allocator_arg, alloc_type(&alloc_counter, &dealloc_counter));
+    c.emplace<Circle>(1);
+    d = std::move(c);
+    EXPECT_TRUE(c.empty());
+    EXPECT_EQ(d.size<Circle>(), 1u);
+}
+
+TEST(PolymorphicCollectionTest, Swap) {
+    polymorphic_collection<Shape> c;
+    c.emplace<Circle>(1);
+    polymorphic_collection<Shape> d;
+    swap(c, d);
+    EXPECT_TRUE(c.empty());
+    EXPECT_EQ(d.size(), 1u);
+}
+
+// --- PMR ---
+
+TEST(PolymorphicCollectionTest, PmrAllocatesFromResource) {
+    std::array<std::byte, 8192>         buffer{};
+    std::pmr::monotonic_buffer_resource resource(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+
+    beman::indirect::pmr::polymorphic_collection<Shape> c(std::allocator_arg, &resource);
+    for (int i = 0; i < 10; ++i) {
+        c.emplace<Circle>(i);
+        c.emplace<Square>(i);
+    }
+    c.for_each([&](const Shape& s) {
+        const auto* p = reinterpret_cast<const std::byte*>(&s);
+        EXPECT_GE(p, buffer.data());
+        EXPECT_LT(p, buffer.data() + buffer.size());
+    });
+}
+
+} // namespace
@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <beman/indirect/polymorphic_pool_resource.hpp>
+
+#include <beman/indirect/polymorphic.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using beman::indirect::polymorphic_pool_resource;
+namespace pmr = beman::indirect::pmr;
+
+struct Base {
+    virtual ~Base()              = default;
+    virtual int value() const    = 0;
+    Base()                       = default;
+    Base(const Base&)            = default;
+    Base& operator=(const Base&) = default;
+};
+
+template <std::size_t N>
+struct Derived : Base {
+    unsigned char bytes[N] = {};
+    int           x_;
+    explicit Derived(int x) : x_(x) {}
+    int value() const override { return x_; }
+};
+
+struct alignas(64) OverAligned : Base {
+    int value() const override { return -1; }
+};
+
+// Upstream resource that counts what it is asked for.
+class CountingResource : public std::pmr::memory_resource {
+  public:
+    int allocations   = 0;
+    int deallocations = 0;
+
+  protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        ++deallocations;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+// Size class serving the control block of a pmr::polymorphic<Base> holding U.
+template <class U>
+std::size_t size_class_of() {
+    using cb = beman::indirect::detail::direct_control_block<Base, U, std::pmr::polymorphic_allocator<Base>>;
+    return polymorphic_pool_resource::size_class_of(sizeof(cb), alignof(cb));
+}
+
+// --- Size classes ---
+
+TEST(PolymorphicPoolResourceTest, SizeClassOf) {
+    static_assert(polymorphic_pool_resource::size_class_of(0, 8) == 0);
+    static_assert(polymorphic_pool_resource::size_class_of(1, 8) == 0);
+    static_assert(polymorphic_pool_resource::size_class_of(16, 8) == 0);
+    static_assert(polymorphic_pool_resource::size_class_of(17, 8) == 1);
+    static_assert(polymorphic_pool_resource::size_class_of(256, 16) == 15);
+    static_assert(polymorphic_pool_resource::size_class_of(257, 8) == polymorphic_pool_resource::size_classes);
+    static_assert(polymorphic_pool_resource::size_class_of(8, 32) == polymorphic_pool_resource::size_classes);
+}
+
+TEST(PolymorphicPoolResourceTest, BlocksAreAligned) {
+    polymorphic_pool_resource r;
+    for (std::size_t bytes = 1; bytes <= 256; bytes += 7) {
+        void* p = r.allocate(bytes, 16);
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p) % 16, 0u);
+        r.deallocate(p, bytes, 16);
+    }
+}
+
+// --- With pmr::polymorphic ---
+
+// The pools, and so the statistics, are process-wide: tests compare the
+// counts before and after.
+
+TEST(PolymorphicPoolResourceTest, DerivedTypesUseTheirSizeClass) {
+    CountingResource          upstream;
+    polymorphic_pool_resource r(&upstream);
+    const auto                before = polymorphic_pool_resource::stats();
+    {
+        pmr::polymorphic<Base> a(std::allocator_arg, &r, std::in_place_type<Derived<8>>, 1);
+        pmr::polymorphic<Base> b(std::allocator_arg, &r, std::in_place_type<Derived<100>>, 2);
+        pmr::polymorphic<Base> c(std::allocator_arg, &r, std::in_place_type<Derived<200>>, 3);
+        pmr::polymorphic<Base> d(std::allocator_arg, &r, b);
+        EXPECT_EQ(d->value(), 2);
+
+        const auto during = polymorphic_pool_resource::stats();
+        auto       added  = [&](std::size_t cls) { return during[cls].in_use - before[cls].in_use; };
+        EXPECT_EQ(added(size_class_of<Derived<8>>()), 1u);
+        EXPECT_EQ(added(size_class_of<Derived<100>>()), 2u);
+        EXPECT_EQ(added(size_class_of<Derived<200>>()), 1u);
+    }
+    const auto after = polymorphic_pool_resource::stats();
+    for (std::size_t i = 0; i < polymorphic_pool_resource::size_classes; ++i)
+        EXPECT_EQ(after[i].in_use, before[i].in_use);
+    EXPECT_EQ(upstream.allocations, 0);
+}
+
+TEST(PolymorphicPoolResourceTest, LargeAndOverAlignedGoUpstream) {
+    CountingResource          upstream;
+    polymorphic_pool_resource r(&upstream);
+    const auto                before = polymorphic_pool_resource::stats();
+    {
+        pmr::polymorphic<Base> a(std::allocator_arg, &r, std::in_place_type<Derived<1024>>, 1);
+        pmr::polymorphic<Base> b(std::allocator_arg, &r, std::in_place_type<OverAligned>);
+        EXPECT_EQ(upstream.allocations, 2);
+        EXPECT_EQ(b->value(), -1);
+    }
+    EXPECT_EQ(upstream.deallocations, 2);
+    const auto after = polymorphic_pool_resource::stats();
+    for (std::size_t i = 0; i < polymorphic_pool_resource::size_classes; ++i)
+        EXPECT_EQ(after[i].allocations, before[i].allocations);
+}
+
+TEST(PolymorphicPoolResourceTest, AllocationCounts) {
+    polymorphic_pool_resource r;
+    const std::size_t         cls    = polymorphic_pool_resource::size_class_of(48, 16);
+    const auto                before = polymorphic_pool_resource::stats(cls);
+
+    std::vector<void*> ps;
+    for (int i = 0; i < 10; ++i)
+        ps.push_back(r.allocate(48, 16));
+    EXPECT_EQ(polymorphic_pool_resource::stats(cls).in_use, before.in_use + 10);
+    for (void* p : ps)
+        r.deallocate(p, 48, 16);
+
+    const auto after = polymorphic_pool_resource::stats(cls);
+    EXPECT_EQ(after.block_size, 48u);
+    EXPECT_EQ(after.in_use, before.in_use);
+    EXPECT_EQ(after.allocations, before.allocations + 10);
+    EXPECT_EQ(after.deallocations, before.deallocations + 10);
+}
+
+TEST(PolymorphicPoolResourceTest, ConcurrentChurn) {
+    polymorphic_pool_resource r;
+    const auto                before = polymorphic_pool_resource::stats();
+    std::vector<std::thread>  workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&r, t] {
+            std::vector<pmr::polymorphic<Base>> v;
+            for (int round = 0; round < 100; ++round) {
+                for (int i = 0; i < 50; ++i) {
+                    if (i % 3 == 0)
+                        v.emplace_back(std::allocator_arg, &r, std::in_place_type<Derived<8>>, t);
+                    else if (i % 3 == 1)
+                        v.emplace_back(std::allocator_arg, &r, std::in_place_type<Derived<60>>, t);
+                    else
+                        v.emplace_back(std::allocator_arg, &r, std::in_place_type<Derived<180>>, t);
+                }
+                v.clear();
+            }
+        });
+    }
+    for (auto& w : workers)
+        w.join();
+
+    // Exited threads' counts are kept.
+    const auto  after = polymorphic_pool_resource::stats();
+    std::size_t added = 0;
+    for (std::size_t i = 0; i < polymorphic_pool_resource::size_classes; ++i) {
+        EXPECT_EQ(after[i].in_use, before[i].in_use);
+        added += after[i].allocations - before[i].allocations;
+    }
+    EXPECT_EQ(added, 4u * 100u * 50u);
+}
+
+} // namespace
@@ -0,0 +1,197 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <beman/indirect/pool_allocator.hpp>
+
+#include <beman/indirect/indirect.hpp>
+#include <beman/indirect/polymorphic.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using beman::indirect::indirect;
+using beman::indirect::indirect_pool_allocator;
+using beman::indirect::polymorphic;
+
+template <class T>
+using pooled = indirect<T, indirect_pool_allocator<T>>;
+
+// Sized so that no other test shares its pool.
+struct Unique {
+    std::uint64_t words[25];
+};
+
+struct Base {
+    virtual ~Base()              = default;
+    virtual int value() const    = 0;
+    Base()                       = default;
+    Base(const Base&)            = default;
+    Base& operator=(const Base&) = default;
+};
+
+struct Derived : Base {
+    int x_;
+    explicit Derived(int x) : x_(x) {}
+    int value() const override { return x_; }
+};
+
+// --- Allocator ---
+
+TEST(PoolAllocatorTest, AllocatorTraits) {
+    using traits = std::allocator_traits<indirect_pool_allocator<int>>;
+    static_assert(traits::is_always_equal::value);
+    static_assert(traits::propagate_on_container_move_assignment::value);
+    EXPECT_TRUE(indirect_pool_allocator<int>() == indirect_pool_allocator<long>());
+    EXPECT_FALSE(indirect_pool_allocator<int>() != indirect_pool_allocator<long>());
+}
+
+TEST(PoolAllocatorTest, FreedBlockIsReusedFirst) {
+    indirect_pool_allocator<std::string> alloc;
+    std::string*                         p = alloc.allocate(1);
+    alloc.deallocate(p, 1);
+    std::string* q = alloc.allocate(1);
+    EXPECT_EQ(p, q);
+    alloc.deallocate(q, 1);
+}
+
+TEST(PoolAllocatorTest, SameSizeTypesSharePool) {
+    struct A {
+        std::uint64_t v[3];
+    };
+    struct B {
+        char c[24];
+    };
+    static_assert(sizeof(A) == sizeof(B));
+
+    indirect_pool_allocator<A> a;
+    indirect_pool_allocator<B> b;
+    A*                         p = a.allocate(1);
+    a.deallocate(p, 1);
+    EXPECT_EQ(static_cast<void*>(b.allocate(1)), static_cast<void*>(p));
+    b.deallocate(reinterpret_cast<B*>(p), 1);
+}
+
+TEST(PoolAllocatorTest, ArrayAllocationBypassesPool) {
+    indirect_pool_allocator<int> alloc;
+    int*                         p = alloc.allocate(16);
+    for (int i = 0; i < 16; ++i)
+        p[i] = i;
+    alloc.deallocate(p, 16);
+}
+
+TEST(PoolAllocatorTest, BlocksAreAligned) {
+    struct alignas(64) Wide {
+        char c;
+    };
+    indirect_pool_allocator<Wide> alloc;
+    std::vector<Wide*>            ps;
+    for (int i = 0; i < 100; ++i) {
+        ps.push_back(alloc.allocate(1));
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(ps.back()) % 64, 0u);
+    }
+    for (Wide* p : ps)
+        alloc.deallocate(p, 1);
+}
+
+// --- With indirect and polymorphic ---
+
+TEST(PoolAllocatorTest, Indirect) {
+    pooled<std::string> a(std::string("hello"));
+    pooled<std::string> b(a);
+    pooled<std::string> c(std::move(a));
+    EXPECT_EQ(*b, "hello");
+    EXPECT_EQ(*c, "hello");
+    EXPECT_TRUE(a.valueless_after_move());
+    b = c;
+    EXPECT_EQ(*b, "hello");
+}
+
+TEST(PoolAllocatorTest, Polymorphic) {
+    polymorphic<Base, indirect_pool_allocator<Base>> p(std::in_place_type<Derived>, 42);
+    polymorphic<Base, indirect_pool_allocator<Base>> q(p);
+    EXPECT_EQ(q->value(), 42);
+}
+
+TEST(PoolAllocatorTest, ManyObjects) {
+    std::vector<pooled<int>> v;
+    for (int i = 0; i < 10000; ++i)
+        v.emplace_back(i);
+    for (int i = 0; i < 10000; ++i)
+        EXPECT_EQ(*v[i], i);
+}
+
+// --- Threads ---
+
+TEST(PoolAllocatorTest, ThreadExitReturnsBlocksToSharedList) {
+    using pool = beman::indirect::detail::fixed_pool<sizeof(Unique), alignof(Unique)>;
+
+    indirect_pool_allocator<Unique> alloc;
+    Unique*                         freed = nullptr;
+    std::thread([&] {
+        freed = alloc.allocate(1);
+        alloc.deallocate(freed, 1);
+    }).join();
+
+    // The first thread's whole cache is now on the shared list, so a fresh
+    // thread draining one slab's worth of blocks finds the freed one.
+    bool found = false;
+    std::thread([&] {
+        std::vector<Unique*> ps;
+        for (std::size_t i = 0; i < pool::slab_blocks; ++i) {
+            ps.push_back(alloc.allocate(1));
+            found = found || ps.back() == freed;
+        }
+        for (Unique* p : ps)
+            alloc.deallocate(p, 1);
+    }).join();
+    EXPECT_TRUE(found);
+}
+
+TEST(PoolAllocatorTest, CrossThreadDeallocation) {
+    constexpr int            n = 5000;
+    std::vector<pooled<int>> v;
+    for (int i = 0; i < n; ++i)
+        v.emplace_back(i);
+    std::thread([&] { v.clear(); }).join();
+
+    std::vector<pooled<int>> w;
+    for (int i = 0; i < n; ++i)
+        w.emplace_back(i);
+    for (int i = 0; i < n; ++i)
+        EXPECT_EQ(*w[i], i);
+}
+
+TEST(PoolAllocatorTest, ConcurrentAllocateAndFree) {
+    constexpr int            threads = 4;
+    constexpr int            rounds  = 200;
+    constexpr int            n       = 100;
+    std::atomic<int>         errors{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            std::vector<pooled<int>> v;
+            for (int r = 0; r < rounds; ++r) {
+                for (int i = 0; i < n; ++i)
+                    v.emplace_back(t * n + i);
+                for (int i = 0; i < n; ++i)
+                    if (*v[i] != t * n + i)
+                        ++errors;
+                v.clear();
+            }
+        });
+    }
+    for (auto& w : workers)
+        w.join();
+    EXPECT_EQ(errors.load(), 0);
+}
+
+} // namespace
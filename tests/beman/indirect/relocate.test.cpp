@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <beman/indirect/relocate.hpp>
+
+#include <beman/indirect/cow_indirect.hpp>
+#include <beman/indirect/indirect.hpp>
+#include <beman/indirect/polymorphic.hpp>
+#include <beman/indirect/small_polymorphic.hpp>
+
+#include "test_helpers.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace {
+
+using beman::indirect::cow_indirect;
+using beman::indirect::indirect;
+using beman::indirect::is_trivially_relocatable_v;
+using beman::indirect::polymorphic;
+using beman::indirect::relocate_at;
+using beman::indirect::small_polymorphic;
+using beman::indirect::uninitialized_relocate;
+
+struct Base {
+    virtual ~Base()              = default;
+    virtual int value() const    = 0;
+    Base()                       = default;
+    Base(const Base&)            = default;
+    Base(Base&&)                 = default;
+    Base& operator=(const Base&) = default;
+    Base& operator=(Base&&)      = default;
+};
+
+struct Derived : Base {
+    int x_;
+    explicit Derived(int x = 0) : x_(x) {}
+    int value() const override { return x_; }
+};
+
+// Counts moves so tests can tell a memcpy from a move-and-destroy loop.
+struct MoveCounter {
+    static inline int moves = 0;
+    int               v;
+    explicit MoveCounter(int x) : v(x) {}
+    MoveCounter(const MoveCounter&) = default;
+    MoveCounter(MoveCounter&& other) noexcept : v(other.v) { ++moves; }
+    ~MoveCounter() {}
+};
+
+// Uninitialized storage for N objects of type T.
+template <class T, std::size_t N>
+struct Storage {
+    alignas(T) unsigned char bytes[N * sizeof(T)];
+    T* data() { return std::launder(reinterpret_cast<T*>(bytes)); }
+};
+
+// --- Trait ---
+
+TEST(RelocateTest, TraitForLibraryTypes) {
+    static_assert(is_trivially_relocatable_v<int>);
+    static_assert(is_trivially_relocatable_v<indirect<std::string>>);
+    static_assert(is_trivially_relocatable_v<beman::indirect::pmr::indirect<std::string>>);
+    static_assert(is_trivially_relocatable_v<indirect<int, test::TrackingAllocator<int>>>);
+    static_assert(is_trivially_relocatable_v<polymorphic<Base>>);
+    static_assert(is_trivially_relocatable_v<beman::indirect::pmr::polymorphic<Base>>);
+    static_assert(is_trivially_relocatable_v<cow_indirect<std::string>>);
+    static_assert(!is_trivially_relocatable_v<small_polymorphic<Base, 32>>);
+    static_assert(!is_trivially_relocatable_v<MoveCounter>);
+}
+
+// --- uninitialized_relocate ---
+
+TEST(RelocateTest, UninitializedRelocateIndirect) {
+    unsigned alloc_counter   = 0;
+    unsigned dealloc_counter = 0;
+    using handle             = indirect<std::string, test::TrackingAllocator<std::string>>;
+    {
+        test::TrackingAllocator<std::string> alloc(&alloc_counter, &dealloc_counter);
+        Storage<handle, 4>                   src;
+        Storage<handle, 4>                   dst;
+        for (int i = 0; i < 4; ++i)
+            ::new (static_cast<void*>(src.data() + i)) handle(std::allocator_arg, alloc, std::to_string(i));
+
+        handle* end = uninitialized_relocate(src.data(), src.data() + 4, dst.data());
+        EXPECT_EQ(end, dst.data() + 4);
+        for (int i = 0; i < 4; ++i)
+            EXPECT_EQ(*dst.data()[i], std::to_string(i));
+        EXPECT_EQ(alloc_counter, 4u);
+        EXPECT_EQ(dealloc_counter, 0u);
+
+        std::destroy(dst.data(), end);
+    }
+    EXPECT_EQ(dealloc_counter, 4u);
+}
+
+TEST(RelocateTest, UninitializedRelocatePolymorphic) {
+    Storage<polymorphic<Base>, 3> src;
+    Storage<polymorphic<Base>, 3> dst;
+    const Base*                   addrs[3];
+    for (int i = 0; i < 3; ++i) {
+        auto* p  = ::new (static_cast<void*>(src.data() + i)) polymorphic<Base>(Derived(i));
+        addrs[i] = &**p;
+    }
+    uninitialized_relocate(src.data(), src.data() + 3, dst.data());
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(&*dst.data()[i], addrs[i]);
+        EXPECT_EQ(dst.data()[i]->value(), i);
+    }
+    std::destroy(dst.data(), dst.data() + 3);
+}
+
+TEST(RelocateTest, UninitializedRelocateNonTrivialMovesAndDestroys) {
+    MoveCounter::moves = 0;
+    Storage<MoveCounter, 3> src;
+    Storage<MoveCounter, 3> dst;
+    for (int i = 0; i < 3; ++i)
+        ::new (static_cast<void*>(src.data() + i)) MoveCounter(i);
+    uninitialized_relocate(src.data(), src.data() + 3, dst.data());
+    EXPECT_EQ(MoveCounter::moves, 3);
+    for (int i = 0; i < 3; ++i)
+        EXPECT_EQ(dst.data()[i].v, i);
+    std::destroy(dst.data(), dst.data() + 3);
+}
+
+TEST(RelocateTest, UninitializedRelocateEmptyRange) {
+    Storage<indirect<int>, 1> dst;
+    indirect<int>*            p = nullptr;
+    EXPECT_EQ(uninitialized_relocate(p, p, dst.data()), dst.data());
+}
+
+// --- relocate_at ---
+
+TEST(RelocateTest, RelocateAtIndirect) {
+    Storage<indirect<std::string>, 1> dst;
+    auto*                             src  = new indirect<std::string>(std::string("hello"));
+    const std::string*                addr = &**src;
+    indirect<std::string>*            r    = relocate_at(src, dst.data());
+    ::operator delete(static_cast<void*>(src));
+    EXPECT_EQ(&**r, addr);
+    EXPECT_EQ(**r, "hello");
+    std::destroy_at(r);
+}
+
+TEST(RelocateTest, RelocateAtNonTrivial) {
+    MoveCounter::moves = 0;
+    Storage<MoveCounter, 1> src;
+    Storage<MoveCounter, 1> dst;
+    ::new (static_cast<void*>(src.data())) MoveCounter(7);
+    MoveCounter* r = relocate_at(src.data(), dst.data());
+    EXPECT_EQ(MoveCounter::moves, 1);
+    EXPECT_EQ(r->v, 7);
+    std::destroy_at(r);
+}
+
+} // namespace
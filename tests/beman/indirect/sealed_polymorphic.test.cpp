@@ -0,0 +1,264 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <beman/indirect/sealed_polymorphic.hpp>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using beman::indirect::polymorphic_type_id;
+using beman::indirect::sealed_polymorphic;
+
+// Test hierarchy
+struct Shape {
+    virtual ~Shape()                  = default;
+    virtual int         sides() const = 0;
+    virtual std::string name() const  = 0;
+    Shape()                           = default;
+    Shape(const Shape&)               = default;
+    Shape(Shape&&)                    = default;
+    Shape& operator=(const Shape&)    = default;
+    Shape& operator=(Shape&&)         = default;
+};
+
+struct Triangle : Shape {
+    int         sides() const override { return 3; }
+    std::string name() const override { return "Triangle"; }
+};
+
+struct Square : Shape {
+    int side_;
+    explicit Square(int side = 1) : side_(side) {}
+    int         sides() const override { return 4; }
+    std::string name() const override { return "Square"; }
+};
+
+struct Polygon : Shape {
+    std::vector<int> lengths_;
+    Polygon(std::initializer_list<int> lengths) : lengths_(lengths) {}
+    int         sides() const override { return static_cast<int>(lengths_.size()); }
+    std::string name() const override { return "Polygon"; }
+};
+
+// Shape is not the first subobject, so the Shape* differs from the storage address.
+struct Padding {
+    virtual ~Padding() = default;
+    long pad_          = 7;
+};
+
+struct Labelled : Padding, Shape {
+    std::string label_;
+    explicit Labelled(std::string label) : label_(std::move(label)) {}
+    int         sides() const override { return 0; }
+    std::string name() const override { return label_; }
+};
+
+using shape = sealed_polymorphic<Shape, Triangle, Square, Polygon, Labelled>;
+
+static_assert(sizeof(shape) <= 2 * sizeof(void*) + sizeof(Labelled) + alignof(Labelled));
+static_assert(!std::is_default_constructible_v<sealed_polymorphic<Shape, Labelled>>);
+
+// --- Construction ---
+
+TEST(SealedPolymorphicTest, DefaultConstructsFirstAlternative) {
+    shape s;
+    EXPECT_EQ(s.index(), 0u);
+    EXPECT_EQ(s->name(), "Triangle");
+}
+
+TEST(SealedPolymorphicTest, ConstructionFromAlternative) {
+    shape s(Square(2));
+    EXPECT_EQ(s.index(), shape::index_of<Square>);
+    EXPECT_EQ(s->sides(), 4);
+}
+
+TEST(SealedPolymorphicTest, InPlaceConstruction) {
+    shape s(std::in_place_type<Polygon>, {1, 2, 3, 4, 5});
+    EXPECT_EQ(s->sides(), 5);
+
+    shape t(std::in_place_type<Labelled>, "hexagon");
+    EXPECT_EQ(t->name(), "hexagon");
+}
+
+TEST(SealedPolymorphicTest, StorageIsInline) {
+    shape       s(std::in_place_type<Labelled>, "x");
+    const auto* begin = reinterpret_cast<const unsigned char*>(&s);
+    const auto* obj   = reinterpret_cast<const unsigned char*>(&*s);
+    EXPECT_GE(obj, begin);
+    EXPECT_LT(obj, begin + sizeof(s));
+    EXPECT_NE(static_cast<const void*>(&*s), static_cast<const void*>(s.get_if<Labelled>()));
+}
+
+// --- Copy and move ---
+
+TEST(SealedPolymorphicTest, CopyIsDeep) {
+    shape s(std::in_place_type<Polygon>, {1, 2, 3});
+    shape t(s);
+    s.get_if<Polygon>()->lengths_.push_back(4);
+    EXPECT_EQ(s->sides(), 4);
+    EXPECT_EQ(t->sides(), 3);
+    EXPECT_EQ(t.index(), shape::index_of<Polygon>);
+}
+
+TEST(SealedPolymorphicTest, MoveLeavesSourceValueless) {
+    shape s(std::in_place_type<Labelled>, "moved");
+    shape t(std::move(s));
+    EXPECT_TRUE(s.valueless_after_move());
+    EXPECT_EQ(s.index(), shape::npos);
+    EXPECT_EQ(t->name(), "moved");
+
+    shape u(s);
+    EXPECT_TRUE(u.valueless_after_move());
+}
+
+TEST(SealedPolymorphicTest, CopyAssignment) {
+    shape s(Square(3));
+    shape t(Square(5));
+    t = s;
+    EXPECT_EQ(t.get_if<Square>()->side_, 3);
+
+    shape u(std::in_place_type<Labelled>, "label");
+    t = u;
+    EXPECT_EQ(t->name(), "label");
+    t = t;
+    EXPECT_EQ(t->name(), "label");
+
+    shape v(std::move(u));
+    t = u;
+    EXPECT_TRUE(t.valueless_after_move());
+}
+
+TEST(SealedPolymorphicTest, MoveAssignment) {
+    shape s(std::in_place_type<Polygon>, {1, 2});
+    shape t(Square(2));
+    t = std::move(s);
+    EXPECT_TRUE(s.valueless_after_move());
+    EXPECT_EQ(t->sides(), 2);
+
+    s = std::move(t);
+    EXPECT_TRUE(t.valueless_after_move());
+    EXPECT_EQ(s->name(), "Polygon");
+}
+
+TEST(SealedPolymorphicTest, Swap) {
+    shape s(Square(2));
+    shape t(std::in_place_type<Labelled>, "t");
+    swap(s, t);
+    EXPECT_EQ(s->name(), "t");
+    EXPECT_EQ(t->name(), "Square");
+
+    shape u(std::move(t));
+    s.swap(t);
+    EXPECT_TRUE(s.valueless_after_move());
+    EXPECT_EQ(t->name(), "t");
+}
+
+// --- Emplace ---
+
+TEST(SealedPolymorphicTest, EmplaceChangesAlternative) {
+    shape s;
+    Square& sq = s.emplace<Square>(7);
+    EXPECT_EQ(sq.side_, 7);
+    EXPECT_EQ(&sq, s.get_if<Square>());
+    s.emplace<Polygon>({1, 1, 1, 1, 1, 1});
+    EXPECT_EQ(s->sides(), 6);
+}
+
+// --- Dynamic type queries ---
+
+TEST(SealedPolymorphicTest, HoldsAndGetIf) {
+    shape s(Square(4));
+    EXPECT_TRUE(s.holds<Square>());
+    EXPECT_FALSE(s.holds<Triangle>());
+    EXPECT_NE(s.get_if<Square>(), nullptr);
+    EXPECT_EQ(s.get_if<Triangle>(), nullptr);
+
+    const shape& cs = s;
+    EXPECT_EQ(cs.get_if<Square>()->side_, 4);
+}
+
+TEST(SealedPolymorphicTest, TypeIdMatchesPolymorphic) {
+    shape                              s(Square(1));
+    beman::indirect::polymorphic<Shape> p(Square(1));
+    EXPECT_EQ(s.type_id(), polymorphic_type_id::of<Square>());
+    EXPECT_EQ(s.type_id(), p.type_id());
+
+    shape t(std::move(s));
+    EXPECT_EQ(s.type_id(), polymorphic_type_id());
+}
+
+// --- Visit ---
+
+TEST(SealedPolymorphicTest, VisitPassesConcreteType) {
+    std::vector<shape> shapes;
+    shapes.emplace_back();
+    shapes.emplace_back(Square(3));
+    shapes.emplace_back(std::in_place_type<Polygon>, std::initializer_list<int>{1, 2, 3, 4, 5});
+    shapes.emplace_back(std::in_place_type<Labelled>, "L");
+
+    struct Describe {
+        std::string operator()(const Triangle&) const { return "triangle"; }
+        std::string operator()(const Square& s) const { return "square " + std::to_string(s.side_); }
+        std::string operator()(const Polygon& p) const { return std::to_string(p.lengths_.size()) + "-gon"; }
+        std::string operator()(const Labelled& l) const { return "labelled " + l.label_; }
+    };
+
+    std::vector<std::string> names;
+    for (const auto& s : shapes)
+        names.push_back(s.visit(Describe{}));
+    EXPECT_EQ(names, (std::vector<std::string>{"triangle", "square 3", "5-gon", "labelled L"}));
+}
+
+TEST(SealedPolymorphicTest, VisitCanMutate) {
+    shape s(Square(3));
+    s.visit([](auto& u) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(u)>, Square>)
+            u.side_ = 9;
+    });
+    EXPECT_EQ(s.get_if<Square>()->side_, 9);
+}
+
+TEST(SealedPolymorphicTest, VisitManyAlternatives) {
+    // More alternatives than one level of the dispatch switch handles.
+    struct Base {
+        virtual ~Base()         = default;
+        virtual int get() const = 0;
+    };
+    struct Zero : Base {
+        int get() const override { return 0; }
+    };
+    struct A1 : Zero {};
+    struct A2 : Zero {};
+    struct A3 : Zero {};
+    struct A4 : Zero {};
+    struct A5 : Zero {};
+    struct A6 : Zero {};
+    struct A7 : Zero {};
+    struct A8 : Zero {};
+    struct A9 : Zero {};
+    struct A10 : Zero {};
+    struct A11 : Zero {};
+    struct A12 : Zero {};
+    struct A13 : Zero {};
+    struct A14 : Zero {};
+    struct A15 : Zero {};
+    struct A16 : Zero {};
+    struct A17 : Zero {};
+    using many =
+        sealed_polymorphic<Base, Zero, A1, A2, A3, A4, A5, A6, A7, A8, A9, A10, A11, A12, A13, A14, A15, A16, A17>;
+
+    many m(A17{});
+    EXPECT_EQ(m.index(), 17u);
+    EXPECT_TRUE(m.visit([](const auto& u) { return std::is_same_v<std::decay_t<decltype(u)>, A17>; }));
+    many n(m);
+    EXPECT_TRUE(n.holds<A17>());
+}
+
+} // namespace
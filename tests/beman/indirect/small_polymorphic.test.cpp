@@ -0,0 +1,348 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <beman/indirect/small_polymorphic.hpp>
+
+#include "test_helpers.hpp"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using beman::indirect::small_polymorphic;
+
+// Test hierarchy
+struct Base {
+    virtual ~Base()                   = default;
+    virtual int         value() const = 0;
+    virtual std::string name() const  = 0;
+    Base()                            = default;
+    Base(const Base&)                 = default;
+    Base(Base&&)                      = default;
+    Base& operator=(const Base&)      = default;
+    Base& operator=(Base&&)           = default;
+};
+
+struct Small : Base {
+    int x_;
+    explicit Small(int x = 0) : x_(x) {}
+    int         value() const override { return x_; }
+    std::string name() const override { return "Small"; }
+};
+
+struct Large : Base {
+    std::array<int, 64> data_{};
+    explicit Large(int x = 0) { data_[0] = x; }
+    int         value() const override { return data_[0]; }
+    std::string name() const override { return "Large"; }
+};
+
+// Small enough to fit, but may throw on move, so it must go to the heap.
+struct ThrowingMove : Base {
+    int x_;
+    explicit ThrowingMove(int x = 0) : x_(x) {}
+    ThrowingMove(const ThrowingMove&) = default;
+    ThrowingMove(ThrowingMove&& other) noexcept(false) : x_(other.x_) {}
+    int         value() const override { return x_; }
+    std::string name() const override { return "ThrowingMove"; }
+};
+
+// Base is not the first subobject, so the Base* differs from the buffer address.
+struct Padding {
+    virtual ~Padding() = default;
+    long pad_          = 7;
+};
+
+struct Offset : Padding, Base {
+    int x_;
+    explicit Offset(int x = 0) : x_(x) {}
+    int         value() const override { return x_; }
+    std::string name() const override { return "Offset"; }
+};
+
+constexpr std::size_t inline_size = 48;
+
+using handle          = small_polymorphic<Base, inline_size>;
+using tracking_handle = small_polymorphic<Base, inline_size, test::TrackingAllocator<Base>>;
+
+static_assert(beman::indirect::detail::fits_inline_v<Small, inline_size>);
+static_assert(!beman::indirect::detail::fits_inline_v<Large, inline_size>);
+static_assert(!beman::indirect::detail::fits_inline_v<ThrowingMove, inline_size>);
+
+// --- Construction ---
+
+TEST(SmallPolymorphicTest, SmallTypeIsInline) {
+    handle p(Small(42));
+    EXPECT_TRUE(p.is_inline());
+    EXPECT_EQ(p->value(), 42);
+    EXPECT_EQ(p->name(), "Small");
+}
+
+TEST(SmallPolymorphicTest, LargeTypeIsOnHeap) {
+    handle p(Large(42));
+    EXPECT_FALSE(p.is_inline());
+    EXPECT_EQ(p->value(), 42);
+    EXPECT_EQ(p->name(), "Large");
+}
+
+TEST(SmallPolymorphicTest, ThrowingMoveTypeIsOnHeap) {
+    handle p(ThrowingMove(42));
+    EXPECT_FALSE(p.is_inline());
+    EXPECT_EQ(p->value(), 42);
+}
+
+TEST(SmallPolymorphicTest, InPlaceTypeConstruction) {
+    handle p(std::in_place_type<Small>, 99);
+    EXPECT_TRUE(p.is_inline());
+    EXPECT_EQ((*p).value(), 99);
+}
+
+struct WithInitList : Base {
+    std::vector<int> data_;
+    WithInitList(std::initializer_list<int> il, int extra = 0) : data_(il) {
+        if (extra != 0)
+            data_.push_back(extra);
+    }
+    int         value() const override { return static_cast<int>(data_.size()); }
+    std::string name() const override { return "WithInitList"; }
+};
+
+TEST(SmallPolymorphicTest, InPlaceTypeConstructionInitializerList) {
+    handle p(std::in_place_type<WithInitList>, {1, 2, 3}, 4);
+    EXPECT_EQ(p->value(), 4);
+}
+
+// --- Copy/Move ---
+
+TEST(SmallPolymorphicTest, CopyInlinePreservesDynamicType) {
+    handle p(Small(42));
+    handle q(p);
+    EXPECT_TRUE(q.is_inline());
+    EXPECT_EQ(q->name(), "Small");
+    EXPECT_EQ(q->value(), 42);
+    EXPECT_NE(&*p, &*q);
+}
+
+TEST(SmallPolymorphicTest, CopyHeapPreservesDynamicType) {
+    handle p(Large(42));
+    handle q(p);
+    EXPECT_FALSE(q.is_inline());
+    EXPECT_EQ(q->name(), "Large");
+    EXPECT_EQ(q->value(), 42);
+    EXPECT_NE(&*p, &*q);
+}
+
+TEST(SmallPolymorphicTest, MoveInline) {
+    handle p(Small(42));
+    handle q(std::move(p));
+    EXPECT_TRUE(p.valueless_after_move());
+    EXPECT_TRUE(q.is_inline());
+    EXPECT_EQ(q->value(), 42);
+}
+
+TEST(SmallPolymorphicTest, MoveHeapKeepsObjectAddress) {
+    handle      p(Large(42));
+    const Base* addr = &*p;
+    handle      q(std::move(p));
+    EXPECT_TRUE(p.valueless_after_move());
+    EXPECT_EQ(&*q, addr);
+}
+
+TEST(SmallPolymorphicTest, MoveInlineWithBaseOffset) {
+    handle p(Offset(42));
+    ASSERT_TRUE(p.is_inline());
+    handle q(std::move(p));
+    EXPECT_EQ(q->value(), 42);
+    EXPECT_EQ(q->name(), "Offset");
+    handle r(q);
+    EXPECT_EQ(r->name(), "Offset");
+}
+
+TEST(SmallPolymorphicTest, CopyAssignmentAcrossStorageKinds) {
+    handle small(Small(1));
+    handle large(Large(2));
+    small = large;
+    EXPECT_FALSE(small.is_inline());
+    EXPECT_EQ(small->value(), 2);
+    large = handle(Small(3));
+    EXPECT_TRUE(large.is_inline());
+    EXPECT_EQ(large->value(), 3);
+}
+
+TEST(SmallPolymorphicTest, MoveAssignment) {
+    handle p(Small(42));
+    handle q(Large(0));
+    q = std::move(p);
+    EXPECT_TRUE(p.valueless_after_move());
+    EXPECT_EQ(q->value(), 42);
+}
+
+TEST(SmallPolymorphicTest, SelfAssignment) {
+    handle  p(Small(42));
+    handle& ref = p;
+    p           = ref;
+    EXPECT_EQ(p->value(), 42);
+    p = std::move(ref);
+    EXPECT_EQ(p->value(), 42);
+}
+
+struct ThrowsOnCopyDerived : Base {
+    int x_;
+    explicit ThrowsOnCopyDerived(int x = 0) : x_(x) {}
+    ThrowsOnCopyDerived(const ThrowsOnCopyDerived&) { throw test::ThrowsOnCopy::Exception{}; }
+    ThrowsOnCopyDerived(ThrowsOnCopyDerived&&) noexcept = default;
+    int         value() const override { return x_; }
+    std::string name() const override { return "ThrowsOnCopyDerived"; }
+};
+
+TEST(SmallPolymorphicTest, CopyAssignmentStrongGuarantee) {
+    handle p(ThrowsOnCopyDerived(1));
+    handle q(Small(2));
+    EXPECT_THROW(q = p, test::ThrowsOnCopy::Exception);
+    EXPECT_EQ(q->value(), 2);
+    EXPECT_EQ(q->name(), "Small");
+}
+
+// --- Swap ---
+
+TEST(SmallPolymorphicTest, SwapInlineAndHeap) {
+    handle a(Small(1));
+    handle b(Large(2));
+    swap(a, b);
+    EXPECT_FALSE(a.is_inline());
+    EXPECT_TRUE(b.is_inline());
+    EXPECT_EQ(a->value(), 2);
+    EXPECT_EQ(b->value(), 1);
+}
+
+TEST(SmallPolymorphicTest, SwapWithValueless) {
+    handle a(Small(42));
+    handle b(Small(0));
+    handle c(std::move(b));
+    a.swap(b);
+    EXPECT_TRUE(a.valueless_after_move());
+    EXPECT_EQ(b->value(), 42);
+}
+
+// --- Allocation tracking ---
+
+TEST(SmallPolymorphicTest, InlineDoesNotAllocate) {
+    unsigned alloc_counter   = 0;
+    unsigned dealloc_counter = 0;
+    {
+        test::TrackingAllocator<Base> alloc(&alloc_counter, &dealloc_counter);
+        tracking_handle               p(std::allocator_arg, alloc, Small(42));
+
+        auto q = p;
+        q      = p;
+        auto r = std::move(q);
+        EXPECT_EQ(r->value(), 42);
+    }
+    EXPECT_EQ(alloc_counter, 0u);
+    EXPECT_EQ(dealloc_counter, 0u);
+}
+
+TEST(SmallPolymorphicTest, HeapFallbackAllocatesOnce) {
+    unsigned alloc_counter   = 0;
+    unsigned dealloc_counter = 0;
+    {
+        test::TrackingAllocator<Base> alloc(&alloc_counter, &dealloc_counter);
+        tracking_handle               p(std::allocator_arg, alloc, Large(42));
+        EXPECT_EQ(alloc_counter, 1u);
+        auto q = std::move(p);
+        EXPECT_EQ(alloc_counter, 1u);
+    }
+    EXPECT_EQ(dealloc_counter, 1u);
+}
+
+TEST(SmallPolymorphicTest, MoveWithNonEqualAllocator) {
+    unsigned alloc_counter1   = 0;
+    unsigned dealloc_counter1 = 0;
+    unsigned alloc_counter2   = 0;
+    unsigned dealloc_counter2 = 0;
+
+    using alloc_type = test::NonEqualTrackingAllocator<Base>;
+    alloc_type alloc1(&alloc_counter1, &dealloc_counter1);
+    alloc_type alloc2(&alloc_counter2, &dealloc_counter2);
+
+    small_polymorphic<Base, inline_size, alloc_type> small(std::allocator_arg, alloc1, Small(1));
+    small_polymorphic<Base, inline_size, alloc_type> large(std::allocator_arg, alloc1, Large(2));
+
+    small_polymorphic<Base, inline_size, alloc_type> small2(std::allocator_arg, alloc2, std::move(small));
+    small_polymorphic<Base, inline_size, alloc_type> large2(std::allocator_arg, alloc2, std::move(large));
+    EXPECT_TRUE(small.valueless_after_move());
+    EXPECT_TRUE(large.valueless_after_move());
+    EXPECT_EQ(small2->value(), 1);
+    EXPECT_EQ(large2->value(), 2);
+    EXPECT_EQ(alloc_counter2, 1u);
+    EXPECT_EQ(dealloc_counter1, 1u);
+}
+
+// --- PMR ---
+
+struct PmrAwareBase {
+    virtual ~PmrAwareBase()                             = default;
+    virtual std::pmr::memory_resource* resource() const = 0;
+    PmrAwareBase()                                      = default;
+    PmrAwareBase(const PmrAwareBase&)                   = default;
+    PmrAwareBase(PmrAwareBase&&)                        = default;
+    PmrAwareBase& operator=(const PmrAwareBase&)        = default;
+    PmrAwareBase& operator=(PmrAwareBase&&)             = default;
+};
+
+struct PmrAwareDerived : PmrAwareBase {
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+    std::pmr::vector<int> data_;
+
+    PmrAwareDerived() : data_({1, 2, 3}) {}
+    PmrAwareDerived(const PmrAwareDerived&)            = default;
+    PmrAwareDerived(PmrAwareDerived&&) noexcept        = default;
+    PmrAwareDerived& operator=(const PmrAwareDerived&) = default;
+    PmrAwareDerived& operator=(PmrAwareDerived&&)      = default;
+
+    PmrAwareDerived(std::allocator_arg_t, const allocator_type& alloc) : data_({1, 2, 3}, alloc) {}
+    PmrAwareDerived(std::allocator_arg_t, const allocator_type& alloc, const PmrAwareDerived& other)
+        : data_(other.data_, alloc) {}
+    PmrAwareDerived(std::allocator_arg_t, const allocator_type& alloc, PmrAwareDerived&& other)
+        : data_(std::move(other.data_), alloc) {}
+
+    std::pmr::memory_resource* resource() const override { return data_.get_allocator().resource(); }
+};
+
+TEST(SmallPolymorphicTest, PmrPropagatesAllocatorToInlineObject) {
+    std::array<std::byte, 4096>                   buffer{};
+    std::pmr::monotonic_buffer_resource           resource(buffer.data(), buffer.size());
+    std::pmr::polymorphic_allocator<PmrAwareBase> alloc(&resource);
+
+    beman::indirect::pmr::small_polymorphic<PmrAwareBase, inline_size> p(std::allocator_arg, alloc, PmrAwareDerived());
+    ASSERT_TRUE(p.is_inline());
+    EXPECT_EQ(p->resource(), &resource);
+
+    beman::indirect::pmr::small_polymorphic<PmrAwareBase, inline_size> q(std::allocator_arg, alloc, p);
+    EXPECT_EQ(q->resource(), &resource);
+}
+
+// --- Container integration ---
+
+TEST(SmallPolymorphicTest, InteractionWithVector) {
+    std::vector<handle> v;
+    for (int i = 0; i < 16; ++i) {
+        if (i % 2 == 0)
+            v.emplace_back(Small(i));
+        else
+            v.emplace_back(Large(i));
+    }
+    auto copy = v;
+    for (int i = 0; i < 16; ++i) {
+        EXPECT_EQ(v[static_cast<std::size_t>(i)]->value(), i);
+        EXPECT_EQ(copy[static_cast<std::size_t>(i)]->value(), i);
+    }
+}
+
+} // namespace
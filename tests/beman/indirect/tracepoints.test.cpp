@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+
+#include <beman/indirect/detail/type_name.hpp>
+
+#include <beman/indirect/indirect.hpp>
+#include <beman/indirect/polymorphic.hpp>
+
+#include <gtest/gtest.h>
+
+#include <string_view>
+#include <utility>
+
+namespace {
+
+using beman::indirect::detail::fnv1a;
+using beman::indirect::detail::type_name;
+using beman::indirect::detail::type_name_hash_v;
+
+struct Base {
+    virtual ~Base() = default;
+};
+
+struct Derived : Base {
+    int v = 0;
+};
+
+namespace inner {
+template <class T>
+struct Box {};
+} // namespace inner
+
+// --- Type names and hashes carried by the probes ---
+
+TEST(TracepointsTest, TypeNameSpelling) {
+#if defined(__clang__) || defined(__GNUC__) || defined(_MSC_VER)
+    EXPECT_NE(type_name<Derived>().find("Derived"), std::string_view::npos);
+    EXPECT_NE(type_name<inner::Box<int>>().find("inner::Box<int>"), std::string_view::npos);
+#endif
+}
+
+TEST(TracepointsTest, TypeNameHash) {
+    static_assert(fnv1a("") == 14695981039346656037u);
+    static_assert(fnv1a("a") == 0xaf63dc4c8601ec8cu);
+    static_assert(type_name_hash_v<Derived> == fnv1a(type_name<Derived>()));
+    static_assert(type_name_hash_v<Derived> != type_name_hash_v<Base>);
+    static_assert(type_name_hash_v<inner::Box<int>> != type_name_hash_v<inner::Box<long>>);
+}
+
+// --- Probed paths ---
+
+// With BEMAN_INDIRECT_USE_TRACEPOINTS the probes are nops unless a tracer is
+// attached; every probed path still has to work.
+TEST(TracepointsTest, ProbedPathsRun) {
+    {
+        beman::indirect::indirect<int> a(1);
+        auto                           b = a;
+        EXPECT_EQ(*b, 1);
+    }
+    {
+        beman::indirect::polymorphic<Base> p(std::in_place_type<Derived>);
+        auto                               q = p;
+        auto                               r = std::move(q);
+        EXPECT_FALSE(r.valueless_after_move());
+    }
+}
+
+} // namespace